@@ -44,6 +44,7 @@ public class PNetworking : ModuleRules
                 "Engine",
                 "Slate",
                 "SlateCore",
+                "RenderCore",
             }
         );
 
@@ -0,0 +1,383 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#include "AvatarAtlas.h"
+#include "AvatarPipeline.h"
+#include "AvatarCache.h"
+#include "PNetworking.h"
+#include "Engine/Texture2D.h"
+
+FAvatarAtlas::FAvatarAtlas(TSharedPtr<FAvatarPipeline> InAvatarPipeline, const int32 InMaxPages)
+	: AvatarPipeline(InAvatarPipeline)
+	, MaxPages(FMath::Max(InMaxPages, 1))
+{
+}
+
+FAvatarAtlas::~FAvatarAtlas()
+{
+}
+
+bool FAvatarAtlas::RequestSlot(const CSteamID SteamID, const int32 AvatarHandle, const EAvatarSize AvatarSize, FOnAvatarAtlasSlotReady OnReady)
+{
+	check(IsInGameThread());
+
+	const uint64 SteamID64 = SteamID.ConvertToUint64();
+
+	if (FEntry* Entry = Entries.Find(SteamID64))
+	{
+		Entry->LastUsedFrame = GFrameCounter;
+
+		// Larger tier already uploaded: no need to downgrade the cell.
+		if (Entry->bIsUploaded && Entry->AvatarSize > AvatarSize)
+		{
+			OnReady.ExecuteIfBound(MakeSlot(SteamID64, *Entry));
+			return true;
+		}
+
+		if (Entry->AvatarHandle == AvatarHandle)
+		{
+			if (Entry->bIsUploaded)
+			{
+				OnReady.ExecuteIfBound(MakeSlot(SteamID64, *Entry));
+				return true;
+			}
+
+			WaitingSlots.FindOrAdd(SteamID64).Add(MoveTemp(OnReady));
+			return false;
+		}
+
+		// Avatar changed (or upgraded): same cell, new pixels.
+		Entry->AvatarHandle = AvatarHandle;
+		Entry->AvatarSize = AvatarSize;
+		Entry->bIsUploaded = false;
+		WaitingSlots.FindOrAdd(SteamID64).Add(MoveTemp(OnReady));
+		RequestEntryPixels(SteamID64, *Entry);
+		return false;
+	}
+
+	if (!AvatarPipeline.IsValid())
+	{
+		OnReady.ExecuteIfBound(FAvatarAtlasSlot());
+		return true;
+	}
+
+	FEntry NewEntry;
+	if (!AllocateCell(NewEntry.PageIndex, NewEntry.CellIndex))
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FAvatarAtlas: ERROR: No cell available!"));
+		OnReady.ExecuteIfBound(FAvatarAtlasSlot());
+		return true;
+	}
+
+	NewEntry.AvatarHandle = AvatarHandle;
+	NewEntry.AvatarSize = AvatarSize;
+	NewEntry.Width = 0;
+	NewEntry.Height = 0;
+	NewEntry.LastUsedFrame = GFrameCounter;
+	NewEntry.bIsUploaded = false;
+
+	Pages[NewEntry.PageIndex].Cells[NewEntry.CellIndex] = SteamID64;
+	Pages[NewEntry.PageIndex].NumUsed++;
+	Entries.Add(SteamID64, NewEntry);
+
+	WaitingSlots.FindOrAdd(SteamID64).Add(MoveTemp(OnReady));
+	RequestEntryPixels(SteamID64, NewEntry);
+	return false;
+}
+
+bool FAvatarAtlas::FindSlot(const uint64 SteamID, FAvatarAtlasSlot& OutSlot) const
+{
+	const FEntry* Entry = Entries.Find(SteamID);
+	if (!Entry || !Entry->bIsUploaded)
+	{
+		return false;
+	}
+
+	OutSlot = MakeSlot(SteamID, *Entry);
+	return true;
+}
+
+void FAvatarAtlas::Remove(const uint64 SteamID)
+{
+	FEntry RemovedEntry;
+	if (!Entries.RemoveAndCopyValue(SteamID, RemovedEntry))
+	{
+		return;
+	}
+
+	FreeCell(RemovedEntry.PageIndex, RemovedEntry.CellIndex);
+	FireWaiting(SteamID, FAvatarAtlasSlot());
+	Repack();
+}
+
+void FAvatarAtlas::Empty()
+{
+	Entries.Empty();
+	Pages.Empty();
+
+	TArray<uint64> WaitingSteamIDs;
+	WaitingSlots.GetKeys(WaitingSteamIDs);
+	for (const uint64 SteamID : WaitingSteamIDs)
+	{
+		FireWaiting(SteamID, FAvatarAtlasSlot());
+	}
+}
+
+int32 FAvatarAtlas::GetNumPages() const
+{
+	int32 NumPages = 0;
+	for (const FPage& Page : Pages)
+	{
+		NumPages += Page.Texture ? 1 : 0;
+	}
+	return NumPages;
+}
+
+int32 FAvatarAtlas::GetNumEntries() const
+{
+	return Entries.Num();
+}
+
+void FAvatarAtlas::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	for (FPage& Page : Pages)
+	{
+		Collector.AddReferencedObject(Page.Texture);
+	}
+}
+
+FString FAvatarAtlas::GetReferencerName() const
+{
+	return TEXT("FAvatarAtlas");
+}
+
+bool FAvatarAtlas::AllocateCell(int32& OutPageIndex, int32& OutCellIndex, const int32 ExcludedPageIndex)
+{
+	for (int32 PageIndex = 0; PageIndex < Pages.Num(); PageIndex++)
+	{
+		FPage& Page = Pages[PageIndex];
+		if (PageIndex == ExcludedPageIndex || !Page.Texture || Page.NumUsed >= Page.Cells.Num())
+		{
+			continue;
+		}
+
+		OutPageIndex = PageIndex;
+		OutCellIndex = Page.Cells.IndexOfByKey(0);
+		return OutCellIndex != INDEX_NONE;
+	}
+
+	if (GetNumPages() < MaxPages)
+	{
+		OutPageIndex = CreatePage();
+		OutCellIndex = 0;
+		return OutPageIndex != INDEX_NONE;
+	}
+
+	// Atlas is full: reuse the cell of the least recently used avatar.
+	uint64 EvictedSteamID = 0;
+	uint64 OldestFrame = MAX_uint64;
+	for (const TPair<uint64, FEntry>& Pair : Entries)
+	{
+		if (Pair.Value.bIsUploaded && Pair.Value.PageIndex != ExcludedPageIndex && Pair.Value.LastUsedFrame < OldestFrame)
+		{
+			OldestFrame = Pair.Value.LastUsedFrame;
+			EvictedSteamID = Pair.Key;
+		}
+	}
+
+	FEntry EvictedEntry;
+	if (EvictedSteamID == 0 || !Entries.RemoveAndCopyValue(EvictedSteamID, EvictedEntry))
+	{
+		return false;
+	}
+
+	UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("FAvatarAtlas: Evicting avatar of SteamID %llu"), EvictedSteamID);
+	FreeCell(EvictedEntry.PageIndex, EvictedEntry.CellIndex);
+
+	// Slots already given for this SteamID would sample the next avatar written in the cell.
+	OnEvicted.Broadcast(EvictedSteamID);
+
+	OutPageIndex = EvictedEntry.PageIndex;
+	OutCellIndex = EvictedEntry.CellIndex;
+	return true;
+}
+
+int32 FAvatarAtlas::CreatePage()
+{
+	UTexture2D* PageTexture = UTexture2D::CreateTransient(AVATAR_ATLAS_PAGE_SIZE, AVATAR_ATLAS_PAGE_SIZE, EPixelFormat::PF_R8G8B8A8);
+	if (!PageTexture)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FAvatarAtlas: ERROR: Invalid Page Texture!"));
+		return INDEX_NONE;
+	}
+
+	// Padding and cells not written yet are sampled by bilinear filtering: they must not hold garbage.
+	FTexture2DMipMap& Mip = PageTexture->GetPlatformData()->Mips[0];
+	FMemory::Memzero(Mip.BulkData.Lock(LOCK_READ_WRITE), Mip.BulkData.GetBulkDataSize());
+	Mip.BulkData.Unlock();
+
+	PageTexture->UpdateResource();
+
+	// Reuse a released page index, so indexes of other entries are stable.
+	int32 PageIndex = Pages.IndexOfByPredicate([](const FPage& Page) { return Page.Texture == nullptr; });
+	if (PageIndex == INDEX_NONE)
+	{
+		PageIndex = Pages.AddDefaulted();
+	}
+
+	FPage& Page = Pages[PageIndex];
+	Page.Texture = PageTexture;
+	Page.Cells.Init(0, GetCellsPerPage());
+	Page.NumUsed = 0;
+
+	return PageIndex;
+}
+
+void FAvatarAtlas::RequestEntryPixels(const uint64 SteamID, const FEntry& Entry)
+{
+	AvatarPipeline->RequestPixels(CSteamID(SteamID), Entry.AvatarHandle, Entry.AvatarSize, FOnAvatarPixelsReady::CreateSP(this, &FAvatarAtlas::OnPixelsReady));
+}
+
+void FAvatarAtlas::OnPixelsReady(FAvatarPixels& Pixels)
+{
+	FEntry* Entry = Entries.Find(Pixels.SteamID);
+
+	// Evicted, removed or changed again while pixels were fetched.
+	if (!Entry || Entry->AvatarHandle != Pixels.AvatarHandle)
+	{
+		return;
+	}
+
+	if (Pixels.RGBA.Num() == 0 || Pixels.Width > AVATAR_ATLAS_CELL_SIZE || Pixels.Height > AVATAR_ATLAS_CELL_SIZE)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FAvatarAtlas: ERROR: Invalid pixels for SteamID %llu"), Pixels.SteamID);
+		Remove(Pixels.SteamID);
+		return;
+	}
+
+	FPage& Page = Pages[Entry->PageIndex];
+	const int32 Stride = AVATAR_ATLAS_CELL_SIZE + AVATAR_ATLAS_CELL_PADDING;
+	const uint32 DestX = (Entry->CellIndex % GetCellsPerRow()) * Stride;
+	const uint32 DestY = (Entry->CellIndex / GetCellsPerRow()) * Stride;
+
+	// Pixels and region are owned by RenderThread until the upload is done.
+	TArray<uint8>* UploadData = new TArray<uint8>(MoveTemp(Pixels.RGBA));
+	FUpdateTextureRegion2D* UploadRegion = new FUpdateTextureRegion2D(DestX, DestY, 0, 0, Pixels.Width, Pixels.Height);
+
+	Page.Texture->UpdateTextureRegions(0, 1, UploadRegion, Pixels.Width * 4, 4, UploadData->GetData(),
+		[UploadData](uint8* SrcData, const FUpdateTextureRegion2D* Regions)
+		{
+			delete UploadData;
+			delete Regions;
+		}
+	);
+
+	Entry->Width = Pixels.Width;
+	Entry->Height = Pixels.Height;
+	Entry->bIsUploaded = true;
+
+	FireWaiting(Pixels.SteamID, MakeSlot(Pixels.SteamID, *Entry));
+}
+
+void FAvatarAtlas::Repack()
+{
+	const int32 NumPages = GetNumPages();
+	if (NumPages <= 1 || Entries.Num() > (NumPages - 1) * GetCellsPerPage())
+	{
+		return;
+	}
+
+	int32 SourcePageIndex = INDEX_NONE;
+	for (int32 PageIndex = 0; PageIndex < Pages.Num(); PageIndex++)
+	{
+		if (Pages[PageIndex].Texture && (SourcePageIndex == INDEX_NONE || Pages[PageIndex].NumUsed < Pages[SourcePageIndex].NumUsed))
+		{
+			SourcePageIndex = PageIndex;
+		}
+	}
+
+	// Pixels are fetched again from SteamAPI: no CPU copy of the atlas is kept.
+	for (int32 CellIndex = 0; CellIndex < Pages[SourcePageIndex].Cells.Num(); CellIndex++)
+	{
+		const uint64 SteamID = Pages[SourcePageIndex].Cells[CellIndex];
+		FEntry* Entry = SteamID != 0 ? Entries.Find(SteamID) : nullptr;
+		if (!Entry)
+		{
+			continue;
+		}
+
+		int32 NewPageIndex = INDEX_NONE;
+		int32 NewCellIndex = INDEX_NONE;
+		if (!AllocateCell(NewPageIndex, NewCellIndex, SourcePageIndex))
+		{
+			continue;
+		}
+
+		Pages[NewPageIndex].Cells[NewCellIndex] = SteamID;
+		Pages[NewPageIndex].NumUsed++;
+
+		Entry->PageIndex = NewPageIndex;
+		Entry->CellIndex = NewCellIndex;
+		Entry->bIsUploaded = false;
+		RequestEntryPixels(SteamID, *Entry);
+	}
+
+	UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("FAvatarAtlas: Repacked, releasing page %d"), SourcePageIndex);
+
+	FPage& SourcePage = Pages[SourcePageIndex];
+	SourcePage.Texture = nullptr;
+	SourcePage.Cells.Empty();
+	SourcePage.NumUsed = 0;
+
+	OnRepacked.Broadcast();
+}
+
+void FAvatarAtlas::FreeCell(const int32 PageIndex, const int32 CellIndex)
+{
+	if (!Pages.IsValidIndex(PageIndex) || !Pages[PageIndex].Cells.IsValidIndex(CellIndex))
+	{
+		return;
+	}
+
+	Pages[PageIndex].Cells[CellIndex] = 0;
+	Pages[PageIndex].NumUsed--;
+}
+
+void FAvatarAtlas::FireWaiting(const uint64 SteamID, const FAvatarAtlasSlot& Slot)
+{
+	TArray<FOnAvatarAtlasSlotReady> Callbacks;
+	if (!WaitingSlots.RemoveAndCopyValue(SteamID, Callbacks))
+	{
+		return;
+	}
+
+	for (FOnAvatarAtlasSlotReady& Callback : Callbacks)
+	{
+		Callback.ExecuteIfBound(Slot);
+	}
+}
+
+FAvatarAtlasSlot FAvatarAtlas::MakeSlot(const uint64 SteamID, const FEntry& Entry) const
+{
+	const int32 Stride = AVATAR_ATLAS_CELL_SIZE + AVATAR_ATLAS_CELL_PADDING;
+	const FVector2D Origin((Entry.CellIndex % GetCellsPerRow()) * Stride, (Entry.CellIndex / GetCellsPerRow()) * Stride);
+
+	// Half texel inset, so bilinear sampling never reads neighbour cells.
+	FAvatarAtlasSlot Slot;
+	Slot.SteamID = static_cast<int32>(CSteamID(SteamID).GetAccountID());
+	Slot.AtlasPage = Pages[Entry.PageIndex].Texture;
+	Slot.UVMin = (Origin + FVector2D(0.5f)) / AVATAR_ATLAS_PAGE_SIZE;
+	Slot.UVMax = (Origin + FVector2D(Entry.Width, Entry.Height) - FVector2D(0.5f)) / AVATAR_ATLAS_PAGE_SIZE;
+	return Slot;
+}
+
+int32 FAvatarAtlas::GetCellsPerRow()
+{
+	return AVATAR_ATLAS_PAGE_SIZE / (AVATAR_ATLAS_CELL_SIZE + AVATAR_ATLAS_CELL_PADDING);
+}
+
+int32 FAvatarAtlas::GetCellsPerPage()
+{
+	return GetCellsPerRow() * GetCellsPerRow();
+}
@@ -0,0 +1,162 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#include "AvatarBlockEncoder.h"
+#include "AvatarCache.h"
+#include "PNetworking.h"
+#include "Async/ParallelFor.h"
+#include "Engine/Texture2D.h"
+#include "HAL/IConsoleManager.h"
+#include "RenderingThread.h"
+
+/*
+	Console command comparing uncompressed RGBA avatars with BC1/BC3 ones:
+	worker encode time (BC only, RGBA has none), GameThread + RenderThread upload time, size of the uploaded pixel data
+	and GPU resident size of the created textures.
+	Usage: PNetworking.AvatarBenchmark [AlphaAvatars 0/1]. Runs with 100, 500 and 2000 large avatars.
+*/
+namespace AvatarBenchmark
+{
+	// Avatar like pixels: smooth gradients with some noise, optionally with a round alpha mask.
+	static void MakeAvatar(const int32 Seed, const bool bWithAlpha, TArray<uint8>& OutRGBA)
+	{
+		const int32 Size = AVATAR_LARGE_PIXEL_SIZE;
+		FRandomStream Random(Seed);
+		const int32 BaseColor[3] = { Random.RandRange(0, 255), Random.RandRange(0, 255), Random.RandRange(0, 255) };
+
+		OutRGBA.SetNumUninitialized(Size * Size * 4);
+		for (int32 Y = 0; Y < Size; Y++)
+		{
+			for (int32 X = 0; X < Size; X++)
+			{
+				uint8* Pixel = OutRGBA.GetData() + (Y * Size + X) * 4;
+				Pixel[0] = static_cast<uint8>((BaseColor[0] + X + Random.RandRange(0, 8)) & 0xFF);
+				Pixel[1] = static_cast<uint8>((BaseColor[1] + Y + Random.RandRange(0, 8)) & 0xFF);
+				Pixel[2] = static_cast<uint8>((BaseColor[2] + (X + Y) / 2) & 0xFF);
+
+				const float Distance = FVector2f(X - Size * 0.5f, Y - Size * 0.5f).Size();
+				Pixel[3] = bWithAlpha ? static_cast<uint8>(FMath::Clamp((Size * 0.5f - Distance) * 64.f, 0.f, 255.f)) : 255;
+			}
+		}
+	}
+
+	// Create textures and upload data, waiting for RenderThread. Returns seconds.
+	static double Upload(const TArray<TArray<uint8>>& Data, const EPixelFormat PixelFormat, const uint32 SrcPitch, const uint32 SrcBpp, TArray<UTexture2D*>& OutTextures)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+
+		for (const TArray<uint8>& AvatarData : Data)
+		{
+			UTexture2D* Texture = UTexture2D::CreateTransient(AVATAR_LARGE_PIXEL_SIZE, AVATAR_LARGE_PIXEL_SIZE, PixelFormat);
+			if (!Texture)
+			{
+				continue;
+			}
+
+			Texture->UpdateResource();
+
+			FUpdateTextureRegion2D* UploadRegion = new FUpdateTextureRegion2D(0, 0, 0, 0, AVATAR_LARGE_PIXEL_SIZE, AVATAR_LARGE_PIXEL_SIZE);
+			Texture->UpdateTextureRegions(0, 1, UploadRegion, SrcPitch, SrcBpp, const_cast<uint8*>(AvatarData.GetData()),
+				[](uint8* SrcData, const FUpdateTextureRegion2D* Regions)
+				{
+					delete Regions;
+				});
+
+			OutTextures.Add(Texture);
+		}
+
+		FlushRenderingCommands();
+		return FPlatformTime::Seconds() - StartTime;
+	}
+
+	// Memory the RHI resources of the textures take on GPU, mips included.
+	static int64 GetResidentBytes(const TArray<UTexture2D*>& Textures)
+	{
+		int64 ResidentBytes = 0;
+		for (const UTexture2D* Texture : Textures)
+		{
+			ResidentBytes += Texture->CalcTextureMemorySizeEnum(TMC_ResidentMips);
+		}
+		return ResidentBytes;
+	}
+
+	static void Run(const int32 NumAvatars, const bool bWithAlpha)
+	{
+		TArray<TArray<uint8>> RGBA;
+		RGBA.SetNum(NumAvatars);
+		ParallelFor(NumAvatars, [&RGBA, bWithAlpha](const int32 Index) { MakeAvatar(Index, bWithAlpha, RGBA[Index]); });
+
+		// Same worker threads the pipeline uses, one avatar per task.
+		TArray<TArray<uint8>> Encoded;
+		Encoded.SetNum(NumAvatars);
+		TArray<EPixelFormat> Formats;
+		Formats.SetNum(NumAvatars);
+
+		const double EncodeStartTime = FPlatformTime::Seconds();
+		ParallelFor(NumAvatars, [&RGBA, &Encoded, &Formats](const int32 Index)
+			{
+				Formats[Index] = FAvatarBlockEncoder::Encode(RGBA[Index], AVATAR_LARGE_PIXEL_SIZE, AVATAR_LARGE_PIXEL_SIZE, Encoded[Index]);
+			});
+		const double EncodeTime = FPlatformTime::Seconds() - EncodeStartTime;
+
+		const EPixelFormat EncodedFormat = Formats.Num() > 0 ? Formats[0] : PF_Unknown;
+		if (EncodedFormat == PF_Unknown)
+		{
+			UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("AvatarBenchmark: ERROR: Encoding failed!"));
+			return;
+		}
+
+		TArray<UTexture2D*> RGBATextures;
+		const double RGBAUploadTime = Upload(RGBA, PF_R8G8B8A8, AVATAR_LARGE_PIXEL_SIZE * 4, 4, RGBATextures);
+
+		TArray<UTexture2D*> EncodedTextures;
+		const double EncodedUploadTime = Upload(Encoded, EncodedFormat, FAvatarBlockEncoder::GetBlockRowPitch(AVATAR_LARGE_PIXEL_SIZE, EncodedFormat), FAvatarBlockEncoder::GetBlockBytes(EncodedFormat), EncodedTextures);
+
+		int64 RGBABytes = 0;
+		for (const TArray<uint8>& AvatarData : RGBA)
+		{
+			RGBABytes += AvatarData.Num();
+		}
+
+		int64 EncodedBytes = 0;
+		for (const TArray<uint8>& AvatarData : Encoded)
+		{
+			EncodedBytes += AvatarData.Num();
+		}
+
+		const int64 RGBAResidentBytes = GetResidentBytes(RGBATextures);
+		const int64 EncodedResidentBytes = GetResidentBytes(EncodedTextures);
+
+		UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("AvatarBenchmark: %d avatars %s"), NumAvatars, GPixelFormats[EncodedFormat].Name);
+		UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("    RGBA:    upload %.2f ms, CPU bytes %.2f MB, GPU resident %.2f MB"),
+			RGBAUploadTime * 1000.0, RGBABytes / (1024.0 * 1024.0), RGBAResidentBytes / (1024.0 * 1024.0));
+		UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("    Encoded: encode %.2f ms, upload %.2f ms, CPU bytes %.2f MB, GPU resident %.2f MB"),
+			EncodeTime * 1000.0, EncodedUploadTime * 1000.0, EncodedBytes / (1024.0 * 1024.0), EncodedResidentBytes / (1024.0 * 1024.0));
+
+		// Transient textures are left to the Garbage Collector.
+		for (UTexture2D* Texture : RGBATextures)
+		{
+			Texture->ReleaseResource();
+		}
+
+		for (UTexture2D* Texture : EncodedTextures)
+		{
+			Texture->ReleaseResource();
+		}
+	}
+}
+
+static FAutoConsoleCommand AvatarBenchmarkCommand(
+	TEXT("PNetworking.AvatarBenchmark"),
+	TEXT("Compare RGBA and BC1/BC3 avatars encode time, upload time, CPU pixel bytes and GPU resident size. Args: [AlphaAvatars 0/1]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic([](const TArray<FString>& Args)
+		{
+			const bool bWithAlpha = Args.Num() > 0 && FCString::Atoi(*Args[0]) != 0;
+
+			static const int32 NumAvatarsToTest[] = { 100, 500, 2000 };
+			for (const int32 NumAvatars : NumAvatarsToTest)
+			{
+				AvatarBenchmark::Run(NumAvatars, bWithAlpha);
+			}
+		}));
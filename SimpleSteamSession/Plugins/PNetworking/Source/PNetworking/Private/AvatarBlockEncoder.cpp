@@ -0,0 +1,224 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#include "AvatarBlockEncoder.h"
+
+bool FAvatarBlockEncoder::IsOpaque(const TArray<uint8>& RGBA)
+{
+	for (int32 Index = 3; Index < RGBA.Num(); Index += 4)
+	{
+		if (RGBA[Index] != 255)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+EPixelFormat FAvatarBlockEncoder::Encode(const TArray<uint8>& RGBA, const uint32 Width, const uint32 Height, TArray<uint8>& OutBlocks)
+{
+	if (Width == 0 || Height == 0 || Width % 4 != 0 || Height % 4 != 0 || RGBA.Num() != static_cast<int32>(Width * Height * 4))
+	{
+		return PF_Unknown;
+	}
+
+	const EPixelFormat PixelFormat = IsOpaque(RGBA) ? PF_DXT1 : PF_DXT5;
+	const uint32 BlockBytes = GetBlockBytes(PixelFormat);
+	const uint32 BlocksX = Width / 4;
+	const uint32 BlocksY = Height / 4;
+
+	OutBlocks.SetNumUninitialized(BlocksX * BlocksY * BlockBytes);
+
+	FBlockPixels Pixels;
+	uint8* OutBlock = OutBlocks.GetData();
+
+	for (uint32 BlockY = 0; BlockY < BlocksY; BlockY++)
+	{
+		for (uint32 BlockX = 0; BlockX < BlocksX; BlockX++)
+		{
+			LoadBlock(RGBA.GetData(), Width, BlockX, BlockY, Pixels);
+
+			if (PixelFormat == PF_DXT5)
+			{
+				EncodeAlphaBlock(Pixels, OutBlock);
+				EncodeColorBlock(Pixels, OutBlock + 8);
+			}
+			else
+			{
+				EncodeColorBlock(Pixels, OutBlock);
+			}
+
+			OutBlock += BlockBytes;
+		}
+	}
+
+	return PixelFormat;
+}
+
+uint32 FAvatarBlockEncoder::GetBlockBytes(const EPixelFormat PixelFormat)
+{
+	return PixelFormat == PF_DXT1 ? 8 : 16;
+}
+
+uint32 FAvatarBlockEncoder::GetBlockRowPitch(const uint32 Width, const EPixelFormat PixelFormat)
+{
+	return (Width / 4) * GetBlockBytes(PixelFormat);
+}
+
+void FAvatarBlockEncoder::LoadBlock(const uint8* RGBA, const uint32 Width, const uint32 BlockX, const uint32 BlockY, FBlockPixels& OutPixels)
+{
+	VectorRegister4Float Min = VectorSetFloat1(255.f);
+	VectorRegister4Float Max = VectorZeroFloat();
+
+	for (uint32 Row = 0; Row < 4; Row++)
+	{
+		const uint8* SrcRow = RGBA + ((BlockY * 4 + Row) * Width + BlockX * 4) * 4;
+
+		// One RGBA pixel per register: bounds of every channel at once.
+		const VectorRegister4Float Pixel0 = VectorLoadByte4(SrcRow);
+		const VectorRegister4Float Pixel1 = VectorLoadByte4(SrcRow + 4);
+		const VectorRegister4Float Pixel2 = VectorLoadByte4(SrcRow + 8);
+		const VectorRegister4Float Pixel3 = VectorLoadByte4(SrcRow + 12);
+
+		Min = VectorMin(Min, VectorMin(VectorMin(Pixel0, Pixel1), VectorMin(Pixel2, Pixel3)));
+		Max = VectorMax(Max, VectorMax(VectorMax(Pixel0, Pixel1), VectorMax(Pixel2, Pixel3)));
+
+		// Transpose: one channel of the 4 pixels per register, for the index search.
+		const VectorRegister4Float RG01 = VectorShuffle(Pixel0, Pixel1, 0, 1, 0, 1);
+		const VectorRegister4Float RG23 = VectorShuffle(Pixel2, Pixel3, 0, 1, 0, 1);
+		const VectorRegister4Float BA01 = VectorShuffle(Pixel0, Pixel1, 2, 3, 2, 3);
+		const VectorRegister4Float BA23 = VectorShuffle(Pixel2, Pixel3, 2, 3, 2, 3);
+
+		OutPixels.R[Row] = VectorShuffle(RG01, RG23, 0, 2, 0, 2);
+		OutPixels.G[Row] = VectorShuffle(RG01, RG23, 1, 3, 1, 3);
+		OutPixels.B[Row] = VectorShuffle(BA01, BA23, 0, 2, 0, 2);
+		OutPixels.A[Row] = VectorShuffle(BA01, BA23, 1, 3, 1, 3);
+	}
+
+	VectorIntStore(VectorFloatToInt(Min), OutPixels.Min);
+	VectorIntStore(VectorFloatToInt(Max), OutPixels.Max);
+}
+
+void FAvatarBlockEncoder::EncodeColorBlock(const FBlockPixels& Pixels, uint8* OutBlock)
+{
+	int32 Min[3] = { Pixels.Min[0], Pixels.Min[1], Pixels.Min[2] };
+	int32 Max[3] = { Pixels.Max[0], Pixels.Max[1], Pixels.Max[2] };
+
+	// Inset the bounding box by 1/16 of its size: endpoints are rarely the extreme pixels.
+	for (int32 Channel = 0; Channel < 3; Channel++)
+	{
+		const int32 Inset = (Max[Channel] - Min[Channel]) >> 4;
+		Min[Channel] = FMath::Min(Min[Channel] + Inset, 255);
+		Max[Channel] = FMath::Max(Max[Channel] - Inset, 0);
+	}
+
+	const uint16 Color0 = PackRGB565(Max[0], Max[1], Max[2]);
+	const uint16 Color1 = PackRGB565(Min[0], Min[1], Min[2]);
+
+	uint32 Indices = 0;
+
+	// Color0 > Color1 selects the 4 colors mode. Equal colors: every index 0 is correct.
+	if (Color0 != Color1)
+	{
+		// Endpoints as decoded by the GPU.
+		const int32 End0[3] = { ((Color0 >> 11) & 31) * 255 / 31, ((Color0 >> 5) & 63) * 255 / 63, (Color0 & 31) * 255 / 31 };
+		const int32 End1[3] = { ((Color1 >> 11) & 31) * 255 / 31, ((Color1 >> 5) & 63) * 255 / 63, (Color1 & 31) * 255 / 31 };
+		const int32 Axis[3] = { End0[0] - End1[0], End0[1] - End1[1], End0[2] - End1[2] };
+		const int32 AxisLengthSquared = FMath::Max(Axis[0] * Axis[0] + Axis[1] * Axis[1] + Axis[2] * Axis[2], 1);
+
+		// Position along the axis (0 = Color1, 3 = Color0) to BC1 index.
+		static const uint32 LevelToIndex[4] = { 1, 3, 2, 0 };
+
+		const VectorRegister4Float End1R = VectorSetFloat1(static_cast<float>(End1[0]));
+		const VectorRegister4Float End1G = VectorSetFloat1(static_cast<float>(End1[1]));
+		const VectorRegister4Float End1B = VectorSetFloat1(static_cast<float>(End1[2]));
+		const VectorRegister4Float AxisR = VectorSetFloat1(static_cast<float>(Axis[0]));
+		const VectorRegister4Float AxisG = VectorSetFloat1(static_cast<float>(Axis[1]));
+		const VectorRegister4Float AxisB = VectorSetFloat1(static_cast<float>(Axis[2]));
+		const VectorRegister4Float Three = VectorSetFloat1(3.f);
+		const VectorRegister4Float HalfLength = VectorSetFloat1(static_cast<float>(AxisLengthSquared / 2));
+		const VectorRegister4Float Length = VectorSetFloat1(static_cast<float>(AxisLengthSquared));
+		const VectorRegister4Int MinLevel = VectorIntSet1(0);
+		const VectorRegister4Int MaxLevel = VectorIntSet1(3);
+
+		for (int32 Row = 0; Row < 4; Row++)
+		{
+			// Projection of 4 pixels at once. Values are integers well below 2^24: exact in float.
+			VectorRegister4Float Projection = VectorMultiply(VectorSubtract(Pixels.R[Row], End1R), AxisR);
+			Projection = VectorMultiplyAdd(VectorSubtract(Pixels.G[Row], End1G), AxisG, Projection);
+			Projection = VectorMultiplyAdd(VectorSubtract(Pixels.B[Row], End1B), AxisB, Projection);
+
+			// Truncated like an integer division, then clamped.
+			const VectorRegister4Float Scaled = VectorDivide(VectorMultiplyAdd(Projection, Three, HalfLength), Length);
+			const VectorRegister4Int Levels = VectorIntMin(VectorIntMax(VectorFloatToInt(Scaled), MinLevel), MaxLevel);
+
+			int32 RowLevels[4];
+			VectorIntStore(Levels, RowLevels);
+			for (int32 Column = 0; Column < 4; Column++)
+			{
+				Indices |= LevelToIndex[RowLevels[Column]] << ((Row * 4 + Column) * 2);
+			}
+		}
+	}
+
+	OutBlock[0] = Color0 & 0xFF;
+	OutBlock[1] = Color0 >> 8;
+	OutBlock[2] = Color1 & 0xFF;
+	OutBlock[3] = Color1 >> 8;
+	OutBlock[4] = Indices & 0xFF;
+	OutBlock[5] = (Indices >> 8) & 0xFF;
+	OutBlock[6] = (Indices >> 16) & 0xFF;
+	OutBlock[7] = (Indices >> 24) & 0xFF;
+}
+
+void FAvatarBlockEncoder::EncodeAlphaBlock(const FBlockPixels& Pixels, uint8* OutBlock)
+{
+	const int32 MinAlpha = Pixels.Min[3];
+	const int32 MaxAlpha = Pixels.Max[3];
+
+	uint64 Indices = 0;
+
+	// Alpha0 > Alpha1 selects the 8 values mode. Equal values: every index 0 is correct.
+	if (MaxAlpha != MinAlpha)
+	{
+		const int32 Range = MaxAlpha - MinAlpha;
+
+		const VectorRegister4Float MinAlphaV = VectorSetFloat1(static_cast<float>(MinAlpha));
+		const VectorRegister4Float Seven = VectorSetFloat1(7.f);
+		const VectorRegister4Float HalfRange = VectorSetFloat1(static_cast<float>(Range / 2));
+		const VectorRegister4Float RangeV = VectorSetFloat1(static_cast<float>(Range));
+
+		for (int32 Row = 0; Row < 4; Row++)
+		{
+			// Level of 4 pixels at once, truncated like an integer division. Always in 0..7.
+			const VectorRegister4Float Scaled = VectorDivide(VectorMultiplyAdd(VectorSubtract(Pixels.A[Row], MinAlphaV), Seven, HalfRange), RangeV);
+
+			int32 RowLevels[4];
+			VectorIntStore(VectorFloatToInt(Scaled), RowLevels);
+			for (int32 Column = 0; Column < 4; Column++)
+			{
+				// Position between Alpha1 (0) and Alpha0 (7) to BC3 index: 0 is Alpha0, 1 is Alpha1, 2..7 go from Alpha0 to Alpha1.
+				const int32 Level = RowLevels[Column];
+				const uint64 Index = Level == 7 ? 0 : (Level == 0 ? 1 : 8 - Level);
+				Indices |= Index << ((Row * 4 + Column) * 3);
+			}
+		}
+	}
+
+	OutBlock[0] = static_cast<uint8>(MaxAlpha);
+	OutBlock[1] = static_cast<uint8>(MinAlpha);
+	for (int32 Byte = 0; Byte < 6; Byte++)
+	{
+		OutBlock[2 + Byte] = (Indices >> (Byte * 8)) & 0xFF;
+	}
+}
+
+uint16 FAvatarBlockEncoder::PackRGB565(const uint8 R, const uint8 G, const uint8 B)
+{
+	// Rounded, not truncated, to halve the average quantization error.
+	const uint16 R5 = (R * 31 + 127) / 255;
+	const uint16 G6 = (G * 63 + 127) / 255;
+	const uint16 B5 = (B * 31 + 127) / 255;
+	return (R5 << 11) | (G6 << 5) | B5;
+}
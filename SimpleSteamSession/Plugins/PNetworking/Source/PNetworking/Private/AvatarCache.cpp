@@ -0,0 +1,231 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#include "AvatarCache.h"
+#include "AvatarPipeline.h"
+#include "AvatarTexturePool.h"
+#include "Engine/Texture2D.h"
+#include "PNetworking.h"
+
+FAvatarCache::FAvatarCache(const int64 InBudgetBytes, const int32 InMaxEntries)
+	: BudgetBytes(InBudgetBytes)
+	, MaxEntries(InMaxEntries)
+	, UsedBytes(0)
+	, Hits(0)
+	, Misses(0)
+	, Evictions(0)
+{
+}
+
+FAvatarCache::~FAvatarCache()
+{
+	Empty();
+}
+
+UTexture2D* FAvatarCache::Find(const uint64 SteamID, const int32 AvatarHandle, const EAvatarSize AvatarSize)
+{
+	FEntry* Entry = Entries.Find(SteamID);
+
+	// Not cached, or only a smaller tier is cached: a new texture is needed.
+	if (!Entry || Entry->AvatarSize < AvatarSize || !IsValid(Entry->Texture))
+	{
+		Misses++;
+		return nullptr;
+	}
+
+	// Handle 0: avatar served from disk, its live handle is not known yet.
+	if (AvatarHandle == 0)
+	{
+		Touch(*Entry);
+		Hits++;
+		return Entry->Texture;
+	}
+
+	// First request of a smaller tier: its handle is learned only if the cached texture is still the live avatar.
+	int32& TierHandle = Entry->TierHandles[static_cast<int32>(AvatarSize)];
+	if (TierHandle == 0 && IsLive(SteamID, *Entry))
+	{
+		TierHandle = AvatarHandle;
+	}
+
+	// Steam has a new avatar for this user: old texture is useless.
+	if (TierHandle != AvatarHandle)
+	{
+		Misses++;
+		return nullptr;
+	}
+
+	Touch(*Entry);
+	Hits++;
+	return Entry->Texture;
+}
+
+void FAvatarCache::Add(const uint64 SteamID, const int32 AvatarHandle, const EAvatarSize AvatarSize, UTexture2D* Texture, const int64 SizeBytes)
+{
+	if (!Texture)
+	{
+		return;
+	}
+
+	FEntry* OldEntry = Entries.Find(SteamID);
+
+	// Smaller tier of a larger avatar still cached: no downgrade, only its handle is remembered.
+	if (OldEntry && OldEntry->AvatarSize > AvatarSize && IsValid(OldEntry->Texture))
+	{
+		const bool bIsPersisted = OldEntry->TierHandles[static_cast<int32>(OldEntry->AvatarSize)] == 0;
+		if (bIsPersisted || IsLive(SteamID, *OldEntry))
+		{
+			if (!bIsPersisted)
+			{
+				OldEntry->TierHandles[static_cast<int32>(AvatarSize)] = AvatarHandle;
+			}
+			return;
+		}
+	}
+
+	// Same texture added again: it must not go back to the pool.
+	if (OldEntry && OldEntry->Texture == Texture)
+	{
+		OldEntry->Texture = nullptr;
+	}
+
+	RemoveEntry(SteamID);
+
+	LruOrder.AddHead(SteamID);
+
+	FEntry& NewEntry = Entries.Add(SteamID);
+	NewEntry.Texture = Texture;
+	NewEntry.AvatarSize = AvatarSize;
+	FMemory::Memzero(NewEntry.TierHandles);
+	NewEntry.TierHandles[static_cast<int32>(AvatarSize)] = AvatarHandle;
+	NewEntry.SizeBytes = SizeBytes;
+	NewEntry.LruNode = LruOrder.GetHead();
+
+	UsedBytes += SizeBytes;
+
+	EvictToBudget();
+}
+
+UTexture2D* FAvatarCache::BindPersisted(const uint64 SteamID, const int32 AvatarHandle, const EAvatarSize AvatarSize)
+{
+	FEntry* Entry = Entries.Find(SteamID);
+	if (!Entry || Entry->AvatarSize != AvatarSize || !IsValid(Entry->Texture))
+	{
+		return nullptr;
+	}
+
+	Entry->TierHandles[static_cast<int32>(AvatarSize)] = AvatarHandle;
+	Touch(*Entry);
+	return Entry->Texture;
+}
+
+void FAvatarCache::Remove(const uint64 SteamID)
+{
+	RemoveEntry(SteamID);
+}
+
+void FAvatarCache::Empty()
+{
+	if (TexturePool.IsValid())
+	{
+		for (TPair<uint64, FEntry>& Pair : Entries)
+		{
+			TexturePool->Release(Pair.Value.Texture);
+		}
+	}
+
+	Entries.Empty();
+	LruOrder.Empty();
+	UsedBytes = 0;
+}
+
+void FAvatarCache::SetBudget(const int64 NewBudgetBytes, const int32 NewMaxEntries)
+{
+	BudgetBytes = FMath::Max<int64>(NewBudgetBytes, 0);
+	MaxEntries = FMath::Max(NewMaxEntries, 0);
+	EvictToBudget();
+}
+
+void FAvatarCache::SetTexturePool(TSharedPtr<FAvatarTexturePool> InTexturePool)
+{
+	TexturePool = InTexturePool;
+}
+
+FAvatarCacheStats FAvatarCache::GetStats() const
+{
+	FAvatarCacheStats Stats;
+	Stats.Hits = Hits;
+	Stats.Misses = Misses;
+	Stats.Evictions = Evictions;
+	Stats.NumEntries = Entries.Num();
+	Stats.UsedBytes = UsedBytes;
+	Stats.BudgetBytes = BudgetBytes;
+	return Stats;
+}
+
+void FAvatarCache::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	for (TPair<uint64, FEntry>& Pair : Entries)
+	{
+		Collector.AddReferencedObject(Pair.Value.Texture);
+	}
+}
+
+FString FAvatarCache::GetReferencerName() const
+{
+	return TEXT("FAvatarCache");
+}
+
+void FAvatarCache::Touch(FEntry& Entry)
+{
+	if (Entry.LruNode == LruOrder.GetHead())
+	{
+		return;
+	}
+
+	const uint64 SteamID = Entry.LruNode->GetValue();
+	LruOrder.RemoveNode(Entry.LruNode);
+	LruOrder.AddHead(SteamID);
+	Entry.LruNode = LruOrder.GetHead();
+}
+
+bool FAvatarCache::IsLive(const uint64 SteamID, const FEntry& Entry) const
+{
+	const int32 EntryHandle = Entry.TierHandles[static_cast<int32>(Entry.AvatarSize)];
+	return EntryHandle != 0 && EntryHandle == FAvatarPipeline::GetAvatarHandle(CSteamID(SteamID), Entry.AvatarSize);
+}
+
+void FAvatarCache::EvictToBudget()
+{
+	// Always keep the most recent entry, even if alone it is bigger than the budget.
+	while (Entries.Num() > 1 && (UsedBytes > BudgetBytes || Entries.Num() > MaxEntries))
+	{
+		FLruList::TDoubleLinkedListNode* Tail = LruOrder.GetTail();
+		if (!Tail)
+		{
+			break;
+		}
+
+		UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("FAvatarCache: Evicting avatar of SteamID %llu"), Tail->GetValue());
+		RemoveEntry(Tail->GetValue());
+		Evictions++;
+	}
+}
+
+void FAvatarCache::RemoveEntry(const uint64 SteamID)
+{
+	FEntry RemovedEntry;
+	if (!Entries.RemoveAndCopyValue(SteamID, RemovedEntry))
+	{
+		return;
+	}
+
+	UsedBytes -= RemovedEntry.SizeBytes;
+	LruOrder.RemoveNode(RemovedEntry.LruNode);
+
+	if (TexturePool.IsValid())
+	{
+		TexturePool->Release(RemovedEntry.Texture);
+	}
+}
@@ -0,0 +1,286 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#include "AvatarDiskCache.h"
+#include "AvatarCache.h"
+#include "AvatarPipeline.h"
+#include "PNetworking.h"
+#include "Algo/StableSort.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Memory/MemoryView.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+
+FAvatarDiskCache::FAvatarDiskCache()
+	: bIsDirty(false)
+{
+}
+
+FAvatarDiskCache::~FAvatarDiskCache()
+{
+	Unmap();
+}
+
+bool FAvatarDiskCache::Load()
+{
+	Unmap();
+	Records.Empty();
+	bIsDirty = false;
+
+	const FString PackPath = GetPackPath();
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if (!PlatformFile.FileExists(*PackPath))
+	{
+		return false;
+	}
+
+	MappedFile.Reset(PlatformFile.OpenMapped(*PackPath));
+	if (!MappedFile.IsValid() || MappedFile->GetFileSize() <= 0)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FAvatarDiskCache: Can't map %s!"), *PackPath);
+		Unmap();
+		return false;
+	}
+
+	const int64 FileSize = MappedFile->GetFileSize();
+	MappedRegion.Reset(MappedFile->MapRegion(0, FileSize));
+	if (!MappedRegion.IsValid())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FAvatarDiskCache: Can't map %s!"), *PackPath);
+		Unmap();
+		return false;
+	}
+
+	FMemoryReaderView Reader(FMemoryView(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize()));
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	int32 NumEntries = 0;
+	Reader << Magic << Version << NumEntries;
+
+	if (Magic != AVATAR_DISK_CACHE_MAGIC || Version != AVATAR_DISK_CACHE_VERSION || NumEntries < 0 || NumEntries > AVATAR_DISK_CACHE_MAX_ENTRIES)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FAvatarDiskCache: Invalid pack, ignored!"));
+		Unmap();
+		return false;
+	}
+
+	Records.Reserve(NumEntries);
+	for (int32 Index = 0; Index < NumEntries && !Reader.IsError(); Index++)
+	{
+		uint64 SteamID = 0;
+		uint8 Tier = 0;
+		FRecord Record;
+		Reader << SteamID << Record.Hash << Tier << Record.Width << Record.Height << Record.Offset << Record.Size;
+
+		// Truncated or corrupted pack: drop the entry instead of reading outside the mapping.
+		if (Record.Offset < 0 || Record.Size != static_cast<int32>(Record.Width * Record.Height * 4) || Record.Offset + Record.Size > FileSize)
+		{
+			continue;
+		}
+
+		Record.AvatarSize = static_cast<EAvatarSize>(FMath::Min<uint8>(Tier, static_cast<uint8>(EAvatarSize::AVATAR_LARGE)));
+		Record.bIsUsed = false;
+		Records.Add(SteamID, MoveTemp(Record));
+	}
+
+	if (Reader.IsError())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FAvatarDiskCache: Invalid pack index, ignored!"));
+		Records.Empty();
+		Unmap();
+		return false;
+	}
+
+	UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("FAvatarDiskCache: Loaded %d avatars"), Records.Num());
+	return true;
+}
+
+bool FAvatarDiskCache::Save()
+{
+	if (!bIsDirty && Records.Num() <= AVATAR_DISK_CACHE_MAX_ENTRIES)
+	{
+		return true;
+	}
+
+	// Over limit: avatars not seen during this session are dropped first.
+	TArray<uint64> SavedSteamIDs;
+	Records.GenerateKeyArray(SavedSteamIDs);
+	if (SavedSteamIDs.Num() > AVATAR_DISK_CACHE_MAX_ENTRIES)
+	{
+		Algo::StableSortBy(SavedSteamIDs, [this](const uint64 SteamID) { return Records[SteamID].bIsUsed ? 0 : 1; });
+		SavedSteamIDs.SetNum(AVATAR_DISK_CACHE_MAX_ENTRIES);
+	}
+
+	const FString PackPath = GetPackPath();
+	const FString TempPath = PackPath + TEXT(".tmp");
+
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*TempPath));
+	if (!Writer.IsValid())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FAvatarDiskCache: Can't write %s!"), *TempPath);
+		return false;
+	}
+
+	uint32 Magic = AVATAR_DISK_CACHE_MAGIC;
+	uint32 Version = AVATAR_DISK_CACHE_VERSION;
+	int32 NumEntries = SavedSteamIDs.Num();
+	*Writer << Magic << Version << NumEntries;
+
+	// Header + index size is fixed, so pixels offsets are known before writing them.
+	const int64 IndexEntrySize = sizeof(uint64) + sizeof(uint32) + sizeof(uint8) + sizeof(uint32) * 2 + sizeof(int64) + sizeof(int32);
+	int64 NextOffset = Writer->Tell() + IndexEntrySize * NumEntries;
+
+	for (uint64 SteamID : SavedSteamIDs)
+	{
+		const FRecord& Record = Records[SteamID];
+		uint32 Hash = Record.Hash;
+		uint8 Tier = static_cast<uint8>(Record.AvatarSize);
+		uint32 Width = Record.Width;
+		uint32 Height = Record.Height;
+		int64 Offset = NextOffset;
+		int32 Size = Record.Size;
+		*Writer << SteamID << Hash << Tier << Width << Height << Offset << Size;
+
+		NextOffset += Size;
+	}
+
+	for (const uint64 SteamID : SavedSteamIDs)
+	{
+		const FRecord& Record = Records[SteamID];
+		Writer->Serialize(const_cast<uint8*>(GetRecordData(Record)), Record.Size);
+	}
+
+	const bool bWriteSucceeded = Writer->Close();
+	Writer.Reset();
+
+	// Mapping must be released before replacing the file.
+	Unmap();
+
+	if (!bWriteSucceeded || !IFileManager::Get().Move(*PackPath, *TempPath, true, true))
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FAvatarDiskCache: Can't replace %s!"), *PackPath);
+		IFileManager::Get().Delete(*TempPath);
+		Records.Empty();
+		return false;
+	}
+
+	UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("FAvatarDiskCache: Saved %d avatars"), NumEntries);
+
+	// Offsets changed: reload index from the new pack.
+	return Load();
+}
+
+bool FAvatarDiskCache::FindPixels(const uint64 SteamID, const EAvatarSize AvatarSize, FAvatarPixels& OutPixels)
+{
+	FRecord* Record = Records.Find(SteamID);
+	if (!Record || Record->AvatarSize < AvatarSize)
+	{
+		return false;
+	}
+
+	const uint8* Data = GetRecordData(*Record);
+	if (!Data)
+	{
+		return false;
+	}
+
+	Record->bIsUsed = true;
+
+	OutPixels.SteamID = SteamID;
+	OutPixels.AvatarHandle = 0;
+	OutPixels.AvatarSize = Record->AvatarSize;
+	OutPixels.Width = Record->Width;
+	OutPixels.Height = Record->Height;
+	OutPixels.RGBA = TArray<uint8>(Data, Record->Size);
+	OutPixels.Hash = Record->Hash;
+	OutPixels.EncodedData.Empty();
+	OutPixels.EncodedFormat = PF_Unknown;
+	OutPixels.RequestID = 0;
+	return true;
+}
+
+bool FAvatarDiskCache::HasSameHash(const uint64 SteamID, const EAvatarSize AvatarSize, const uint32 Hash) const
+{
+	const FRecord* Record = Records.Find(SteamID);
+	return Record && Record->AvatarSize == AvatarSize && Record->Hash == Hash;
+}
+
+bool FAvatarDiskCache::FindHash(const uint64 SteamID, uint32& OutHash) const
+{
+	const FRecord* Record = Records.Find(SteamID);
+	if (!Record)
+	{
+		return false;
+	}
+
+	OutHash = Record->Hash;
+	return true;
+}
+
+void FAvatarDiskCache::Store(const FAvatarPixels& Pixels)
+{
+	if (Pixels.RGBA.Num() == 0)
+	{
+		return;
+	}
+
+	// Unchanged avatar, or a smaller tier of an already persisted one: the larger tier is kept.
+	FRecord* ExistingRecord = Records.Find(Pixels.SteamID);
+	if (ExistingRecord && (ExistingRecord->AvatarSize > Pixels.AvatarSize || (ExistingRecord->AvatarSize == Pixels.AvatarSize && ExistingRecord->Hash == Pixels.Hash)))
+	{
+		ExistingRecord->bIsUsed = true;
+		return;
+	}
+
+	FRecord& Record = Records.Add(Pixels.SteamID);
+	Record.bIsUsed = true;
+	Record.Hash = Pixels.Hash;
+	Record.AvatarSize = Pixels.AvatarSize;
+	Record.Width = Pixels.Width;
+	Record.Height = Pixels.Height;
+	Record.Offset = 0;
+	Record.Size = Pixels.RGBA.Num();
+	Record.RGBA = Pixels.RGBA;
+
+	bIsDirty = true;
+}
+
+int32 FAvatarDiskCache::GetNumEntries() const
+{
+	return Records.Num();
+}
+
+const uint8* FAvatarDiskCache::GetRecordData(const FRecord& Record) const
+{
+	if (Record.RGBA.Num() > 0)
+	{
+		return Record.RGBA.GetData();
+	}
+
+	return MappedRegion.IsValid() ? MappedRegion->GetMappedPtr() + Record.Offset : nullptr;
+}
+
+void FAvatarDiskCache::Unmap()
+{
+	// Region must be released before its file.
+	MappedRegion.Reset();
+	MappedFile.Reset();
+
+	// Records pointing inside the old mapping are not readable anymore.
+	for (auto It = Records.CreateIterator(); It; ++It)
+	{
+		if (It.Value().RGBA.Num() == 0)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+FString FAvatarDiskCache::GetPackPath() const
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), AVATAR_DISK_CACHE_FILE_NAME);
+}
@@ -0,0 +1,377 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#include "AvatarPipeline.h"
+#include "AvatarCache.h"
+#include "AvatarDiskCache.h"
+#include "AvatarTexturePool.h"
+#include "AvatarBlockEncoder.h"
+#include "PNetworking.h"
+#include "Async/Async.h"
+#include "Engine/Texture2D.h"
+
+FAvatarPipeline::FAvatarPipeline(TSharedPtr<FAvatarCache> InAvatarCache, TSharedPtr<FAvatarDiskCache> InDiskCache, TSharedPtr<FAvatarTexturePool> InTexturePool)
+	: AvatarCache(InAvatarCache)
+	, DiskCache(InDiskCache)
+	, TexturePool(InTexturePool)
+	, RevalidateElapsed(0.f)
+	, bIsCompressionEnabled(false)
+	, FetchedPixels(MakeShared<FPixelsQueue, ESPMode::ThreadSafe>())
+	, LastPixelsRequestID(0)
+{
+	TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FAvatarPipeline::Tick));
+}
+
+FAvatarPipeline::~FAvatarPipeline()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+
+	// Pipeline is being shut down with the plugin: pending callbacks are dropped.
+	InFlightRequests.Empty();
+	PixelsRequests.Empty();
+	PendingRevalidations.Empty();
+}
+
+int32 FAvatarPipeline::GetAvatarHandle(const CSteamID SteamID, const EAvatarSize AvatarSize)
+{
+	ISteamFriends* SteamFriendsInterface = SteamFriends();
+	if (!SteamFriendsInterface)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("GetAvatarHandle: SteamFriendsInterface steamworks_sdk not valid!"));
+		return 0;
+	}
+
+	int32 AvatarHandle = 0;
+	switch (AvatarSize)
+	{
+	case EAvatarSize::AVATAR_SMALL:
+		AvatarHandle = SteamFriendsInterface->GetSmallFriendAvatar(SteamID);
+		break;
+	case EAvatarSize::AVATAR_MEDIUM:
+		AvatarHandle = SteamFriendsInterface->GetMediumFriendAvatar(SteamID);
+		break;
+	default:
+		AvatarHandle = SteamFriendsInterface->GetLargeFriendAvatar(SteamID);
+		break;
+	}
+
+	if (AvatarHandle == 0)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("GetAvatarHandle: ERROR: Invalid Avatar ID!"));
+	}
+
+	return AvatarHandle;
+}
+
+EAvatarSize FAvatarPipeline::ResolveAvatarSize(const EAvatarSize AvatarSize, const int32 PixelSize)
+{
+	if (AvatarSize != EAvatarSize::AVATAR_AUTO)
+	{
+		return AvatarSize;
+	}
+
+	if (PixelSize > 0 && PixelSize <= AVATAR_SMALL_PIXEL_SIZE)
+	{
+		return EAvatarSize::AVATAR_SMALL;
+	}
+
+	if (PixelSize > 0 && PixelSize <= AVATAR_MEDIUM_PIXEL_SIZE)
+	{
+		return EAvatarSize::AVATAR_MEDIUM;
+	}
+
+	// Unknown or big on-screen size.
+	return EAvatarSize::AVATAR_LARGE;
+}
+
+bool FAvatarPipeline::RequestTexture(const CSteamID SteamID, const int32 AvatarHandle, const EAvatarSize AvatarSize, FOnAvatarPipelineComplete OnComplete)
+{
+	check(IsInGameThread());
+
+	const uint64 SteamID64 = SteamID.ConvertToUint64();
+
+	if (AvatarCache.IsValid())
+	{
+		UTexture2D* CachedTexture = AvatarCache->Find(SteamID64, AvatarHandle, AvatarSize);
+		if (CachedTexture)
+		{
+			OnComplete.ExecuteIfBound(CachedTexture);
+			return true;
+		}
+	}
+
+	// Same avatar already being fetched: just wait for it.
+	if (TArray<FOnAvatarPipelineComplete>* Waiting = InFlightRequests.Find(AvatarHandle))
+	{
+		Waiting->Add(MoveTemp(OnComplete));
+		return false;
+	}
+
+	InFlightRequests.Add(AvatarHandle).Add(MoveTemp(OnComplete));
+
+	FetchPixelsAsync(SteamID64, AvatarHandle, AvatarSize, 0);
+
+	return false;
+}
+
+bool FAvatarPipeline::RequestPersistedTexture(const CSteamID SteamID, const EAvatarSize AvatarSize, FOnAvatarPipelineComplete OnComplete)
+{
+	check(IsInGameThread());
+
+	const uint64 SteamID64 = SteamID.ConvertToUint64();
+
+	// Already served from disk (handle still unknown) during this session.
+	if (AvatarCache.IsValid())
+	{
+		UTexture2D* CachedTexture = AvatarCache->Find(SteamID64, 0, AvatarSize);
+		if (CachedTexture)
+		{
+			OnComplete.ExecuteIfBound(CachedTexture);
+			return true;
+		}
+	}
+
+	FAvatarPixels Pixels;
+	if (!DiskCache.IsValid() || !DiskCache->FindPixels(SteamID64, AvatarSize, Pixels))
+	{
+		return false;
+	}
+
+	const int64 SizeBytes = Pixels.RGBA.Num();
+	const EAvatarSize PersistedSize = Pixels.AvatarSize;
+	UTexture2D* AvatarTexture = CreateTexture(Pixels);
+	if (!AvatarTexture)
+	{
+		return false;
+	}
+
+	// Handle 0: live handle is bound by revalidation if pixels are unchanged, otherwise the texture is replaced.
+	if (AvatarCache.IsValid())
+	{
+		AvatarCache->Add(SteamID64, 0, PersistedSize, AvatarTexture, SizeBytes);
+	}
+
+	PendingRevalidations.Add(SteamID64, PersistedSize);
+
+	OnComplete.ExecuteIfBound(AvatarTexture);
+	return true;
+}
+
+void FAvatarPipeline::RequestPixels(const CSteamID SteamID, const int32 AvatarHandle, const EAvatarSize AvatarSize, FOnAvatarPixelsReady OnReady)
+{
+	check(IsInGameThread());
+
+	// 0 is reserved to texture requests.
+	LastPixelsRequestID = FMath::Max<uint32>(LastPixelsRequestID + 1, 1);
+	PixelsRequests.Add(LastPixelsRequestID, MoveTemp(OnReady));
+
+	FetchPixelsAsync(SteamID.ConvertToUint64(), AvatarHandle, AvatarSize, LastPixelsRequestID);
+}
+
+int32 FAvatarPipeline::GetNumInFlight() const
+{
+	return InFlightRequests.Num() + PixelsRequests.Num();
+}
+
+void FAvatarPipeline::SetCompressionEnabled(const bool bEnabled)
+{
+	bIsCompressionEnabled = bEnabled;
+}
+
+bool FAvatarPipeline::IsCompressionEnabled() const
+{
+	return bIsCompressionEnabled;
+}
+
+void FAvatarPipeline::RevalidatePersisted()
+{
+	for (auto It = PendingRevalidations.CreateIterator(); It; ++It)
+	{
+		const int32 AvatarHandle = GetAvatarHandle(CSteamID(It.Key()), It.Value());
+
+		// Still downloading on SteamAPI side.
+		if (AvatarHandle == -1)
+		{
+			continue;
+		}
+
+		// Live pixels go through the normal path: texture is replaced only if the hash changed.
+		if (AvatarHandle != 0 && !InFlightRequests.Contains(AvatarHandle))
+		{
+			InFlightRequests.Add(AvatarHandle);
+			FetchPixelsAsync(It.Key(), AvatarHandle, It.Value(), 0);
+		}
+
+		It.RemoveCurrent();
+	}
+}
+
+void FAvatarPipeline::FetchPixelsAsync(const uint64 SteamID, const int32 AvatarHandle, const EAvatarSize AvatarSize, const uint32 RequestID)
+{
+	const bool bEncode = bIsCompressionEnabled && RequestID == 0;
+
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [FetchedPixels = FetchedPixels, SteamID, AvatarHandle, AvatarSize, RequestID, bEncode]()
+		{
+			FAvatarPixels Pixels;
+			Pixels.SteamID = SteamID;
+			Pixels.AvatarHandle = AvatarHandle;
+			Pixels.AvatarSize = AvatarSize;
+			Pixels.Width = 0;
+			Pixels.Height = 0;
+			Pixels.Hash = 0;
+			Pixels.EncodedFormat = PF_Unknown;
+			Pixels.RequestID = RequestID;
+
+			ISteamUtils* SteamUtilsInterface = SteamUtils();
+			if (SteamUtilsInterface && SteamUtilsInterface->GetImageSize(AvatarHandle, &Pixels.Width, &Pixels.Height))
+			{
+				const uint32 BufferSize = Pixels.Width * Pixels.Height * 4;
+				Pixels.RGBA.SetNumUninitialized(BufferSize);
+				if (!SteamUtilsInterface->GetImageRGBA(AvatarHandle, Pixels.RGBA.GetData(), BufferSize))
+				{
+					Pixels.RGBA.Empty();
+				}
+				else
+				{
+					Pixels.Hash = FCrc::MemCrc32(Pixels.RGBA.GetData(), Pixels.RGBA.Num());
+
+					// RGBA is kept for the disk cache and as fallback if encoding is not possible.
+					if (bEncode)
+					{
+						Pixels.EncodedFormat = FAvatarBlockEncoder::Encode(Pixels.RGBA, Pixels.Width, Pixels.Height, Pixels.EncodedData);
+						if (Pixels.EncodedFormat == PF_Unknown)
+						{
+							Pixels.EncodedData.Empty();
+						}
+					}
+				}
+			}
+
+			FetchedPixels->Enqueue(MoveTemp(Pixels));
+		}
+	);
+}
+
+bool FAvatarPipeline::Tick(float DeltaTime)
+{
+	RevalidateElapsed += DeltaTime;
+	if (RevalidateElapsed >= AVATAR_PIPELINE_REVALIDATE_INTERVAL && PendingRevalidations.Num() > 0)
+	{
+		RevalidateElapsed = 0.f;
+		RevalidatePersisted();
+	}
+
+	FAvatarPixels Pixels;
+	for (int32 Uploads = 0; Uploads < AVATAR_PIPELINE_MAX_UPLOADS_PER_FRAME && FetchedPixels->Dequeue(Pixels); Uploads++)
+	{
+		// Raw pixels request: receiver owns the upload.
+		if (Pixels.RequestID != 0)
+		{
+			FOnAvatarPixelsReady OnReady;
+			if (PixelsRequests.RemoveAndCopyValue(Pixels.RequestID, OnReady))
+			{
+				OnReady.ExecuteIfBound(Pixels);
+			}
+			continue;
+		}
+
+		if (Pixels.RGBA.Num() == 0)
+		{
+			UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FAvatarPipeline: ERROR: GetImageRGBA() for SteamID %llu"), Pixels.SteamID);
+			CompleteRequest(Pixels.AvatarHandle, nullptr);
+			continue;
+		}
+
+		// Avatar served from disk and unchanged: keep its texture, now bound to the live handle.
+		if (DiskCache.IsValid() && AvatarCache.IsValid() && DiskCache->HasSameHash(Pixels.SteamID, Pixels.AvatarSize, Pixels.Hash))
+		{
+			UTexture2D* PersistedTexture = AvatarCache->BindPersisted(Pixels.SteamID, Pixels.AvatarHandle, Pixels.AvatarSize);
+			if (PersistedTexture)
+			{
+				CompleteRequest(Pixels.AvatarHandle, PersistedTexture);
+				continue;
+			}
+		}
+
+		if (DiskCache.IsValid())
+		{
+			DiskCache->Store(Pixels);
+		}
+
+		const int64 SizeBytes = Pixels.EncodedData.Num() > 0 ? Pixels.EncodedData.Num() : Pixels.RGBA.Num();
+		UTexture2D* AvatarTexture = CreateTexture(Pixels);
+
+		if (AvatarTexture && AvatarCache.IsValid())
+		{
+			AvatarCache->Add(Pixels.SteamID, Pixels.AvatarHandle, Pixels.AvatarSize, AvatarTexture, SizeBytes);
+		}
+
+		if (AvatarTexture)
+		{
+			OnTextureUpdated.Broadcast(Pixels.SteamID, Pixels.AvatarSize, AvatarTexture);
+		}
+
+		CompleteRequest(Pixels.AvatarHandle, AvatarTexture);
+	}
+
+	return true;
+}
+
+UTexture2D* FAvatarPipeline::CreateTexture(FAvatarPixels& Pixels) const
+{
+	const bool bIsEncoded = Pixels.EncodedData.Num() > 0;
+	const EPixelFormat PixelFormat = bIsEncoded ? Pixels.EncodedFormat : EPixelFormat::PF_R8G8B8A8;
+
+	UTexture2D* AvatarTexture = nullptr;
+	if (TexturePool.IsValid())
+	{
+		// Same size and format: the whole texture is overwritten by the upload below.
+		AvatarTexture = TexturePool->Acquire(Pixels.Width, Pixels.Height, PixelFormat);
+	}
+	else
+	{
+		AvatarTexture = UTexture2D::CreateTransient(Pixels.Width, Pixels.Height, PixelFormat);
+		if (AvatarTexture)
+		{
+			AvatarTexture->UpdateResource();
+		}
+	}
+
+	if (!AvatarTexture)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FAvatarPipeline: ERROR: Invalid Avatar Texture!"));
+		return nullptr;
+	}
+
+	// Pixels and region are owned by RenderThread until the upload is done.
+	// Pitch of compressed data is a row of 4x4 blocks.
+	TArray<uint8>* UploadData = new TArray<uint8>(MoveTemp(bIsEncoded ? Pixels.EncodedData : Pixels.RGBA));
+	FUpdateTextureRegion2D* UploadRegion = new FUpdateTextureRegion2D(0, 0, 0, 0, Pixels.Width, Pixels.Height);
+	const uint32 SrcPitch = bIsEncoded ? FAvatarBlockEncoder::GetBlockRowPitch(Pixels.Width, PixelFormat) : Pixels.Width * 4;
+	const uint32 SrcBpp = bIsEncoded ? FAvatarBlockEncoder::GetBlockBytes(PixelFormat) : 4;
+
+	AvatarTexture->UpdateTextureRegions(0, 1, UploadRegion, SrcPitch, SrcBpp, UploadData->GetData(),
+		[UploadData](uint8* SrcData, const FUpdateTextureRegion2D* Regions)
+		{
+			delete UploadData;
+			delete Regions;
+		}
+	);
+
+	return AvatarTexture;
+}
+
+void FAvatarPipeline::CompleteRequest(const int32 AvatarHandle, UTexture2D* Texture)
+{
+	TArray<FOnAvatarPipelineComplete> Callbacks;
+	if (!InFlightRequests.RemoveAndCopyValue(AvatarHandle, Callbacks))
+	{
+		return;
+	}
+
+	for (FOnAvatarPipelineComplete& Callback : Callbacks)
+	{
+		Callback.ExecuteIfBound(Texture);
+	}
+}
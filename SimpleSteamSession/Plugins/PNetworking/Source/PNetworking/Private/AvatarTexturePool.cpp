@@ -0,0 +1,223 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#include "AvatarTexturePool.h"
+#include "Engine/Texture2D.h"
+#include "PNetworking.h"
+#include "UObject/GarbageCollection.h"
+#include "UObject/ReferencerFinder.h"
+#include "UObject/UObjectGlobals.h"
+
+FAvatarTexturePool::FAvatarTexturePool(const int32 InMaxPerSize)
+	: bReclaimPending(false)
+	, MaxPerSize(FMath::Max(InMaxPerSize, 0))
+	, NumPooled(0)
+	, NumCreated(0)
+	, NumReused(0)
+	, NumDiscarded(0)
+{
+	PostGarbageCollectHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddRaw(this, &FAvatarTexturePool::OnPostGarbageCollect);
+}
+
+FAvatarTexturePool::~FAvatarTexturePool()
+{
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGarbageCollectHandle);
+	Empty();
+}
+
+UTexture2D* FAvatarTexturePool::Acquire(const uint32 Width, const uint32 Height, const EPixelFormat PixelFormat)
+{
+	check(IsInGameThread());
+
+	if (bReclaimPending)
+	{
+		ReclaimParked();
+	}
+
+	if (TArray<UTexture2D*>* Textures = FreeTextures.Find(MakeKey(Width, Height, PixelFormat)))
+	{
+		while (Textures->Num() > 0)
+		{
+			UTexture2D* PooledTexture = Textures->Pop(EAllowShrinking::No);
+			NumPooled--;
+
+			if (IsValid(PooledTexture))
+			{
+				// From now on it is owned by the avatar cache, like a new texture.
+				PooledTexture->RemoveFromRoot();
+				NumReused++;
+				return PooledTexture;
+			}
+		}
+	}
+
+	UTexture2D* NewTexture = UTexture2D::CreateTransient(Width, Height, PixelFormat);
+	if (!NewTexture)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FAvatarTexturePool: ERROR: Invalid Avatar Texture!"));
+		return nullptr;
+	}
+
+	NewTexture->UpdateResource();
+	NumCreated++;
+	return NewTexture;
+}
+
+void FAvatarTexturePool::Release(UTexture2D* Texture)
+{
+	check(IsInGameThread());
+
+	if (!IsValid(Texture) || MaxPerSize == 0 || ParkedTextures.Contains(Texture))
+	{
+		return;
+	}
+
+	// Textures referenced for long (e.g. by a widget never destroyed) must not fill the pool forever.
+	if (ParkedTextures.Num() >= MaxPerSize * AVATAR_TEXTURE_POOL_PARKED_PER_FREE)
+	{
+		Discard(ParkedTextures[0]);
+		ParkedTextures.RemoveAt(0, 1, EAllowShrinking::No);
+	}
+
+	Texture->AddToRoot();
+	ParkedTextures.Add(Texture);
+}
+
+void FAvatarTexturePool::SetMaxPerSize(const int32 NewMaxPerSize)
+{
+	MaxPerSize = FMath::Max(NewMaxPerSize, 0);
+
+	for (TPair<uint64, TArray<UTexture2D*>>& Pair : FreeTextures)
+	{
+		while (Pair.Value.Num() > MaxPerSize)
+		{
+			Discard(Pair.Value.Pop(EAllowShrinking::No));
+			NumPooled--;
+		}
+	}
+
+	const int32 MaxParked = MaxPerSize * AVATAR_TEXTURE_POOL_PARKED_PER_FREE;
+	while (ParkedTextures.Num() > MaxParked)
+	{
+		Discard(ParkedTextures[0]);
+		ParkedTextures.RemoveAt(0, 1, EAllowShrinking::No);
+	}
+}
+
+void FAvatarTexturePool::Empty()
+{
+	// Root set is gone with UObject system on shutdown.
+	if (UObjectInitialized())
+	{
+		for (UTexture2D* Texture : ParkedTextures)
+		{
+			Texture->RemoveFromRoot();
+		}
+
+		for (TPair<uint64, TArray<UTexture2D*>>& Pair : FreeTextures)
+		{
+			for (UTexture2D* Texture : Pair.Value)
+			{
+				Texture->RemoveFromRoot();
+			}
+		}
+	}
+
+	ParkedTextures.Empty();
+	FreeTextures.Empty();
+	NumPooled = 0;
+}
+
+FAvatarTexturePoolStats FAvatarTexturePool::GetStats() const
+{
+	FAvatarTexturePoolStats Stats;
+	Stats.NumPooled = NumPooled;
+	Stats.NumParked = ParkedTextures.Num();
+	Stats.NumCreated = NumCreated;
+	Stats.NumReused = NumReused;
+	Stats.NumDiscarded = NumDiscarded;
+	Stats.MaxPerSize = MaxPerSize;
+	return Stats;
+}
+
+uint64 FAvatarTexturePool::MakeKey(const uint32 Width, const uint32 Height, const EPixelFormat PixelFormat)
+{
+	return (static_cast<uint64>(Width) << 40) | (static_cast<uint64>(Height) << 16) | static_cast<uint64>(PixelFormat);
+}
+
+void FAvatarTexturePool::OnPostGarbageCollect()
+{
+	// Referencers are searched later on GameThread, not inside the collection.
+	bReclaimPending = ParkedTextures.Num() > 0;
+}
+
+void FAvatarTexturePool::ReclaimParked()
+{
+	// Objects of last collection still being destroyed could be reported as referencers.
+	if (IsGarbageCollecting() || IsIncrementalPurgePending())
+	{
+		return;
+	}
+
+	bReclaimPending = false;
+
+	TArray<UObject*> Referencees;
+	Referencees.Append(ParkedTextures);
+	const TSet<UObject*> ParkedSet(Referencees);
+
+	// A single scan of all objects finds who still references any parked texture.
+	// Root set is not a referencer, so the pool itself is never found.
+	const TArray<UObject*> Referencers = FReferencerFinder::GetAllReferencers(Referencees, nullptr, EReferencerFinderFlags::SkipInnerReferences);
+
+	// Referencers are few: find which parked textures each one holds.
+	TSet<UObject*> StillReferenced;
+	for (UObject* Referencer : Referencers)
+	{
+		TArray<UObject*> References;
+		FReferenceFinder Finder(References, nullptr, false, false, false, false);
+		Finder.FindReferences(Referencer);
+
+		for (UObject* Reference : References)
+		{
+			if (ParkedSet.Contains(Reference))
+			{
+				StillReferenced.Add(Reference);
+			}
+		}
+	}
+
+	for (int32 Index = 0; Index < ParkedTextures.Num(); )
+	{
+		UTexture2D* Texture = ParkedTextures[Index];
+		if (StillReferenced.Contains(Texture))
+		{
+			Index++;
+			continue;
+		}
+
+		ParkedTextures.RemoveAt(Index, 1, EAllowShrinking::No);
+
+		if (!IsValid(Texture))
+		{
+			Discard(Texture);
+			continue;
+		}
+
+		TArray<UTexture2D*>& Textures = FreeTextures.FindOrAdd(MakeKey(Texture->GetSizeX(), Texture->GetSizeY(), Texture->GetPixelFormat()));
+		if (Textures.Num() >= MaxPerSize)
+		{
+			Discard(Texture);
+			continue;
+		}
+
+		Textures.Add(Texture);
+		NumPooled++;
+	}
+}
+
+void FAvatarTexturePool::Discard(UTexture2D* Texture)
+{
+	Texture->RemoveFromRoot();
+	NumDiscarded++;
+}
@@ -0,0 +1,125 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#include "FriendListSnapshot.h"
+#include "PNetworking.h"
+
+int32 FFriendListSnapshot::Find(const uint64 SteamID) const
+{
+	const int32* Row = IndexBySteamID.Find(SteamID);
+	return Row ? *Row : INDEX_NONE;
+}
+
+void FFriendListSnapshot::Diff(const FFriendListSnapshot& Older, TArray<int32>& OutAddedRows, TArray<int32>& OutChangedRows, TArray<uint64>& OutRemovedSteamIDs) const
+{
+	OutAddedRows.Reset();
+	OutChangedRows.Reset();
+	OutRemovedSteamIDs.Reset();
+
+	for (int32 Row = 0; Row < Num(); Row++)
+	{
+		if (!Older.IndexBySteamID.Contains(SteamIDs[Row]))
+		{
+			OutAddedRows.Add(Row);
+		}
+		else if (RowVersions[Row] > Older.Version)
+		{
+			OutChangedRows.Add(Row);
+		}
+	}
+
+	for (const uint64 OlderSteamID : Older.SteamIDs)
+	{
+		if (!IndexBySteamID.Contains(OlderSteamID))
+		{
+			OutRemovedSteamIDs.Add(OlderSteamID);
+		}
+	}
+}
+
+FFriendRosterEntry FFriendListSnapshot::MakeEntry(const int32 Row) const
+{
+	FFriendRosterEntry Entry;
+	Entry.SteamID = static_cast<int32>(CSteamID(SteamIDs[Row]).GetAccountID());
+	Entry.UserName = UserNames[Row];
+	Entry.PersonaState = PersonaStates[Row];
+	Entry.bIsPlayingThisGame = PlayingThisGame[Row];
+	Entry.RichPresenceStatus = RichPresenceStatuses[Row];
+	Entry.AvatarHandle = AvatarHandles[Row];
+	return Entry;
+}
+
+void UFriendListSnapshot::SetSnapshot(FFriendListSnapshotRef InSnapshot)
+{
+	Snapshot = InSnapshot;
+}
+
+FFriendListSnapshotPtr UFriendListSnapshot::GetSnapshot() const
+{
+	return Snapshot;
+}
+
+int32 UFriendListSnapshot::GetVersion() const
+{
+	return Snapshot.IsValid() ? static_cast<int32>(Snapshot->Version) : 0;
+}
+
+int32 UFriendListSnapshot::Num() const
+{
+	return Snapshot.IsValid() ? Snapshot->Num() : 0;
+}
+
+int32 UFriendListSnapshot::FindRow(const int32 SteamID) const
+{
+	if (!Snapshot.IsValid())
+	{
+		return INDEX_NONE;
+	}
+
+	// Same conversion of ConvertInt32toCSteamID: individual account in public universe.
+	const CSteamID FullSteamID(static_cast<uint32>(SteamID), k_EUniversePublic, k_EAccountTypeIndividual);
+	return Snapshot->Find(FullSteamID.ConvertToUint64());
+}
+
+bool UFriendListSnapshot::GetRow(const int32 Row, FFriendRosterEntry& Friend) const
+{
+	if (!Snapshot.IsValid() || !Snapshot->SteamIDs.IsValidIndex(Row))
+	{
+		return false;
+	}
+
+	Friend = Snapshot->MakeEntry(Row);
+	return true;
+}
+
+void UFriendListSnapshot::Diff(const UFriendListSnapshot* Older, TArray<int32>& AddedRows, TArray<int32>& ChangedRows, TArray<int32>& RemovedSteamIDs) const
+{
+	AddedRows.Reset();
+	ChangedRows.Reset();
+	RemovedSteamIDs.Reset();
+
+	if (!Snapshot.IsValid())
+	{
+		return;
+	}
+
+	if (!Older || !Older->Snapshot.IsValid())
+	{
+		AddedRows.Reserve(Snapshot->Num());
+		for (int32 Row = 0; Row < Snapshot->Num(); Row++)
+		{
+			AddedRows.Add(Row);
+		}
+		return;
+	}
+
+	TArray<uint64> RemovedSteamIDs64;
+	Snapshot->Diff(*Older->Snapshot, AddedRows, ChangedRows, RemovedSteamIDs64);
+
+	RemovedSteamIDs.Reserve(RemovedSteamIDs64.Num());
+	for (const uint64 RemovedSteamID : RemovedSteamIDs64)
+	{
+		RemovedSteamIDs.Add(static_cast<int32>(CSteamID(RemovedSteamID).GetAccountID()));
+	}
+}
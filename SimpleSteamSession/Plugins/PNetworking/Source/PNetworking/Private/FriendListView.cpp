@@ -0,0 +1,97 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#include "FriendListView.h"
+#include "FriendNameIndex.h"
+#include "PNetworking.h"
+
+FFriendListView::FFriendListView(FFriendListSnapshotRef InSnapshot, const FFriendNameIndex& NameIndex, const EFriendListFilter InFilter, const EFriendListSort InSort, const FString& InQuery)
+	: Snapshot(InSnapshot)
+	, Filter(InFilter)
+	, Sort(InSort)
+	, Query(InQuery)
+{
+	// Candidates: matching names (prefix first) or every friend, in collation order if sorted.
+	TArray<int32> Candidates;
+	if (!Query.IsEmpty())
+	{
+		NameIndex.Search(Query, MAX_int32, Candidates);
+	}
+	else if (Sort != EFriendListSort::SORT_NONE)
+	{
+		Candidates = NameIndex.GetSortedRows();
+	}
+	else
+	{
+		Candidates.Reserve(Snapshot->Num());
+		for (int32 Row = 0; Row < Snapshot->Num(); Row++)
+		{
+			Candidates.Add(Row);
+		}
+	}
+
+	Rows.Reserve(Candidates.Num());
+	for (const int32 Row : Candidates)
+	{
+		if (PassesFilter(Row))
+		{
+			Rows.Add(Row);
+		}
+	}
+
+	// Search results keep their relevance order unless a sort is requested.
+	if (!Query.IsEmpty() && Sort != EFriendListSort::SORT_NONE)
+	{
+		Rows.Sort([this, &NameIndex](const int32 First, const int32 Second)
+			{
+				return NameIndex.GetCollationRank(CSteamID(Snapshot->SteamIDs[First]).GetAccountID()) < NameIndex.GetCollationRank(CSteamID(Snapshot->SteamIDs[Second]).GetAccountID());
+			}
+		);
+	}
+
+	// Stable: online friends keep collation order among them, same for offline ones.
+	if (Sort == EFriendListSort::SORT_ONLINE_FIRST)
+	{
+		Rows.StableSort([this](const int32 First, const int32 Second)
+			{
+				const bool bFirstOnline = Snapshot->PersonaStates[First] != EFriendPersonaState::PERSONA_OFFLINE;
+				const bool bSecondOnline = Snapshot->PersonaStates[Second] != EFriendPersonaState::PERSONA_OFFLINE;
+				return bFirstOnline && !bSecondOnline;
+			}
+		);
+	}
+}
+
+bool FFriendListView::Matches(const uint32 Version, const EFriendListFilter OtherFilter, const EFriendListSort OtherSort, const FString& OtherQuery) const
+{
+	return Snapshot->Version == Version && Filter == OtherFilter && Sort == OtherSort && Query.Equals(OtherQuery, ESearchCase::IgnoreCase);
+}
+
+int32 FFriendListView::Num() const
+{
+	return Rows.Num();
+}
+
+int32 FFriendListView::GetSnapshotRow(const int32 Index) const
+{
+	return Rows.IsValidIndex(Index) ? Rows[Index] : INDEX_NONE;
+}
+
+const FFriendListSnapshot& FFriendListView::GetSnapshot() const
+{
+	return *Snapshot;
+}
+
+bool FFriendListView::PassesFilter(const int32 SnapshotRow) const
+{
+	switch (Filter)
+	{
+	case EFriendListFilter::FILTER_ONLINE:
+		return Snapshot->PersonaStates[SnapshotRow] != EFriendPersonaState::PERSONA_OFFLINE;
+	case EFriendListFilter::FILTER_PLAYING_THIS_GAME:
+		return Snapshot->PlayingThisGame[SnapshotRow];
+	default:
+		return true;
+	}
+}
@@ -0,0 +1,142 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#include "FriendNameIndex.h"
+#include "FriendListSnapshot.h"
+#include "PNetworking.h"
+
+FFriendNameIndex::FFriendNameIndex(const FFriendListSnapshot& Snapshot)
+	: Version(Snapshot.Version)
+{
+	const int32 NumRows = Snapshot.Num();
+
+	// Locale aware comparisons are expensive: they are done only here, once per snapshot.
+	SortedRows.Reserve(NumRows);
+	for (int32 Row = 0; Row < NumRows; Row++)
+	{
+		SortedRows.Add(Row);
+	}
+
+	SortedRows.StableSort([&Snapshot](const int32 First, const int32 Second)
+		{
+			return Snapshot.UserNames[First].CompareTo(Snapshot.UserNames[Second]) < 0;
+		}
+	);
+
+	FoldedNames.Reserve(NumRows);
+	RankByAccountID.Reserve(NumRows);
+
+	for (int32 Rank = 0; Rank < NumRows; Rank++)
+	{
+		const int32 Row = SortedRows[Rank];
+		RankByAccountID.Add(CSteamID(Snapshot.SteamIDs[Row]).GetAccountID(), Rank);
+
+		const FString& FoldedName = FoldedNames.Add_GetRef(Snapshot.UserNames[Row].ToString().ToLower());
+
+		// Ranks are visited in order, so posting lists stay sorted.
+		for (int32 Start = 0; Start < FoldedName.Len(); Start++)
+		{
+			for (int32 Length = 1; Length <= FRIEND_NAME_INDEX_MAX_GRAM && Start + Length <= FoldedName.Len(); Length++)
+			{
+				TArray<int32>& Posting = Postings.FindOrAdd(MakeGramKey(&FoldedName[Start], Length));
+				if (Posting.Num() == 0 || Posting.Last() != Rank)
+				{
+					Posting.Add(Rank);
+				}
+			}
+		}
+	}
+
+	for (TPair<uint64, TArray<int32>>& Pair : Postings)
+	{
+		Pair.Value.Shrink();
+	}
+}
+
+uint32 FFriendNameIndex::GetVersion() const
+{
+	return Version;
+}
+
+int32 FFriendNameIndex::GetCollationRank(const uint32 AccountID) const
+{
+	const int32* Rank = RankByAccountID.Find(AccountID);
+	return Rank ? *Rank : INDEX_NONE;
+}
+
+void FFriendNameIndex::Search(const FString& Query, const int32 MaxResults, TArray<int32>& OutSnapshotRows) const
+{
+	OutSnapshotRows.Reset();
+
+	const FString FoldedQuery = Query.ToLower();
+	if (FoldedQuery.IsEmpty() || MaxResults <= 0)
+	{
+		return;
+	}
+
+	// Rarest gram of the query: the smallest candidates list.
+	const TArray<int32>* Candidates = nullptr;
+	const int32 GramLength = FMath::Min(FoldedQuery.Len(), FRIEND_NAME_INDEX_MAX_GRAM);
+	for (int32 Start = 0; Start + GramLength <= FoldedQuery.Len(); Start++)
+	{
+		const TArray<int32>* Posting = Postings.Find(MakeGramKey(&FoldedQuery[Start], GramLength));
+		if (!Posting)
+		{
+			// A gram no name contains: no result.
+			return;
+		}
+
+		if (!Candidates || Posting->Num() < Candidates->Num())
+		{
+			Candidates = Posting;
+		}
+	}
+
+	if (!Candidates)
+	{
+		return;
+	}
+
+	// Short queries are exact grams: candidates need no verification.
+	const bool bNeedsVerification = FoldedQuery.Len() > FRIEND_NAME_INDEX_MAX_GRAM;
+
+	TArray<int32, TInlineAllocator<32>> InfixRanks;
+	for (const int32 Rank : *Candidates)
+	{
+		const FString& FoldedName = FoldedNames[Rank];
+		if (FoldedName.StartsWith(FoldedQuery, ESearchCase::CaseSensitive))
+		{
+			OutSnapshotRows.Add(SortedRows[Rank]);
+			if (OutSnapshotRows.Num() >= MaxResults)
+			{
+				return;
+			}
+		}
+		else if (InfixRanks.Num() < MaxResults && (!bNeedsVerification || FoldedName.Contains(FoldedQuery, ESearchCase::CaseSensitive)))
+		{
+			InfixRanks.Add(Rank);
+		}
+	}
+
+	for (int32 Index = 0; Index < InfixRanks.Num() && OutSnapshotRows.Num() < MaxResults; Index++)
+	{
+		OutSnapshotRows.Add(SortedRows[InfixRanks[Index]]);
+	}
+}
+
+const TArray<int32>& FFriendNameIndex::GetSortedRows() const
+{
+	return SortedRows;
+}
+
+uint64 FFriendNameIndex::MakeGramKey(const TCHAR* Chars, const int32 Length)
+{
+	// Up to 3 UTF-16 units, plus the length so grams of different size never collide.
+	uint64 Key = static_cast<uint64>(Length) << 48;
+	for (int32 Index = 0; Index < Length; Index++)
+	{
+		Key |= static_cast<uint64>(static_cast<uint16>(Chars[Index])) << (Index * 16);
+	}
+	return Key;
+}
@@ -0,0 +1,536 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#include "FriendRoster.h"
+#include "FriendListSnapshot.h"
+#include "PNetworking.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Memory/MemoryView.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+bool FFriendRosterEntry::HasSameData(const FFriendRosterEntry& Other) const
+{
+	return SteamID == Other.SteamID
+		&& PersonaState == Other.PersonaState
+		&& bIsPlayingThisGame == Other.bIsPlayingThisGame
+		&& RichPresenceStatus == Other.RichPresenceStatus
+		&& AvatarHandle == Other.AvatarHandle
+		&& UserName.EqualTo(Other.UserName);
+}
+
+FFriendRoster::FFriendRoster()
+	: NumOnlineEntries(0)
+	, Version(1)
+	, BroadcastVersion(1)
+	, LocalSteamID(0)
+	, ReconcileIndex(0)
+	, DirtySteamIDs(MakeShared<FDirtyQueue, ESPMode::ThreadSafe>())
+{
+}
+
+FFriendRoster::~FFriendRoster()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+
+	TSharedPtr<SteamAPICallbackManager> PinnedManager = SteamAPIManager.Pin();
+	if (PinnedManager.IsValid())
+	{
+		PinnedManager->OnPersonaStateChanged.Remove(PersonaStateChangedHandle);
+		PinnedManager->OnRichPresenceUpdated.Remove(RichPresenceUpdatedHandle);
+	}
+}
+
+bool FFriendRoster::Initialize()
+{
+	check(IsInGameThread());
+
+	ISteamFriends* SteamFriendsInterface = SteamFriends();
+	TSharedPtr<SteamAPICallbackManager> PinnedManager = FPNetworkingModule::GetSteamAPIManager();
+	if (!SteamFriendsInterface || !PinnedManager.IsValid())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FFriendRoster: SteamFriendsInterface steamworks_sdk not valid!"));
+		return false;
+	}
+
+	// Roster of another account (e.g. shared PC) must never be served.
+	ISteamUser* SteamUserInterface = SteamUser();
+	LocalSteamID = SteamUserInterface ? SteamUserInterface->GetSteamID().ConvertToUint64() : 0;
+
+	// Listen before reading, so changes happening while seeding are not lost (they are just read twice).
+	SteamAPIManager = PinnedManager;
+	PersonaStateChangedHandle = PinnedManager->OnPersonaStateChanged.AddLambda([DirtySteamIDs = DirtySteamIDs](uint64 SteamID, int32 ChangeFlags)
+		{
+			DirtySteamIDs->Enqueue(SteamID);
+		}
+	);
+	RichPresenceUpdatedHandle = PinnedManager->OnRichPresenceUpdated.AddLambda([DirtySteamIDs = DirtySteamIDs](uint64 SteamID)
+		{
+			DirtySteamIDs->Enqueue(SteamID);
+		}
+	);
+
+	TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FFriendRoster::Tick));
+
+	// Last run roster is served immediately: SteamAPI is read in the next frames.
+	if (LoadPersisted())
+	{
+		BeginReconcile();
+		UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("FFriendRoster: Loaded %d friends of last run, reconciling"), Entries.Num());
+		return true;
+	}
+
+	const int32 FriendsCount = SteamFriendsInterface->GetFriendCount(k_EFriendFlagImmediate);
+	Entries.Reserve(FriendsCount);
+	SteamIDs.Reserve(FriendsCount);
+	IndexBySteamID.Reserve(FriendsCount);
+	EntryVersions.Reserve(FriendsCount);
+
+	for (int32 Index = 0; Index < FriendsCount; Index++)
+	{
+		const CSteamID FriendSteamID = SteamFriendsInterface->GetFriendByIndex(Index, k_EFriendFlagImmediate);
+
+		FFriendRosterEntry Entry;
+		if (ReadEntry(FriendSteamID, Entry))
+		{
+			AddEntry(FriendSteamID.ConvertToUint64(), MoveTemp(Entry));
+		}
+	}
+
+	UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("FFriendRoster: Seeded with %d friends, %d online"), Entries.Num(), NumOnlineEntries);
+	return true;
+}
+
+bool FFriendRoster::Save(TFunctionRef<uint32(uint64)> GetAvatarHash) const
+{
+	const FString FilePath = GetFilePath();
+	if (FilePath.IsEmpty())
+	{
+		return false;
+	}
+
+	// Entries not reconciled yet are still last run data: saving them is still correct.
+	TArray<uint8> Buffer;
+	FMemoryWriter Writer(Buffer);
+
+	uint32 Magic = FRIEND_ROSTER_FILE_MAGIC;
+	uint32 FileVersion = FRIEND_ROSTER_FILE_VERSION;
+	int32 NumEntries = FMath::Min(Entries.Num(), FRIEND_ROSTER_FILE_MAX_ENTRIES);
+	Writer << Magic << FileVersion << NumEntries;
+
+	for (int32 Index = 0; Index < NumEntries; Index++)
+	{
+		const FFriendRosterEntry& Entry = Entries[Index];
+		uint64 SteamID = SteamIDs[Index];
+		FString UserName = Entry.UserName.ToString();
+		uint8 PersonaState = static_cast<uint8>(Entry.PersonaState);
+		uint8 bIsPlayingThisGame = Entry.bIsPlayingThisGame ? 1 : 0;
+		FString RichPresenceStatus = Entry.RichPresenceStatus;
+		uint32 AvatarHash = GetAvatarHash(SteamID);
+		Writer << SteamID << UserName << PersonaState << bIsPlayingThisGame << RichPresenceStatus << AvatarHash;
+	}
+
+	const FString TempPath = FilePath + TEXT(".tmp");
+	if (!FFileHelper::SaveArrayToFile(Buffer, *TempPath) || !IFileManager::Get().Move(*FilePath, *TempPath, true, true))
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FFriendRoster: Can't write %s!"), *FilePath);
+		IFileManager::Get().Delete(*TempPath);
+		return false;
+	}
+
+	UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("FFriendRoster: Saved %d friends"), NumEntries);
+	return true;
+}
+
+void FFriendRoster::ValidateAvatarHashes(TFunctionRef<uint32(uint64)> GetAvatarHash)
+{
+	for (auto It = PersistedAvatarHashes.CreateIterator(); It; ++It)
+	{
+		// Avatar on disk changed or dropped since the roster was saved: not the one of last run.
+		if (GetAvatarHash(It.Key()) != It.Value())
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void FFriendRoster::UpdateAvatarHash(const uint64 SteamID, const uint32 Hash)
+{
+	uint32 PersistedHash = 0;
+	if (!PersistedAvatarHashes.RemoveAndCopyValue(SteamID, PersistedHash) || PersistedHash == Hash)
+	{
+		return;
+	}
+
+	const int32* Index = IndexBySteamID.Find(SteamID);
+	if (!Index)
+	{
+		return;
+	}
+
+	// Avatar changed while the game was closed: notified by next Tick.
+	Version++;
+	EntryVersions[*Index] = Version;
+	OnUpdated.Broadcast(Entries[*Index]);
+}
+
+bool FFriendRoster::IsReconciling() const
+{
+	return ReconcileIndex < ReconcileQueue.Num();
+}
+
+const TArray<FFriendRosterEntry>& FFriendRoster::GetEntries() const
+{
+	return Entries;
+}
+
+uint64 FFriendRoster::GetSteamID64(const int32 Index) const
+{
+	return SteamIDs.IsValidIndex(Index) ? SteamIDs[Index] : 0;
+}
+
+const FFriendRosterEntry* FFriendRoster::Find(const uint64 SteamID) const
+{
+	const int32* Index = IndexBySteamID.Find(SteamID);
+	return Index ? &Entries[*Index] : nullptr;
+}
+
+int32 FFriendRoster::Num() const
+{
+	return Entries.Num();
+}
+
+int32 FFriendRoster::NumOnline() const
+{
+	return NumOnlineEntries;
+}
+
+uint32 FFriendRoster::GetVersion() const
+{
+	return Version;
+}
+
+TSharedRef<const FFriendListSnapshot, ESPMode::ThreadSafe> FFriendRoster::GetSnapshot()
+{
+	if (CachedSnapshot.IsValid() && CachedSnapshot->Version == Version)
+	{
+		return CachedSnapshot.ToSharedRef();
+	}
+
+	TSharedRef<FFriendListSnapshot, ESPMode::ThreadSafe> Snapshot = MakeShared<FFriendListSnapshot, ESPMode::ThreadSafe>();
+	Snapshot->Version = Version;
+	Snapshot->SteamIDs = SteamIDs;
+	Snapshot->RowVersions = EntryVersions;
+	Snapshot->IndexBySteamID = IndexBySteamID;
+
+	const int32 NumEntries = Entries.Num();
+	Snapshot->UserNames.Reserve(NumEntries);
+	Snapshot->PersonaStates.Reserve(NumEntries);
+	Snapshot->PlayingThisGame.Reserve(NumEntries);
+	Snapshot->RichPresenceStatuses.Reserve(NumEntries);
+	Snapshot->AvatarHandles.Reserve(NumEntries);
+
+	for (const FFriendRosterEntry& Entry : Entries)
+	{
+		Snapshot->UserNames.Add(Entry.UserName);
+		Snapshot->PersonaStates.Add(Entry.PersonaState);
+		Snapshot->PlayingThisGame.Add(Entry.bIsPlayingThisGame);
+		Snapshot->RichPresenceStatuses.Add(Entry.RichPresenceStatus);
+		Snapshot->AvatarHandles.Add(Entry.AvatarHandle);
+	}
+
+	CachedSnapshot = Snapshot;
+	return Snapshot;
+}
+
+bool FFriendRoster::ReadEntry(const CSteamID SteamID, FFriendRosterEntry& OutEntry)
+{
+	ISteamFriends* SteamFriendsInterface = SteamFriends();
+	if (!SteamFriendsInterface || SteamFriendsInterface->GetFriendRelationship(SteamID) != k_EFriendRelationshipFriend)
+	{
+		return false;
+	}
+
+	OutEntry.SteamID = static_cast<int32>(SteamID.GetAccountID());
+	OutEntry.UserName = FText::FromString(FString(UTF8_TO_TCHAR(SteamFriendsInterface->GetFriendPersonaName(SteamID))));
+	OutEntry.PersonaState = static_cast<EFriendPersonaState>(FMath::Clamp<int32>(SteamFriendsInterface->GetFriendPersonaState(SteamID), 0, static_cast<int32>(EFriendPersonaState::PERSONA_INVISIBLE)));
+	OutEntry.RichPresenceStatus = FString(UTF8_TO_TCHAR(SteamFriendsInterface->GetFriendRichPresence(SteamID, "status")));
+	OutEntry.AvatarHandle = SteamFriendsInterface->GetSmallFriendAvatar(SteamID);
+
+	FriendGameInfo_t GameInfo;
+	ISteamUtils* SteamUtilsInterface = SteamUtils();
+	OutEntry.bIsPlayingThisGame = SteamUtilsInterface && SteamFriendsInterface->GetFriendGamePlayed(SteamID, &GameInfo) && GameInfo.m_gameID.AppID() == SteamUtilsInterface->GetAppID();
+
+	return true;
+}
+
+bool FFriendRoster::Tick(float DeltaTime)
+{
+	const bool bWasReconciling = IsReconciling();
+	if (DirtySteamIDs->IsEmpty() && !bWasReconciling && Version == BroadcastVersion)
+	{
+		return true;
+	}
+
+	// Bursts (e.g. login, many status changes) name the same friend many times: read it once.
+	if (!DirtySteamIDs->IsEmpty())
+	{
+		TSet<uint64> ChangedSteamIDs;
+		uint64 SteamID = 0;
+		while (DirtySteamIDs->Dequeue(SteamID))
+		{
+			ChangedSteamIDs.Add(SteamID);
+		}
+
+		for (const uint64 ChangedSteamID : ChangedSteamIDs)
+		{
+			Refresh(ChangedSteamID);
+		}
+	}
+
+	if (bWasReconciling)
+	{
+		ReconcileStep();
+	}
+
+	// Removals of BeginReconcile happen before the first Tick: they are notified here too.
+	if (Version != BroadcastVersion)
+	{
+		BroadcastVersion = Version;
+		OnVersionChanged.Broadcast();
+	}
+
+	if (bWasReconciling && !IsReconciling())
+	{
+		ReconcileQueue.Empty();
+		ReconcileIndex = 0;
+
+		UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("FFriendRoster: Reconciled with %d friends, %d online"), Entries.Num(), NumOnlineEntries);
+		OnReconciled.Broadcast();
+	}
+
+	return true;
+}
+
+bool FFriendRoster::LoadPersisted()
+{
+	const FString FilePath = GetFilePath();
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if (FilePath.IsEmpty() || !PlatformFile.FileExists(*FilePath))
+	{
+		return false;
+	}
+
+	// Mapping is needed only while parsing: names are copied into FText.
+	TUniquePtr<IMappedFileHandle> MappedFile(PlatformFile.OpenMapped(*FilePath));
+	TUniquePtr<IMappedFileRegion> MappedRegion(MappedFile.IsValid() && MappedFile->GetFileSize() > 0 ? MappedFile->MapRegion(0, MappedFile->GetFileSize()) : nullptr);
+	if (!MappedRegion.IsValid())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FFriendRoster: Can't map %s!"), *FilePath);
+		return false;
+	}
+
+	FMemoryReaderView Reader(FMemoryView(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize()));
+
+	uint32 Magic = 0;
+	uint32 FileVersion = 0;
+	int32 NumEntries = 0;
+	Reader << Magic << FileVersion << NumEntries;
+
+	if (Magic != FRIEND_ROSTER_FILE_MAGIC || FileVersion != FRIEND_ROSTER_FILE_VERSION || NumEntries < 0 || NumEntries > FRIEND_ROSTER_FILE_MAX_ENTRIES)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FFriendRoster: Invalid roster file, ignored!"));
+		return false;
+	}
+
+	Entries.Reserve(NumEntries);
+	SteamIDs.Reserve(NumEntries);
+	IndexBySteamID.Reserve(NumEntries);
+	EntryVersions.Reserve(NumEntries);
+
+	for (int32 Index = 0; Index < NumEntries; Index++)
+	{
+		uint64 SteamID = 0;
+		FString UserName;
+		uint8 PersonaState = 0;
+		uint8 bIsPlayingThisGame = 0;
+		FString RichPresenceStatus;
+		uint32 AvatarHash = 0;
+		Reader << SteamID << UserName << PersonaState << bIsPlayingThisGame << RichPresenceStatus << AvatarHash;
+
+		if (Reader.IsError())
+		{
+			break;
+		}
+
+		if (IndexBySteamID.Contains(SteamID))
+		{
+			continue;
+		}
+
+		// Avatar handles are valid only in the SteamAPI session that made them: 0 until reconciled.
+		// Pixels are served meanwhile by AvatarDiskCache, under the same hash.
+		FFriendRosterEntry Entry;
+		Entry.SteamID = static_cast<int32>(CSteamID(SteamID).GetAccountID());
+		Entry.UserName = FText::FromString(MoveTemp(UserName));
+		Entry.PersonaState = static_cast<EFriendPersonaState>(FMath::Min<uint8>(PersonaState, static_cast<uint8>(EFriendPersonaState::PERSONA_INVISIBLE)));
+		Entry.bIsPlayingThisGame = bIsPlayingThisGame != 0;
+		Entry.RichPresenceStatus = MoveTemp(RichPresenceStatus);
+		Entry.AvatarHandle = 0;
+
+		if (AvatarHash != 0)
+		{
+			PersistedAvatarHashes.Add(SteamID, AvatarHash);
+		}
+
+		AddEntry(SteamID, MoveTemp(Entry));
+	}
+
+	if (Reader.IsError())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FFriendRoster: Truncated roster file, %d friends kept!"), Entries.Num());
+	}
+
+	return Entries.Num() > 0;
+}
+
+void FFriendRoster::BeginReconcile()
+{
+	ISteamFriends* SteamFriendsInterface = SteamFriends();
+	if (!SteamFriendsInterface)
+	{
+		return;
+	}
+
+	// Friendlist itself is local to SteamAPI and cheap: only per friend reads are spread over frames.
+	const int32 FriendsCount = SteamFriendsInterface->GetFriendCount(k_EFriendFlagImmediate);
+	TSet<uint64> LiveSteamIDs;
+	LiveSteamIDs.Reserve(FriendsCount);
+	ReconcileQueue.Reset(FriendsCount);
+	ReconcileIndex = 0;
+
+	for (int32 Index = 0; Index < FriendsCount; Index++)
+	{
+		const uint64 SteamID = SteamFriendsInterface->GetFriendByIndex(Index, k_EFriendFlagImmediate).ConvertToUint64();
+		LiveSteamIDs.Add(SteamID);
+		ReconcileQueue.Add(SteamID);
+	}
+
+	// Removed while the game was closed.
+	for (int32 Index = SteamIDs.Num() - 1; Index >= 0; Index--)
+	{
+		if (!LiveSteamIDs.Contains(SteamIDs[Index]))
+		{
+			RemoveEntry(SteamIDs[Index]);
+		}
+	}
+}
+
+void FFriendRoster::ReconcileStep()
+{
+	const int32 LastIndex = FMath::Min(ReconcileIndex + FRIEND_ROSTER_RECONCILE_PER_TICK, ReconcileQueue.Num());
+	for (; ReconcileIndex < LastIndex; ReconcileIndex++)
+	{
+		Refresh(ReconcileQueue[ReconcileIndex]);
+	}
+}
+
+FString FFriendRoster::GetFilePath() const
+{
+	if (LocalSteamID == 0)
+	{
+		return FString();
+	}
+
+	return FPaths::Combine(FPaths::ProjectSavedDir(), FString::Printf(FRIEND_ROSTER_FILE_NAME, LocalSteamID));
+}
+
+void FFriendRoster::Refresh(const uint64 SteamID)
+{
+	FFriendRosterEntry NewEntry;
+	const bool bIsFriend = ReadEntry(CSteamID(SteamID), NewEntry);
+	const int32* Index = IndexBySteamID.Find(SteamID);
+
+	if (!bIsFriend)
+	{
+		// Not a friend anymore, or just a user met somewhere else (e.g. lobby member).
+		if (Index)
+		{
+			RemoveEntry(SteamID);
+		}
+		return;
+	}
+
+	if (!Index)
+	{
+		Version++;
+		AddEntry(SteamID, MoveTemp(NewEntry));
+		OnAdded.Broadcast(Entries.Last());
+		return;
+	}
+
+	FFriendRosterEntry& Entry = Entries[*Index];
+
+	// Persisted entries have no avatar handle yet: snapshots must get it, so the version changes.
+	// If the avatar served from disk is the persisted one, the row itself is unchanged and its avatar is not refreshed.
+	bool bIsAvatarChanged = false;
+	if (Entry.AvatarHandle == 0 && NewEntry.AvatarHandle != 0)
+	{
+		Entry.AvatarHandle = NewEntry.AvatarHandle;
+		bIsAvatarChanged = !PersistedAvatarHashes.Contains(SteamID);
+		Version++;
+	}
+
+	if (Entry.HasSameData(NewEntry) && !bIsAvatarChanged)
+	{
+		return;
+	}
+
+	NumOnlineEntries += (NewEntry.IsOnline() ? 1 : 0) - (Entry.IsOnline() ? 1 : 0);
+	Entry = MoveTemp(NewEntry);
+
+	Version++;
+	EntryVersions[*Index] = Version;
+	OnUpdated.Broadcast(Entry);
+}
+
+void FFriendRoster::AddEntry(const uint64 SteamID, FFriendRosterEntry&& Entry)
+{
+	NumOnlineEntries += Entry.IsOnline() ? 1 : 0;
+	IndexBySteamID.Add(SteamID, Entries.Num());
+	SteamIDs.Add(SteamID);
+	EntryVersions.Add(Version);
+	Entries.Add(MoveTemp(Entry));
+}
+
+void FFriendRoster::RemoveEntry(const uint64 SteamID)
+{
+	int32 Index = INDEX_NONE;
+	if (!IndexBySteamID.RemoveAndCopyValue(SteamID, Index))
+	{
+		return;
+	}
+
+	const int32 AccountID = Entries[Index].SteamID;
+	NumOnlineEntries -= Entries[Index].IsOnline() ? 1 : 0;
+	PersistedAvatarHashes.Remove(SteamID);
+
+	// Last entry takes the removed place.
+	const int32 LastIndex = Entries.Num() - 1;
+	if (Index != LastIndex)
+	{
+		IndexBySteamID[SteamIDs[LastIndex]] = Index;
+	}
+
+	Entries.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	SteamIDs.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	EntryVersions.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Version++;
+
+	OnRemoved.Broadcast(AccountID);
+}
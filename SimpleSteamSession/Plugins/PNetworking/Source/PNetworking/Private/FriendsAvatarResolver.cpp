@@ -0,0 +1,268 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#include "FriendsAvatarResolver.h"
+#include "AvatarPipeline.h"
+#include "PNetworking.h"
+#include "Async/Async.h"
+#include "Engine/Texture2D.h"
+
+FFriendsAvatarResolver::FFriendsAvatarResolver(TSharedPtr<FAvatarPipeline> InAvatarPipeline, const TArray<CSteamID>& InSteamIDs, const EAvatarSize InAvatarSize, FOnFriendsAvatarResolved InOnComplete)
+	: AvatarPipeline(InAvatarPipeline)
+	, AvatarSize(InAvatarSize)
+	, PendingTextures(0)
+	, bIsStarting(false)
+	, bIsComplete(false)
+	, OnComplete(MoveTemp(InOnComplete))
+{
+	SteamIDs.Reserve(InSteamIDs.Num());
+	for (const CSteamID& SteamID : InSteamIDs)
+	{
+		SteamIDs.Add(SteamID.ConvertToUint64());
+	}
+
+	Textures.SetNum(SteamIDs.Num());
+}
+
+FFriendsAvatarResolver::FFriendsAvatarResolver(TSharedPtr<FAvatarPipeline> InAvatarPipeline, TSharedPtr<FAvatarAtlas> InAvatarAtlas, const TArray<CSteamID>& InSteamIDs, const EAvatarSize InAvatarSize, FOnFriendsAvatarAtlasResolved InOnAtlasComplete)
+	: AvatarPipeline(InAvatarPipeline)
+	, AvatarAtlas(InAvatarAtlas)
+	, AvatarSize(InAvatarSize)
+	, PendingTextures(0)
+	, bIsStarting(false)
+	, bIsComplete(false)
+	, OnAtlasComplete(MoveTemp(InOnAtlasComplete))
+{
+	SteamIDs.Reserve(InSteamIDs.Num());
+	for (const CSteamID& SteamID : InSteamIDs)
+	{
+		SteamIDs.Add(SteamID.ConvertToUint64());
+	}
+
+	Slots.SetNum(SteamIDs.Num());
+}
+
+FFriendsAvatarResolver::~FFriendsAvatarResolver()
+{
+	if (TimeoutHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TimeoutHandle);
+	}
+}
+
+bool FFriendsAvatarResolver::Start(const float TimeoutSeconds)
+{
+	if (!AvatarPipeline.IsValid())
+	{
+		TryComplete(true);
+		return true;
+	}
+
+	bIsStarting = true;
+
+	for (int32 Index = 0; Index < SteamIDs.Num(); Index++)
+	{
+		const int32 AvatarHandle = FAvatarPipeline::GetAvatarHandle(CSteamID(SteamIDs[Index]), AvatarSize);
+
+		if (AvatarHandle == -1)
+		{
+			// Avatar of a previous session, shown while SteamAPI downloads the live one.
+			if (!RequestPersistedTexture(Index))
+			{
+				PendingHandles.Add(SteamIDs[Index], Index);
+				AddAvatarWaiter(SteamIDs[Index]);
+			}
+		}
+		else if (AvatarHandle != 0)
+		{
+			RequestTexture(Index, AvatarHandle);
+		}
+	}
+
+	bIsStarting = false;
+	TryComplete();
+
+	if (!bIsComplete && TimeoutSeconds > 0.f)
+	{
+		TimeoutHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateSP(this, &FFriendsAvatarResolver::OnTimeout), TimeoutSeconds);
+	}
+
+	return bIsComplete;
+}
+
+void FFriendsAvatarResolver::OnAvatarImageLoaded(const uint64 SteamID)
+{
+	if (bIsComplete)
+	{
+		return;
+	}
+
+	int32 Index = INDEX_NONE;
+	if (!PendingHandles.RemoveAndCopyValue(SteamID, Index))
+	{
+		// Not one of ours, or already requested.
+		return;
+	}
+
+	const int32 AvatarHandle = FAvatarPipeline::GetAvatarHandle(CSteamID(SteamID), AvatarSize);
+	if (AvatarHandle == -1)
+	{
+		PendingHandles.Add(SteamID, Index);
+		AddAvatarWaiter(SteamID);
+		return;
+	}
+
+	if (AvatarHandle != 0)
+	{
+		RequestTexture(Index, AvatarHandle);
+	}
+
+	TryComplete();
+}
+
+bool FFriendsAvatarResolver::IsComplete() const
+{
+	return bIsComplete;
+}
+
+int32 FFriendsAvatarResolver::GetNumOutstanding() const
+{
+	return PendingHandles.Num() + PendingTextures;
+}
+
+void FFriendsAvatarResolver::RequestTexture(const int32 Index, const int32 AvatarHandle)
+{
+	PendingTextures++;
+
+	if (AvatarAtlas.IsValid())
+	{
+		AvatarAtlas->RequestSlot(CSteamID(SteamIDs[Index]), AvatarHandle, AvatarSize, FOnAvatarAtlasSlotReady::CreateSP(this, &FFriendsAvatarResolver::OnSlotReady, Index));
+		return;
+	}
+
+	AvatarPipeline->RequestTexture(CSteamID(SteamIDs[Index]), AvatarHandle, AvatarSize, FOnAvatarPipelineComplete::CreateSP(this, &FFriendsAvatarResolver::OnTextureReady, Index));
+}
+
+void FFriendsAvatarResolver::AddAvatarWaiter(const uint64 SteamID)
+{
+	if (!FPNetworkingModule::GetSteamAPIManager().IsValid())
+	{
+		return;
+	}
+
+	// Waiter is dropped by the manager once this resolver is destroyed. Fired on SteamAPI thread.
+	FPNetworkingModule::GetSteamAPIManager()->AddAvatarWaiter(CSteamID(SteamID), FOnAvatarReadyFromSteamAPI::CreateSPLambda(this, [WeakThis = AsWeak(), SteamID](AvatarImageLoaded_t* pCallback)
+		{
+			AsyncTask(ENamedThreads::GameThread, [WeakThis, SteamID]()
+				{
+					TSharedPtr<FFriendsAvatarResolver> PinnedThis = WeakThis.Pin();
+					if (PinnedThis.IsValid())
+					{
+						PinnedThis->OnAvatarImageLoaded(SteamID);
+					}
+				}
+			);
+		}
+	));
+}
+
+bool FFriendsAvatarResolver::RequestPersistedTexture(const int32 Index)
+{
+	// Atlas cells are filled from live pixels only.
+	if (AvatarAtlas.IsValid())
+	{
+		return false;
+	}
+
+	PendingTextures++;
+
+	if (AvatarPipeline->RequestPersistedTexture(CSteamID(SteamIDs[Index]), AvatarSize, FOnAvatarPipelineComplete::CreateSP(this, &FFriendsAvatarResolver::OnTextureReady, Index)))
+	{
+		return true;
+	}
+
+	PendingTextures--;
+	return false;
+}
+
+void FFriendsAvatarResolver::OnTextureReady(UTexture2D* Texture, const int32 Index)
+{
+	PendingTextures--;
+
+	if (bIsComplete)
+	{
+		return;
+	}
+
+	Textures[Index].Reset(Texture);
+	OnItemReady();
+}
+
+void FFriendsAvatarResolver::OnSlotReady(const FAvatarAtlasSlot& Slot, const int32 Index)
+{
+	PendingTextures--;
+
+	if (bIsComplete)
+	{
+		return;
+	}
+
+	Slots[Index] = Slot;
+	OnItemReady();
+}
+
+void FFriendsAvatarResolver::OnItemReady()
+{
+	// While starting, completion is checked once every request has been sent.
+	if (!bIsStarting)
+	{
+		TryComplete();
+	}
+}
+
+bool FFriendsAvatarResolver::OnTimeout(float DeltaTime)
+{
+	TimeoutHandle.Reset();
+
+	if (!bIsComplete)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FFriendsAvatarResolver: Timeout, %d avatars still missing!"), GetNumOutstanding());
+		TryComplete(true);
+	}
+
+	// One shot.
+	return false;
+}
+
+void FFriendsAvatarResolver::TryComplete(const bool bForce)
+{
+	if (bIsComplete || (!bForce && GetNumOutstanding() > 0))
+	{
+		return;
+	}
+
+	bIsComplete = true;
+	PendingHandles.Empty();
+
+	if (TimeoutHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TimeoutHandle);
+		TimeoutHandle.Reset();
+	}
+
+	if (AvatarAtlas.IsValid())
+	{
+		OnAtlasComplete.ExecuteIfBound(Slots);
+		return;
+	}
+
+	TArray<UTexture2D*> ResolvedTextures;
+	ResolvedTextures.Reserve(Textures.Num());
+	for (const TStrongObjectPtr<UTexture2D>& Texture : Textures)
+	{
+		ResolvedTextures.Add(Texture.Get());
+	}
+
+	OnComplete.ExecuteIfBound(ResolvedTextures);
+}
@@ -0,0 +1,102 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#include "FriendsGroupIndex.h"
+#include "PNetworking.h"
+
+FFriendsGroupIndex::FFriendsGroupIndex()
+	: BuildTime(0.0)
+{
+}
+
+bool FFriendsGroupIndex::Rebuild()
+{
+	check(IsInGameThread());
+
+	ISteamFriends* SteamFriendsInterface = SteamFriends();
+	if (!SteamFriendsInterface)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FFriendsGroupIndex: SteamFriendsInterface steamworks_sdk not valid!"));
+		return false;
+	}
+
+	const int32 GroupsCount = SteamFriendsInterface->GetFriendsGroupCount();
+
+	Groups.Reset(GroupsCount);
+	Members.Reset(GroupsCount);
+	IndexByGroupID.Reset();
+	GroupsBySteamID.Reset();
+
+	// Member lists are read in one call per group, reusing the same buffer.
+	TArray<CSteamID> MembersBuffer;
+
+	for (int32 Index = 0; Index < GroupsCount; Index++)
+	{
+		const FriendsGroupID_t GroupID = SteamFriendsInterface->GetFriendsGroupIDByIndex(Index);
+		if (GroupID == k_FriendsGroupID_Invalid)
+		{
+			continue;
+		}
+
+		const int32 MembersCount = SteamFriendsInterface->GetFriendsGroupMembersCount(GroupID);
+		MembersBuffer.SetNumUninitialized(MembersCount, EAllowShrinking::No);
+		if (MembersCount > 0)
+		{
+			SteamFriendsInterface->GetFriendsGroupMembersList(GroupID, MembersBuffer.GetData(), MembersCount);
+		}
+
+		FFriendsGroup& Group = Groups.AddDefaulted_GetRef();
+		Group.GroupID = GroupID;
+		Group.Name = FString(UTF8_TO_TCHAR(SteamFriendsInterface->GetFriendsGroupName(GroupID)));
+		Group.NumMembers = MembersCount;
+
+		IndexByGroupID.Add(GroupID, Members.Num());
+		TArray<uint64>& GroupMembers = Members.AddDefaulted_GetRef();
+		GroupMembers.Reserve(MembersCount);
+
+		for (const CSteamID& Member : MembersBuffer)
+		{
+			const uint64 SteamID = Member.ConvertToUint64();
+			GroupMembers.Add(SteamID);
+			GroupsBySteamID.FindOrAdd(SteamID).Add(GroupID);
+		}
+	}
+
+	BuildTime = FPlatformTime::Seconds();
+
+	UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("FFriendsGroupIndex: Indexed %d groups, %d grouped friends"), Groups.Num(), GroupsBySteamID.Num());
+	return true;
+}
+
+bool FFriendsGroupIndex::IsStale() const
+{
+	return BuildTime == 0.0 || FPlatformTime::Seconds() - BuildTime > FRIENDS_GROUP_INDEX_TTL;
+}
+
+void FFriendsGroupIndex::MarkDirty()
+{
+	BuildTime = 0.0;
+}
+
+const TArray<FFriendsGroup>& FFriendsGroupIndex::GetGroups() const
+{
+	return Groups;
+}
+
+const TArray<uint64>* FFriendsGroupIndex::GetMembers(const int32 GroupID) const
+{
+	const int32* Index = IndexByGroupID.Find(GroupID);
+	return Index ? &Members[*Index] : nullptr;
+}
+
+TConstArrayView<int32> FFriendsGroupIndex::GetGroupsOf(const uint64 SteamID) const
+{
+	const TArray<int32, TInlineAllocator<2>>* SteamIDGroups = GroupsBySteamID.Find(SteamID);
+	return SteamIDGroups ? TConstArrayView<int32>(*SteamIDGroups) : TConstArrayView<int32>();
+}
+
+bool FFriendsGroupIndex::IsMember(const uint64 SteamID, const int32 GroupID) const
+{
+	return GetGroupsOf(SteamID).Contains(GroupID);
+}
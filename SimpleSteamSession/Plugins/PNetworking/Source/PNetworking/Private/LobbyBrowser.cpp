@@ -0,0 +1,425 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#include "LobbyBrowser.h"
+#include "PNetworking.h"
+#include "Algo/StableSort.h"
+
+FLobbyBrowser::FLobbyBrowser()
+	: NextSearchID(1)
+	, NextCallTag(1)
+	, MatchLists(MakeShared<FMatchListQueue, ESPMode::ThreadSafe>())
+	, LobbyDataUpdates(MakeShared<FLobbyDataQueue, ESPMode::ThreadSafe>())
+{
+}
+
+FLobbyBrowser::~FLobbyBrowser()
+{
+	// Call results unregister themselves. Their handlers never touch the browser, only the shared queue.
+	PendingCalls.Empty();
+	FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+
+	TSharedPtr<SteamAPICallbackManager> PinnedManager = SteamAPIManager.Pin();
+	if (PinnedManager.IsValid())
+	{
+		PinnedManager->OnLobbyDataUpdated.Remove(LobbyDataUpdatedHandle);
+	}
+}
+
+bool FLobbyBrowser::Initialize()
+{
+	check(IsInGameThread());
+
+	TSharedPtr<SteamAPICallbackManager> PinnedManager = FPNetworkingModule::GetSteamAPIManager();
+	if (!SteamMatchmaking() || !PinnedManager.IsValid())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FLobbyBrowser: SteamMatchmakingInterface steamworks_sdk not valid!"));
+		return false;
+	}
+
+	SteamAPIManager = PinnedManager;
+	LobbyDataUpdatedHandle = PinnedManager->OnLobbyDataUpdated.AddLambda([LobbyDataUpdates = LobbyDataUpdates](uint64 LobbyID, bool bSuccess)
+		{
+			LobbyDataUpdates->Enqueue(TPair<uint64, bool>(LobbyID, bSuccess));
+		}
+	);
+
+	TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FLobbyBrowser::Tick));
+	return true;
+}
+
+int32 FLobbyBrowser::Search(const FLobbySearchParameters& Parameters, FOnLobbySearchBatch Callback)
+{
+	check(IsInGameThread());
+
+	if (!SteamMatchmaking())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FLobbyBrowser: SteamMatchmakingInterface steamworks_sdk not valid!"));
+		return 0;
+	}
+
+	Cancel();
+
+	CurrentSearch = MakeUnique<FSearch>();
+	CurrentSearch->SearchID = NextSearchID;
+	CurrentSearch->Parameters = Parameters;
+	CurrentSearch->Parameters.MaxResults = Parameters.MaxResults > 0 ? Parameters.MaxResults : LOBBY_BROWSER_DEFAULT_MAX_RESULTS;
+	CurrentSearch->NextStage = 0;
+	CurrentSearch->CallTag = 0;
+	CurrentSearch->StageStartTime = 0.0;
+	CurrentSearch->StartTime = FPlatformTime::Seconds();
+	CurrentSearch->bHasFoundFirst = false;
+	CurrentSearch->NumStreamed = 0;
+	CurrentSearch->Callback = MoveTemp(Callback);
+
+	if (Parameters.bWidenDistance)
+	{
+		CurrentSearch->Stages = { k_ELobbyDistanceFilterClose, k_ELobbyDistanceFilterDefault, k_ELobbyDistanceFilterFar, k_ELobbyDistanceFilterWorldwide };
+	}
+	else
+	{
+		CurrentSearch->Stages = { k_ELobbyDistanceFilterDefault };
+	}
+
+	NextSearchID = NextSearchID == MAX_int32 ? 1 : NextSearchID + 1;
+
+	const int32 SearchID = CurrentSearch->SearchID;
+	StartNextStage();
+	return SearchID;
+}
+
+void FLobbyBrowser::Cancel()
+{
+	check(IsInGameThread());
+
+	if (!CurrentSearch.IsValid())
+	{
+		return;
+	}
+
+	UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("FLobbyBrowser: Search %d cancelled with %d lobbies"), CurrentSearch->SearchID, CurrentSearch->NumStreamed);
+
+	// Pending call is kept until answered: its list is then dropped by its tag.
+	CurrentSearch.Reset();
+}
+
+bool FLobbyBrowser::IsSearching() const
+{
+	return CurrentSearch.IsValid();
+}
+
+bool FLobbyBrowser::RequestDetails(const uint64 LobbyID, FLobbyDetails& OutDetails, FOnLobbyDetailsRequested Callback)
+{
+	check(IsInGameThread());
+
+	OutDetails = FLobbyDetails();
+	OutDetails.LobbyID = static_cast<int64>(LobbyID);
+
+	ISteamMatchmaking* SteamMatchmakingInterface = SteamMatchmaking();
+	if (!SteamMatchmakingInterface || LobbyID == 0)
+	{
+		return true;
+	}
+
+	// Lobbies returned by a search come with their metadata: most cards are answered here.
+	if (ReadDetails(LobbyID, OutDetails))
+	{
+		return true;
+	}
+
+	TArray<FOnLobbyDetailsRequested, TInlineAllocator<1>>& Waiters = DetailsWaiters.FindOrAdd(LobbyID);
+	Waiters.Add(MoveTemp(Callback));
+
+	// Already requested for another card: wait the same answer.
+	if (Waiters.Num() > 1)
+	{
+		return false;
+	}
+
+	if (!SteamMatchmakingInterface->RequestLobbyData(CSteamID(LobbyID)))
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FLobbyBrowser: RequestLobbyData failed for %llu!"), LobbyID);
+		CompleteDetails(LobbyID, false);
+		return false;
+	}
+
+	DetailsRequestTimes.Add(LobbyID, FPlatformTime::Seconds());
+	return false;
+}
+
+bool FLobbyBrowser::StartNextStage()
+{
+	ISteamMatchmaking* SteamMatchmakingInterface = SteamMatchmaking();
+	FSearch& Search = *CurrentSearch;
+
+	const int32 NumMissing = Search.Parameters.MaxResults - Search.NumStreamed;
+	if (!SteamMatchmakingInterface || NumMissing <= 0 || Search.NextStage >= Search.Stages.Num())
+	{
+		return false;
+	}
+
+	// Filters are consumed by each RequestLobbyList call: they are added again for every stage.
+	for (const TPair<FString, FString>& Filter : Search.Parameters.StringFilters)
+	{
+		SteamMatchmakingInterface->AddRequestLobbyListStringFilter(TCHAR_TO_UTF8(*Filter.Key), TCHAR_TO_UTF8(*Filter.Value), k_ELobbyComparisonEqual);
+	}
+
+	if (Search.Parameters.bOnlyWithFreeSlots)
+	{
+		SteamMatchmakingInterface->AddRequestLobbyListFilterSlotsAvailable(1);
+	}
+
+	// Lobbies of previous stages are returned again by wider ones: ask for enough to find new ones.
+	SteamMatchmakingInterface->AddRequestLobbyListDistanceFilter(Search.Stages[Search.NextStage]);
+	SteamMatchmakingInterface->AddRequestLobbyListResultCountFilter(Search.FoundLobbyIDs.Num() + NumMissing);
+
+	Search.CallTag = NextCallTag;
+	NextCallTag = NextCallTag == MAX_uint32 ? 1 : NextCallTag + 1;
+	Search.NextStage++;
+	Search.StageStartTime = FPlatformTime::Seconds();
+
+	const SteamAPICall_t CallHandle = SteamMatchmakingInterface->RequestLobbyList();
+	if (CallHandle == k_uAPICallInvalid)
+	{
+		// Answered as failed by next Tick, like any other list.
+		FMatchList FailedList;
+		FailedList.CallHandle = k_uAPICallInvalid;
+		FailedList.CallTag = Search.CallTag;
+		FailedList.bFailed = true;
+		MatchLists->Enqueue(MoveTemp(FailedList));
+		return true;
+	}
+
+	PendingCalls.Add(CallHandle, MakeUnique<FMatchListCall>(CallHandle, Search.CallTag, MatchLists));
+	return true;
+}
+
+void FLobbyBrowser::OnStageAnswered(const FMatchList& MatchList)
+{
+	FSearch& Search = *CurrentSearch;
+	Search.CallTag = 0;
+
+	ISteamMatchmaking* SteamMatchmakingInterface = SteamMatchmaking();
+	TArray<FLobbySearchRow> Rows;
+
+	if (SteamMatchmakingInterface && !MatchList.bFailed)
+	{
+		Rows.Reserve(MatchList.LobbyIDs.Num());
+
+		for (const uint64 LobbyID : MatchList.LobbyIDs)
+		{
+			bool bIsAlreadyFound = false;
+			Search.FoundLobbyIDs.Add(LobbyID, &bIsAlreadyFound);
+			if (bIsAlreadyFound)
+			{
+				continue;
+			}
+
+			// Ping location comes with lobby data of the list: no request sent.
+			const int32 PingMs = FPingLocation::EstimateLobbyPingMs(LobbyID);
+			if (!FPingLocation::IsWithinMaxPing(PingMs, Search.Parameters.MaxPingMs))
+			{
+				continue;
+			}
+
+			const CSteamID LobbySteamID(LobbyID);
+			FLobbySearchRow& Row = Rows.AddDefaulted_GetRef();
+			Row.LobbyID = static_cast<int64>(LobbyID);
+			Row.NumMembers = SteamMatchmakingInterface->GetNumLobbyMembers(LobbySteamID);
+			Row.MaxMembers = SteamMatchmakingInterface->GetLobbyMemberLimit(LobbySteamID);
+			Row.PingMs = PingMs;
+
+			if (++Search.NumStreamed >= Search.Parameters.MaxResults)
+			{
+				break;
+			}
+		}
+
+		// Stages already stream near lobbies first: inside a batch, order by estimated ping.
+		Algo::StableSort(Rows, [](const FLobbySearchRow& A, const FLobbySearchRow& B)
+			{
+				return FPingLocation::IsCloser(A.PingMs, B.PingMs);
+			}
+		);
+	}
+	else
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FLobbyBrowser: Search %d stage %d failed!"), Search.SearchID, Search.NextStage - 1);
+	}
+
+	if (!Search.bHasFoundFirst && Rows.Num() > 0)
+	{
+		Search.bHasFoundFirst = true;
+		UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("FLobbyBrowser: Search %d first lobbies after %.3fs"), Search.SearchID, FPlatformTime::Seconds() - Search.StartTime);
+	}
+
+	const bool bIsComplete = !StartNextStage();
+
+	// Copied before the callback: it may start a new search, destroying this one.
+	const int32 SearchID = Search.SearchID;
+	const FOnLobbySearchBatch Callback = Search.Callback;
+
+	if (bIsComplete)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("FLobbyBrowser: Search %d complete with %d lobbies in %.3fs"), SearchID, Search.NumStreamed, FPlatformTime::Seconds() - Search.StartTime);
+		CurrentSearch.Reset();
+	}
+
+	// Empty batches of middle stages are not reported.
+	if (Rows.Num() > 0 || bIsComplete)
+	{
+		Callback.ExecuteIfBound(SearchID, Rows, bIsComplete);
+	}
+}
+
+bool FLobbyBrowser::ReadDetails(const uint64 LobbyID, FLobbyDetails& OutDetails) const
+{
+	ISteamMatchmaking* SteamMatchmakingInterface = SteamMatchmaking();
+	if (!SteamMatchmakingInterface)
+	{
+		return false;
+	}
+
+	const CSteamID LobbySteamID(LobbyID);
+	const int32 DataCount = SteamMatchmakingInterface->GetLobbyDataCount(LobbySteamID);
+	if (DataCount <= 0)
+	{
+		return false;
+	}
+
+	OutDetails.LobbyID = static_cast<int64>(LobbyID);
+	OutDetails.bIsValid = true;
+	OutDetails.NumMembers = SteamMatchmakingInterface->GetNumLobbyMembers(LobbySteamID);
+	OutDetails.MaxMembers = SteamMatchmakingInterface->GetLobbyMemberLimit(LobbySteamID);
+	OutDetails.PingMs = FPingLocation::EstimateLobbyPingMs(LobbyID);
+	OutDetails.Data.Empty(DataCount);
+
+	// Same buffers for every key, sized as SteamAPI max lengths.
+	char Key[k_nMaxLobbyKeyLength];
+	char Value[k_cubChatMetadataMax];
+
+	for (int32 Index = 0; Index < DataCount; Index++)
+	{
+		if (SteamMatchmakingInterface->GetLobbyDataByIndex(LobbySteamID, Index, Key, sizeof(Key), Value, sizeof(Value)))
+		{
+			OutDetails.Data.Add(FString(UTF8_TO_TCHAR(Key)), FString(UTF8_TO_TCHAR(Value)));
+		}
+	}
+
+	if (const FString* OwnerName = OutDetails.Data.Find(TEXT(LOBBY_OWNER_NAME_KEY)))
+	{
+		OutDetails.OwnerName = *OwnerName;
+	}
+
+	return true;
+}
+
+void FLobbyBrowser::CompleteDetails(const uint64 LobbyID, const bool bSuccess)
+{
+	DetailsRequestTimes.Remove(LobbyID);
+
+	TArray<FOnLobbyDetailsRequested, TInlineAllocator<1>> Waiters;
+	if (!DetailsWaiters.RemoveAndCopyValue(LobbyID, Waiters))
+	{
+		return;
+	}
+
+	FLobbyDetails Details;
+	Details.LobbyID = static_cast<int64>(LobbyID);
+	if (bSuccess)
+	{
+		ReadDetails(LobbyID, Details);
+	}
+
+	for (const FOnLobbyDetailsRequested& Waiter : Waiters)
+	{
+		Waiter.ExecuteIfBound(Details);
+	}
+}
+
+bool FLobbyBrowser::Tick(float DeltaTime)
+{
+	FMatchList MatchList;
+	while (MatchLists->Dequeue(MatchList))
+	{
+		// Handler has run: its call result can go.
+		PendingCalls.Remove(MatchList.CallHandle);
+
+		// Lists of cancelled searches or stages that timed out.
+		if (CurrentSearch.IsValid() && CurrentSearch->CallTag != 0 && MatchList.CallTag == CurrentSearch->CallTag)
+		{
+			OnStageAnswered(MatchList);
+		}
+	}
+
+	const double Now = FPlatformTime::Seconds();
+
+	if (CurrentSearch.IsValid() && CurrentSearch->CallTag != 0 && Now - CurrentSearch->StageStartTime > LOBBY_BROWSER_STAGE_TIMEOUT)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FLobbyBrowser: Search %d stage timed out!"), CurrentSearch->SearchID);
+
+		// Late answer of this stage is dropped by its tag.
+		FMatchList TimedOutList;
+		TimedOutList.CallHandle = k_uAPICallInvalid;
+		TimedOutList.CallTag = CurrentSearch->CallTag;
+		TimedOutList.bFailed = true;
+		OnStageAnswered(TimedOutList);
+	}
+
+	TPair<uint64, bool> LobbyDataUpdate;
+	while (LobbyDataUpdates->Dequeue(LobbyDataUpdate))
+	{
+		CompleteDetails(LobbyDataUpdate.Key, LobbyDataUpdate.Value);
+	}
+
+	if (DetailsRequestTimes.Num() > 0)
+	{
+		TArray<uint64, TInlineAllocator<8>> TimedOutLobbyIDs;
+		for (const TPair<uint64, double>& RequestTime : DetailsRequestTimes)
+		{
+			if (Now - RequestTime.Value > LOBBY_DETAILS_REQUEST_TIMEOUT)
+			{
+				TimedOutLobbyIDs.Add(RequestTime.Key);
+			}
+		}
+
+		for (const uint64 LobbyID : TimedOutLobbyIDs)
+		{
+			UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FLobbyBrowser: RequestLobbyData timed out for %llu!"), LobbyID);
+			CompleteDetails(LobbyID, false);
+		}
+	}
+
+	return true;
+}
+
+FLobbyBrowser::FMatchListCall::FMatchListCall(const SteamAPICall_t InCallHandle, const uint32 InCallTag, TSharedRef<FMatchListQueue, ESPMode::ThreadSafe> InMatchLists)
+	: CallHandle(InCallHandle)
+	, CallTag(InCallTag)
+	, MatchLists(InMatchLists)
+{
+	CallResult.Set(CallHandle, this, &FMatchListCall::OnLobbyMatchList);
+}
+
+void FLobbyBrowser::FMatchListCall::OnLobbyMatchList(LobbyMatchList_t* Result, bool bIOFailure)
+{
+	ISteamMatchmaking* SteamMatchmakingInterface = SteamMatchmaking();
+
+	FMatchList MatchList;
+	MatchList.CallHandle = CallHandle;
+	MatchList.CallTag = CallTag;
+	MatchList.bFailed = bIOFailure || !Result || !SteamMatchmakingInterface;
+
+	// Lobby IDs must be read now: next RequestLobbyList replaces them.
+	if (!MatchList.bFailed)
+	{
+		MatchList.LobbyIDs.Reserve(Result->m_nLobbiesMatching);
+		for (uint32 Index = 0; Index < Result->m_nLobbiesMatching; Index++)
+		{
+			MatchList.LobbyIDs.Add(SteamMatchmakingInterface->GetLobbyByIndex(Index).ConvertToUint64());
+		}
+	}
+
+	MatchLists->Enqueue(MoveTemp(MatchList));
+}
@@ -6,6 +6,7 @@
 
 #include "PNetworking.h"
 #include "OnlineSubsystem.h"
+#include "RelayNetwork.h"
 
 #define LOCTEXT_NAMESPACE "FPNetworkingModule"
 
@@ -13,6 +14,7 @@
 IOnlineSubsystem* FPNetworkingModule::OnlineSubsystemPtr = nullptr;
 IOnlineSessionPtr FPNetworkingModule::OnlineSessionPtr = nullptr;
 TSharedPtr<SteamAPICallbackManager> FPNetworkingModule::SteamApiManagerPtr = nullptr;
+TSharedPtr<FRelayNetwork> FPNetworkingModule::RelayNetworkPtr = nullptr;
 ELocalSessionState FPNetworkingModule::LocalSessionCurrentState = ELocalSessionState::SESSION_INVALID;
 FName FPNetworkingModule::SessionName = TEXT(SESSION_NAME); // Name used for the multiplayer steam session.
 
@@ -32,6 +34,7 @@ void FPNetworkingModule::ShutdownModule()
 	OnlineSubsystemPtr = nullptr;
 	OnlineSessionPtr.Reset();
 	SteamApiManagerPtr.Reset();
+	RelayNetworkPtr.Reset();
 }
 
 #pragma endregion
@@ -95,6 +98,11 @@ void FPNetworkingModule::InternalStartupModule()
 	}
 
 	SteamApiManagerPtr = MakeShared<SteamAPICallbackManager>();
+
+	// Relay network is warmed up in background now, not by the first connection.
+	// If SteamAPI is not available yet, it is started again by the networking instance.
+	RelayNetworkPtr = MakeShared<FRelayNetwork>();
+	RelayNetworkPtr->Start();
 }
 
 // Get OSS pointer.
@@ -130,6 +138,12 @@ TSharedPtr<SteamAPICallbackManager> FPNetworkingModule::GetSteamAPIManager()
 	return SteamApiManagerPtr;
 }
 
+// Get relay network warm up. Not gated by IsOnlineAvailable: its state tells if relays can be used.
+TSharedPtr<FRelayNetwork> FPNetworkingModule::GetRelayNetwork()
+{
+	return RelayNetworkPtr;
+}
+
 // Getter of hardcoded name of the session.
 FName FPNetworkingModule::GetSessionName()
 {
@@ -12,6 +12,27 @@
 #include "PNetworking.h"
 #include "Kismet/GameplayStatics.h"
 #include "SessionCreationParameters.h"
+#include "AvatarPipeline.h"
+#include "AvatarAtlas.h"
+#include "AvatarDiskCache.h"
+#include "Async/Async.h"
+#include "FriendsAvatarResolver.h"
+#include "ProgressiveAvatar.h"
+#include "FriendRoster.h"
+#include "FriendListSnapshot.h"
+#include "FriendNameIndex.h"
+#include "FriendListView.h"
+#include "RichPresenceCache.h"
+#include "FriendsGroupIndex.h"
+#include "RecentPlayers.h"
+#include "UserDirectory.h"
+#include "SessionOrchestrator.h"
+#include "LobbyBrowser.h"
+#include "PingLocation.h"
+#include "RelayNetwork.h"
+#include "Online/OnlineSessionNames.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerState.h"
 
 // Static declarations.
 UPNetworkingInstanceSteam* UPNetworkingInstanceSteam::NetInstanceSteamPtr = nullptr;
@@ -20,6 +41,8 @@ bool UPNetworkingInstanceSteam::bIsModuleReady = false;
 #pragma region SpecialMemberFunctions
 
 UPNetworkingInstanceSteam::UPNetworkingInstanceSteam()
+	: QuickJoinMaxPingMs(0)
+	, FriendListNamesCacheTTL(FRIEND_LIST_NAMES_CACHE_TTL)
 {
 	UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("Constructor UPNetworkingInstanceSteam Called!"));
 	if (bIsModuleReady)
@@ -147,14 +170,14 @@ bool UPNetworkingInstanceSteam::GetAccountName(FString& AccountName, const int32
 	return true;
 }
 
-int32 UPNetworkingInstanceSteam::GetLocalUserAvatar(const FOnLocalAvatarReady& Callback)
+int32 UPNetworkingInstanceSteam::GetLocalUserAvatar(const FOnLocalAvatarReady& Callback, const EAvatarSize AvatarSize, const int32 PixelSize)
 {
 	if (!FPNetworkingModule::IsOnlineAvailable(TEXT("IsOnlineAvailable: GetLocalUserAvatar Called it")))
 	{
 		return 0;
 	}
 
-	return GetLocalUserAvatarRecursive(MakeShared<FOnLocalAvatarReady>(Callback));
+	return GetLocalUserAvatarRecursive(FAvatarPipeline::ResolveAvatarSize(AvatarSize, PixelSize), MakeShared<FOnLocalAvatarReady>(Callback));
 }
 
 #pragma endregion LocalUser
@@ -175,10 +198,27 @@ FString UPNetworkingInstanceSteam::GetUsernameFromSteamID(const int32 SteamID)
 		return EMPTY_FSTRING;
 	}
 
-	return FString(SteamFriendsInterface->GetFriendPersonaName(RealSteamID));
+	if (UserDirectory.IsValid() && RealSteamID.IsValid())
+	{
+		const FUserDirectoryEntry* Entry = UserDirectory->Find(RealSteamID.ConvertToUint64());
+		if (Entry && Entry->State == EUserFetchState::READY)
+		{
+			return Entry->UserName;
+		}
+
+		// Non-friends are unknown to SteamAPI until requested: the name is valid from OnUserDataChanged.
+		if (!Entry || Entry->State == EUserFetchState::UNKNOWN)
+		{
+			const uint64 RealSteamID64 = RealSteamID.ConvertToUint64();
+			UserDirectory->Resolve(MakeArrayView(&RealSteamID64, 1), FOnUserDirectoryBatchResolved());
+		}
+	}
+
+	// Persona names are UTF-8.
+	return FString(UTF8_TO_TCHAR(SteamFriendsInterface->GetFriendPersonaName(RealSteamID)));
 }
 
-int32 UPNetworkingInstanceSteam::GetAvatarFromSteamID(const int32 SteamID, const FOnRequestedFriendAvatarReady& Callback)
+int32 UPNetworkingInstanceSteam::GetAvatarFromSteamID(const int32 SteamID, const FOnRequestedFriendAvatarReady& Callback, const EAvatarSize AvatarSize, const int32 PixelSize)
 {
 	if (!FPNetworkingModule::IsOnlineAvailable())
 	{
@@ -192,885 +232,1588 @@ int32 UPNetworkingInstanceSteam::GetAvatarFromSteamID(const int32 SteamID, const
 		return 0;
 	}
 
-	return GetRequestedFriendAvatarRecursive(TargetFriendID, MakeShared<FOnRequestedFriendAvatarReady>(Callback));
+	const EAvatarSize TargetSize = FAvatarPipeline::ResolveAvatarSize(AvatarSize, PixelSize);
+	TSharedPtr<FOnRequestedFriendAvatarReady> SharedCallback = MakeShared<FOnRequestedFriendAvatarReady>(Callback);
+
+	// Avatar handle of a user unknown to SteamAPI is 0: resolve the user first.
+	ISteamFriends* SteamFriendsInterface = SteamFriends();
+	const FUserDirectoryEntry* Entry = UserDirectory.IsValid() ? UserDirectory->Find(TargetFriendID.ConvertToUint64()) : nullptr;
+	if (UserDirectory.IsValid() && SteamFriendsInterface && (!Entry || Entry->State != EUserFetchState::READY) && !SteamFriendsInterface->HasFriend(TargetFriendID, k_EFriendFlagImmediate))
+	{
+		const uint64 TargetFriendID64 = TargetFriendID.ConvertToUint64();
+		UserDirectory->Resolve(MakeArrayView(&TargetFriendID64, 1), FOnUserDirectoryBatchResolved::CreateWeakLambda(this, [this, TargetFriendID, TargetSize, SharedCallback](const TArray<uint64>& SteamIDs)
+			{
+				// Caller already got -1: it must be told that no avatar is coming.
+				if (GetRequestedFriendAvatarRecursive(TargetFriendID, TargetSize, SharedCallback) == 0)
+				{
+					SharedCallback->ExecuteIfBound(nullptr);
+				}
+			}
+		));
+
+		return -1;
+	}
+
+	return GetRequestedFriendAvatarRecursive(TargetFriendID, TargetSize, SharedCallback);
+}
+
+bool UPNetworkingInstanceSteam::GetOnlineFriendListNames(const FOnFriendsListReady& Callback, const int32 LocalUserNum, const bool bForceRefresh)
+{
+	return GetFriendList(Callback, EFriendsLists::OnlinePlayers, LocalUserNum, bForceRefresh);
 }
 
-bool UPNetworkingInstanceSteam::GetOnlineFriendListNames(const FOnFriendsListReady& Callback, const int32 LocalUserNum)
+bool UPNetworkingInstanceSteam::GetAllFriendListNames(const FOnFriendsListReady& Callback, const int32 LocalUserNum, const bool bForceRefresh)
 {
-	return GetFriendList(Callback, EFriendsLists::OnlinePlayers, LocalUserNum);
+	return GetFriendList(Callback, EFriendsLists::Default, LocalUserNum, bForceRefresh);
 }
 
-bool UPNetworkingInstanceSteam::GetAllFriendListNames(const FOnFriendsListReady& Callback, const int32 LocalUserNum)
+void UPNetworkingInstanceSteam::SetFriendListNamesCacheTTL(const float Seconds)
 {
-	return GetFriendList(Callback, EFriendsLists::Default, LocalUserNum);
+	FriendListNamesCacheTTL = FMath::Max(Seconds, 0.0f);
 }
 
-int32 UPNetworkingInstanceSteam::GetFriendsAvatar(const FOnFriendsAvatarReady& Callback)
+int32 UPNetworkingInstanceSteam::GetFriendsAvatar(const FOnFriendsAvatarReady& Callback, const float TimeoutSeconds, const EAvatarSize AvatarSize, const int32 PixelSize)
 {
 	if (!FPNetworkingModule::IsOnlineAvailable(TEXT("IsOnlineAvailable: GetFriendsAvatar Called it")))
 	{
 		return 0;
 	}
 
-	return GetFriendsAvatarRecursive(MakeShared<FOnFriendsAvatarReady>(Callback));
+	return ResolveFriendsAvatar(TimeoutSeconds, FAvatarPipeline::ResolveAvatarSize(AvatarSize, PixelSize), MakeShared<FOnFriendsAvatarReady>(Callback));
 }
 
-int32 UPNetworkingInstanceSteam::GetPlayersData(const bool bAlphabeticalSort, const FOnFriendsDataReady& Callback)
+int32 UPNetworkingInstanceSteam::GetPlayersData(const bool bAlphabeticalSort, const FOnFriendsDataReady& Callback, const float TimeoutSeconds, const EAvatarSize AvatarSize, const int32 PixelSize)
 {
 	if (!FPNetworkingModule::IsOnlineAvailable(TEXT("IsOnlineAvailable: GetPlayersData Called it")))
 	{
 		return 0;
 	}
 
-	return GetPlayerDataRecursive(bAlphabeticalSort, MakeShared<FOnFriendsDataReady>(Callback));
+	return ResolvePlayersData(bAlphabeticalSort, TimeoutSeconds, FAvatarPipeline::ResolveAvatarSize(AvatarSize, PixelSize), MakeShared<FOnFriendsDataReady>(Callback));
 } 
 
 #pragma endregion FriendlistUtilityLocalUser
 
-#pragma region SessionManagement
+#pragma region AvatarCache
 
-bool UPNetworkingInstanceSteam::RequestSessionCreation(FSessionCreationParameters SessionCreationParameters)
+bool UPNetworkingInstanceSteam::GetAvatarCacheStats(FAvatarCacheStats& Stats) const
 {
-	if (FPNetworkingModule::GetLocalSessionCurrentState() != ELocalSessionState::SESSION_INVALID)
+	if (!AvatarCache.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("RequestSessionCreation: Already computing a session!"));
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("GetAvatarCacheStats: AvatarCache not initialized!"));
 		return false;
 	}
 
-	IOnlineSessionPtr SessionInterface = FPNetworkingModule::GetOnlineSessionPointer();
-	if (!SessionInterface.IsValid())
+	Stats = AvatarCache->GetStats();
+	return true;
+}
+
+bool UPNetworkingInstanceSteam::SetAvatarCacheBudget(const int32 BudgetMegabytes, const int32 MaxEntries)
+{
+	if (!AvatarCache.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("RequestSessionCreation: Session interface not valid!"));
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("SetAvatarCacheBudget: AvatarCache not initialized!"));
 		return false;
 	}
 
-	FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_PENDING);
+	AvatarCache->SetBudget(static_cast<int64>(BudgetMegabytes) * 1024 * 1024, MaxEntries);
+	return true;
+}
 
-	MapPathToTravel = SessionCreationParameters.TravelToMapPath;
-	TempCreationSessionSettings.NumPublicConnections = SessionCreationParameters.NumPublicConnections;
-	TempCreationSessionSettings.NumPrivateConnections = SessionCreationParameters.NumPrivateConnections;
-	TempCreationSessionSettings.bShouldAdvertise = SessionCreationParameters.bShouldAdvertise;
-	TempCreationSessionSettings.bAllowJoinInProgress = SessionCreationParameters.bAllowJoinInProgress;
-	TempCreationSessionSettings.bIsLANMatch = SessionCreationParameters.bIsLANMatch;
-	TempCreationSessionSettings.bIsDedicated = SessionCreationParameters.bIsDedicated;
-	TempCreationSessionSettings.bAllowInvites = SessionCreationParameters.bAllowInvites;
-	TempCreationSessionSettings.bUsesPresence = SessionCreationParameters.bUsesPresence;
-	TempCreationSessionSettings.bAllowJoinViaPresence = SessionCreationParameters.bAllowJoinViaPresence;
-	TempCreationSessionSettings.bAllowJoinViaPresenceFriendsOnly = SessionCreationParameters.bAllowJoinViaPresenceFriendsOnly;
-	TempCreationSessionSettings.bUseLobbiesIfAvailable = SessionCreationParameters.bUseLobbiesIfAvailable;
+void UPNetworkingInstanceSteam::ClearAvatarCache()
+{
+	if (AvatarCache.IsValid())
+	{
+		AvatarCache->Empty();
+	}
 
-	return HandleOldSessionIfExisting();
+	if (AvatarTexturePool.IsValid())
+	{
+		AvatarTexturePool->Empty();
+	}
 }
 
-bool UPNetworkingInstanceSteam::InviteFriend(const int32 SteamID)
+bool UPNetworkingInstanceSteam::GetAvatarTexturePoolStats(FAvatarTexturePoolStats& Stats) const
 {
-	if (FPNetworkingModule::GetLocalSessionCurrentState() != ELocalSessionState::SESSION_VALID)
+	if (!AvatarTexturePool.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("InviteFriend: Session is begin computed, destroyed or already invalid!"));
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("GetAvatarTexturePoolStats: AvatarTexturePool not initialized!"));
 		return false;
 	}
 
-	IOnlineSessionPtr SessionInterface = FPNetworkingModule::GetOnlineSessionPointer();
-	if (!SessionInterface.IsValid())
+	Stats = AvatarTexturePool->GetStats();
+	return true;
+}
+
+bool UPNetworkingInstanceSteam::SetAvatarTexturePoolSize(const int32 MaxTexturesPerSize)
+{
+	if (!AvatarTexturePool.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("InviteFriend: SessionInterface is invalid!"));
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("SetAvatarTexturePoolSize: AvatarTexturePool not initialized!"));
 		return false;
 	}
 
-	const CSteamID FriendSteamID = ConvertInt32toCSteamID(SteamID);
-	FUniqueNetIdPtr FriendUniqueNetID;
+	AvatarTexturePool->SetMaxPerSize(MaxTexturesPerSize);
+	return true;
+}
 
-	if (ConvertCSteamIDToFUniqueNetID(FriendSteamID, FriendUniqueNetID))
+bool UPNetworkingInstanceSteam::SetAvatarCompression(const bool bEnabled)
+{
+	if (!AvatarPipeline.IsValid())
 	{
-		if (!SessionInterface->GetNamedSession(FPNetworkingModule::GetSessionName()))
-		{
-			UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("InviteFriend: Session was not created!"));
-			return false;
-		}
-
-		return SessionInterface->SendSessionInviteToFriend(0, FPNetworkingModule::GetSessionName(), *FriendUniqueNetID);
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("SetAvatarCompression: AvatarPipeline not initialized!"));
+		return false;
 	}
 
-	return false;
+	AvatarPipeline->SetCompressionEnabled(bEnabled);
+	return true;
 }
 
-void UPNetworkingInstanceSteam::QuitSession(const FString& TravelBackMapPath)
+#pragma endregion AvatarCache
+
+#pragma region AvatarAtlas
+
+int32 UPNetworkingInstanceSteam::GetFriendsAvatarAtlas(const FOnFriendsAvatarAtlasReady& Callback, const float TimeoutSeconds, const EAvatarSize AvatarSize, const int32 PixelSize)
 {
-	if (FPNetworkingModule::GetLocalSessionCurrentState() != ELocalSessionState::SESSION_VALID)
+	if (!FPNetworkingModule::IsOnlineAvailable(TEXT("IsOnlineAvailable: GetFriendsAvatarAtlas Called it")))
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("QuitSession: Session is begin computed, destroyed or already invalid!"));
-		return;
+		return 0;
 	}
 
-	if (!GEngine)
+	return ResolveFriendsAvatarAtlas(TimeoutSeconds, FAvatarPipeline::ResolveAvatarSize(AvatarSize, PixelSize), MakeShared<FOnFriendsAvatarAtlasReady>(Callback));
+}
+
+bool UPNetworkingInstanceSteam::GetAvatarAtlasSlot(const int32 SteamID, FAvatarAtlasSlot& Slot)
+{
+	if (!AvatarAtlas.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("QuitSession: GEngine invalid!"));
-		return;
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("GetAvatarAtlasSlot: AvatarAtlas not initialized!"));
+		return false;
 	}
 
-	UWorld* CurrentWorld = GEngine->GetWorldContexts().Num() > 0 ? GEngine->GetWorldContexts()[0].World() : nullptr;
-	if (!CurrentWorld)
+	return AvatarAtlas->FindSlot(ConvertInt32toCSteamID(SteamID).ConvertToUint64(), Slot);
+}
+
+void UPNetworkingInstanceSteam::RemoveAvatarFromAtlas(const int32 SteamID)
+{
+	if (AvatarAtlas.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("QuitSession: World is null!"));
-		return;
+		AvatarAtlas->Remove(ConvertInt32toCSteamID(SteamID).ConvertToUint64());
 	}
+}
+
+#pragma endregion AvatarAtlas
+
+#pragma region ProgressiveAvatar
 
-	APlayerController* PlayerController = UGameplayStatics::GetPlayerController(CurrentWorld, 0);
-	if (!PlayerController)
+UProgressiveAvatar* UPNetworkingInstanceSteam::GetProgressiveAvatar(const int32 SteamID, const EAvatarSize AvatarSize, const int32 PixelSize)
+{
+	if (!FPNetworkingModule::IsOnlineAvailable(TEXT("IsOnlineAvailable: GetProgressiveAvatar Called it")))
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("QuitSession: PlayerController is null!"));
-		return;
+		return nullptr;
 	}
-	
-	PlayerController->ClientTravel(TravelBackMapPath, ETravelType::TRAVEL_Absolute);
 
-	IOnlineSessionPtr OnlineSession = FPNetworkingModule::GetOnlineSessionPointer();
-	if (!OnlineSession.IsValid())
+	if (!ProgressiveAvatarProvider.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("QuitSession: OnlineSession is null!"));
-		return;
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("GetProgressiveAvatar: ProgressiveAvatarProvider not initialized!"));
+		return nullptr;
 	}
 
-	if (OnlineSession->GetNamedSession(FPNetworkingModule::GetSessionName()))
+	CSteamID TargetID;
+	if (SteamID == 0)
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("QuitSession: Session existing, need to destroy it!"));
-		OnClientDestroySessionCompleteHandle = OnlineSession->AddOnDestroySessionCompleteDelegate_Handle(
-			FOnDestroySessionCompleteDelegate::CreateUObject(this, &UPNetworkingInstanceSteam::OnClientDestroySessionComplete));
-
-		if (OnlineSession->DestroySession(FPNetworkingModule::GetSessionName()))
-		{
-			FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_DESTROYING);
-			UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("QuitSession: DestroySession request true!"));
-		}
-		else
+		ISteamUser* SteamUserInterface = SteamUser();
+		if (!SteamUserInterface)
 		{
-			if (OnClientDestroySessionCompleteHandle.IsValid())
-			{
-				OnlineSession->ClearOnDestroySessionCompleteDelegate_Handle(OnClientDestroySessionCompleteHandle);
-				OnClientDestroySessionCompleteHandle.Reset();
-			}
+			UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("GetProgressiveAvatar: SteamUserInterface steamwork_sdk not valid!"));
+			return nullptr;
 		}
-	}
-}
 
-bool UPNetworkingInstanceSteam::GetSessionParameters(FGetSessionParameters& SessionParameters) const
-{
-	IOnlineSessionPtr OnlineSession = FPNetworkingModule::GetOnlineSessionPointer();
-	if (!OnlineSession.IsValid())
+		TargetID = SteamUserInterface->GetSteamID();
+	}
+	else
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("GetSessionParameters: OnlineSession is null!"));
-		return false;
+		TargetID = ConvertInt32toCSteamID(SteamID);
 	}
 
-	FOnlineSessionSettings* SessionSettings = OnlineSession->GetSessionSettings(FPNetworkingModule::GetSessionName());
-	if (!SessionSettings)
+	if (!TargetID.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("GetSessionParameters: SessionSettings is null!"));
-		return false;
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("GetProgressiveAvatar: CSteamID not valid!"));
+		return nullptr;
 	}
-	
-	SessionParameters.NumPublicConnections = SessionSettings->NumPublicConnections;
-	SessionParameters.NumPrivateConnections = SessionSettings->NumPrivateConnections;
-	SessionParameters.bShouldAdvertise = SessionSettings->bShouldAdvertise;
-	SessionParameters.bAllowJoinInProgress = SessionSettings->bAllowJoinInProgress;
-	SessionParameters.bIsLANMatch = SessionSettings->bIsLANMatch;
-	SessionParameters.bIsDedicated = SessionSettings->bIsDedicated;
-	SessionParameters.bAllowInvites = SessionSettings->bAllowInvites;
 
-	return true;
+	return ProgressiveAvatarProvider->Acquire(TargetID, FAvatarPipeline::ResolveAvatarSize(AvatarSize, PixelSize));
 }
 
-bool UPNetworkingInstanceSteam::UpdateSessionParameters_AuthorityOnly(const AActor* Requester, const FUpdateSessionParameters& SessionParameters, const FOnSessionParametersUpdateReady& Callback)
+int32 UPNetworkingInstanceSteam::GetPlayersDataProgressive(const bool bAlphabeticalSort, const FOnFriendsDataReady& Callback, const EAvatarSize AvatarSize, const int32 PixelSize)
 {
-	IOnlineSessionPtr OnlineSession = FPNetworkingModule::GetOnlineSessionPointer();
-	if (!OnlineSession.IsValid())
+	if (!FPNetworkingModule::IsOnlineAvailable(TEXT("IsOnlineAvailable: GetPlayersDataProgressive Called it")))
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("UpdateSessionParameters_AuthorityOnly: OnlineSession is null!"));
-		return false;
-	}
-
-	if (!Requester) 
-	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("UpdateSessionParameters_AuthorityOnly: Requester is null!"));
-		return false;
+		return 0;
 	}
 
-	if (!Requester->HasAuthority())
+	if (!ProgressiveAvatarProvider.IsValid() || !FriendRoster.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("UpdateSessionParameters_AuthorityOnly: Requester has no Autority!"));
-		return false;
+		return 0;
 	}
 
-	FOnlineSessionSettings* SessionSettings = OnlineSession->GetSessionSettings(FPNetworkingModule::GetSessionName());
-	if (!SessionSettings)
-	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("UpdateSessionParameters_AuthorityOnly: SessionSettings is null!"));
-		return false;
-	}
+	const EAvatarSize TargetSize = FAvatarPipeline::ResolveAvatarSize(AvatarSize, PixelSize);
+	const TArray<FFriendRosterEntry>& Friends = FriendRoster->GetEntries();
 
-	SessionSettings->NumPublicConnections = SessionParameters.NumPublicConnections;
-	SessionSettings->NumPrivateConnections = SessionParameters.NumPrivateConnections;
-	SessionSettings->bShouldAdvertise = SessionParameters.bShouldAdvertise;
-	SessionSettings->bAllowJoinInProgress = SessionParameters.bAllowJoinInProgress;
-	SessionSettings->bIsLANMatch = SessionParameters.bIsLANMatch;
-	SessionSettings->bIsDedicated = SessionParameters.bIsDedicated;
-	SessionSettings->bAllowInvites = SessionParameters.bAllowInvites;
+	TArray<FUserSteamData> UserSteamData;
+	UserSteamData.Reserve(FriendRoster->NumOnline());
 
-	OnSessionParametersUpdateReadyDelegateHandle = OnlineSession->AddOnUpdateSessionCompleteDelegate_Handle(FOnUpdateSessionCompleteDelegate::CreateLambda([this, Callback, OnlineSession](FName SessionName, bool bWasSuccessful) mutable
+	for (int32 Index = 0; Index < Friends.Num(); Index++)
 	{
-		if (!bWasSuccessful)
-		{
-			return;
-		}
-		
-		Callback.ExecuteIfBound(SessionName, bWasSuccessful);
-
-		if (!OnlineSession.IsValid())
+		// Just online friends (better: not offline).
+		if (Friends[Index].IsOnline())
 		{
-			return;
-		}
+			UProgressiveAvatar* Avatar = ProgressiveAvatarProvider->Acquire(CSteamID(FriendRoster->GetSteamID64(Index)), TargetSize);
 
-		if (OnSessionParametersUpdateReadyDelegateHandle.IsValid())
-		{
-			OnlineSession->ClearOnUpdateSessionCompleteDelegate_Handle(OnSessionParametersUpdateReadyDelegateHandle);
-			OnSessionParametersUpdateReadyDelegateHandle.Reset();
+			FUserSteamData& FriendData = UserSteamData.Add_GetRef(FUserSteamData(Friends[Index].SteamID, Friends[Index].UserName, Avatar->Texture));
+			FriendData.ProgressiveAvatar = Avatar;
 		}
-		
-	}));
-	
-	OnlineSession->UpdateSession(FPNetworkingModule::GetSessionName(), *SessionSettings);
+	}
 
-	return true;
-}
+	if (UserSteamData.Num() == 0)
+	{
+		return 0;
+	}
 
-bool UPNetworkingInstanceSteam::IsSessionJoinable() const
-{
-	FGetSessionParameters GotSessionParameters;
-	
-	if (!GetSessionParameters(GotSessionParameters))
+	if (bAlphabeticalSort)
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("IsSessionJoinable: Cannot retreive parameters!"));
-		return false;
+		AlphabeticalSortFriends(UserSteamData);
 	}
 
-	return  FPNetworkingModule::GetLocalSessionCurrentState() == ELocalSessionState::SESSION_VALID &&
-		    GotSessionParameters.bShouldAdvertise &&
-		    GotSessionParameters.bAllowJoinInProgress &&
-		    GotSessionParameters.bAllowInvites;
+	Callback.ExecuteIfBound(UserSteamData);
+	return 1;
 }
 
-#pragma endregion SessionManagement
+#pragma endregion ProgressiveAvatar
 
-#pragma region PrivateUtilityFunctions
+#pragma region FriendRoster
 
-int32 UPNetworkingInstanceSteam::GetOnlineFriendsFromFriendCount(const int32 FriendsCount)
+bool UPNetworkingInstanceSteam::GetFriendRoster(TArray<FFriendRosterEntry>& Friends, const bool bOnlineOnly, const bool bAlphabeticalSort)
 {
-	int32 OnlineFriends = 0;
-
-	if (!FPNetworkingModule::IsOnlineAvailable(TEXT("IsOnlineAvailable: GetOnlineFriendsFromFriendCount Called it")))
+	if (!FriendRoster.IsValid())
 	{
-		return OnlineFriends;
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("GetFriendRoster: FriendRoster not initialized!"));
+		return false;
 	}
 
-	for (int32 Index = 0; Index < FriendsCount; Index++)
+	if (bOnlineOnly)
 	{
-		const CSteamID CurrentSteamID = SteamFriends()->GetFriendByIndex(Index, k_EFriendFlagImmediate);
-		//UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("GetOnlineFriendsFromFriendCount: ID: %u, NAME: %hs"), CurrentSteamID.GetAccountID(), SteamFriends()->GetFriendPersonaName(CurrentSteamID));
-		const EPersonaState CurrentPlayerState = SteamFriends()->GetFriendPersonaState(CurrentSteamID);
-		if (CurrentPlayerState != EPersonaState::k_EPersonaStateOffline)
+		Friends.Reset(FriendRoster->NumOnline());
+		for (const FFriendRosterEntry& Entry : FriendRoster->GetEntries())
 		{
-			OnlineFriends++;
+			if (Entry.IsOnline())
+			{
+				Friends.Add(Entry);
+			}
 		}
 	}
-
-	return OnlineFriends;
-}
-
-bool UPNetworkingInstanceSteam::GetFriendList(const FOnFriendsListReady& Callback, const EFriendsLists::Type Query, const int32 LocalUserNum)
-{
-	IOnlineSubsystem* OnlineSubsystemPtr = FPNetworkingModule::GetOnlineSubsystemPointer();
-	if (!OnlineSubsystemPtr)
+	else
 	{
-		return false;
+		Friends = FriendRoster->GetEntries();
 	}
 
-	IOnlineFriendsPtr FriendsInterface = OnlineSubsystemPtr->GetFriendsInterface();
-	if (!FriendsInterface.IsValid())
+	const FFriendNameIndex* NameIndex = bAlphabeticalSort ? GetFriendNameIndex() : nullptr;
+	if (NameIndex)
 	{
-		return false;
-	}
-
-	// Read the friends list before get all the names.
-	const bool bGetFriendsSuccessful = FriendsInterface->ReadFriendsList(
-		LocalUserNum,
-		EFriendsLists::ToString(Query),
-		FOnReadFriendsListComplete::CreateLambda([Callback](int32 LocalUserNum, bool bWasSuccessful, const FString& ListName, const FString& ErrorStr) mutable
+		Friends.Sort([NameIndex](const FFriendRosterEntry& First, const FFriendRosterEntry& Second)
 			{
-				TArray<FString> FriendsListNames;
-
-				if (!bWasSuccessful)
-				{
-					return;
-				}
-
-				IOnlineSubsystem* OnlineSubsystemPtr = FPNetworkingModule::GetOnlineSubsystemPointer();
-				if (!OnlineSubsystemPtr)
-				{
-					return;
-				}
-
-				IOnlineFriendsPtr OnlineFriendsPtr = OnlineSubsystemPtr->GetFriendsInterface();
-				if (!OnlineFriendsPtr.IsValid())
-				{
-					return;
-				}
-
-				TArray<TSharedRef<FOnlineFriend>> FriendsList;
-				OnlineFriendsPtr->GetFriendsList(LocalUserNum, ListName, FriendsList); // Getting all friends.
+				const int32 FirstRank = NameIndex->GetCollationRank(static_cast<uint32>(First.SteamID));
+				const int32 SecondRank = NameIndex->GetCollationRank(static_cast<uint32>(Second.SteamID));
 
-				for (const TSharedRef<FOnlineFriend>& Friend : FriendsList)
+				// Not indexed yet (e.g. roster still loading): after indexed friends, sorted by name.
+				if (FirstRank == INDEX_NONE || SecondRank == INDEX_NONE)
 				{
-					FriendsListNames.Add(Friend->GetDisplayName()); // Adding all friend's names.
+					return FirstRank != SecondRank ? SecondRank == INDEX_NONE : First.UserName.CompareTo(Second.UserName) < 0;
 				}
 
-				Callback.ExecuteIfBound(FriendsListNames); // Invoking the delegate: the function is ready!
-			}));
-
-	return bGetFriendsSuccessful;
-}
+				return FirstRank < SecondRank;
+			}
+		);
+	}
 
-void UPNetworkingInstanceSteam::AlphabeticalSortFriends(TArray<FUserSteamData>& FriendsToSort)
-{
-	FriendsToSort.Sort([](const FUserSteamData& First, const FUserSteamData& Second) { return First.UserName.ToString() < Second.UserName.ToString(); });
+	return true;
 }
 
-bool UPNetworkingInstanceSteam::ConvertCSteamIDToFUniqueNetID(const CSteamID SteamID, FUniqueNetIdPtr& CorrespondanceNetID)
+bool UPNetworkingInstanceSteam::SearchFriends(const FString& Query, TArray<FFriendRosterEntry>& Results, const int32 MaxResults, const bool bOnlineOnly)
 {
-	IOnlineSubsystem* OnlineSubsystemPtr = FPNetworkingModule::GetOnlineSubsystemPointer();
+	Results.Reset();
 
-	if (!OnlineSubsystemPtr)
+	const FFriendNameIndex* NameIndex = GetFriendNameIndex();
+	if (!NameIndex)
 	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("SearchFriends: FriendRoster not initialized!"));
 		return false;
 	}
 
-	uint64 SteamID64 = SteamID.ConvertToUint64();
-	FString SteamIDString = FString::Printf(TEXT("%llu"), SteamID64);
-
-	IOnlineIdentityPtr IdentityInterface = OnlineSubsystemPtr->GetIdentityInterface();
-	if (!IdentityInterface.IsValid())
-	{
-		return false;
-	}
+	// Offline friends are filtered after the search: ask for all of them.
+	TArray<int32> Rows;
+	NameIndex->Search(Query, bOnlineOnly ? MAX_int32 : MaxResults, Rows);
 
-	FUniqueNetIdPtr UniqueNetId = IdentityInterface->CreateUniquePlayerId(SteamIDString);
-	if (UniqueNetId.IsValid())
+	const FFriendListSnapshotRef Snapshot = FriendRoster->GetSnapshot();
+	for (int32 Index = 0; Index < Rows.Num() && Results.Num() < MaxResults; Index++)
 	{
-		CorrespondanceNetID = UniqueNetId;
-		return true;
+		if (!bOnlineOnly || Snapshot->PersonaStates[Rows[Index]] != EFriendPersonaState::PERSONA_OFFLINE)
+		{
+			Results.Add(Snapshot->MakeEntry(Rows[Index]));
+		}
 	}
 
-	return false;
+	return true;
 }
 
-CSteamID UPNetworkingInstanceSteam::ConvertInt32toCSteamID(const int32 SteamID)
+UFriendListSnapshot* UPNetworkingInstanceSteam::GetFriendListSnapshot()
 {
-	if (!FPNetworkingModule::IsOnlineAvailable(TEXT("IsOnlineAvailable: ConvertInt32toCSteamID Called it")))
+	if (!FriendRoster.IsValid())
 	{
-		return CSteamID();
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("GetFriendListSnapshot: FriendRoster not initialized!"));
+		return nullptr;
 	}
 
-	const uint32 UnsignedSteamID = static_cast<uint32>(SteamID);
-	CSteamID RealSteamID(UnsignedSteamID, EUniverse::k_EUniversePublic, EAccountType::k_EAccountTypeIndividual);
-	return RealSteamID;
+	if (FriendListSnapshot && static_cast<uint32>(FriendListSnapshot->GetVersion()) == FriendRoster->GetVersion())
+	{
+		return FriendListSnapshot;
+	}
+
+	// Old object is left to consumers still holding it.
+	FriendListSnapshot = NewObject<UFriendListSnapshot>(this);
+	FriendListSnapshot->SetSnapshot(FriendRoster->GetSnapshot());
+	return FriendListSnapshot;
 }
 
-bool UPNetworkingInstanceSteam::HandleOldSessionIfExisting()
+bool UPNetworkingInstanceSteam::GetFriendsRange(const int32 Start, const int32 Count, TArray<FFriendListRow>& Rows, int32& TotalRows, const EFriendListFilter Filter, const EFriendListSort Sort, const FString& Query, const EAvatarSize AvatarSize, const int32 PixelSize)
 {
-	IOnlineSessionPtr SessionInterface = FPNetworkingModule::GetOnlineSessionPointer();
-	if (!SessionInterface)
+	Rows.Reset();
+	TotalRows = 0;
+
+	const FFriendNameIndex* NameIndex = GetFriendNameIndex();
+	if (!NameIndex)
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("HandleOldSessionIfExisting: SessionInterface is invalid!"));
-		FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_INVALID);
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("GetFriendsRange: FriendRoster not initialized!"));
 		return false;
 	}
 
-	FNamedOnlineSession* ExistingSession = FPNetworkingModule::GetOnlineSessionPointer()->GetNamedSession(FPNetworkingModule::GetSessionName());
-	if (ExistingSession)
-	{
-		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("HandleOldSessionIfExisting: Old session found!"));
-		DestroySession();
-	}
-	else
+	if (!FriendListView.IsValid() || !FriendListView->Matches(FriendRoster->GetVersion(), Filter, Sort, Query))
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("HandleOldSessionIfExisting: Old session not found!"));
-		CreateSession();
+		FriendListView = MakeShared<FFriendListView>(FriendRoster->GetSnapshot(), *NameIndex, Filter, Sort, Query);
 	}
 
-	return true;
-}
+	TotalRows = FriendListView->Num();
 
-void UPNetworkingInstanceSteam::DestroySession()
-{
-	IOnlineSessionPtr SessionInterface = FPNetworkingModule::GetOnlineSessionPointer();
-	if (!SessionInterface.IsValid())
+	// Prefetch of previous range is dropped as the window moves.
+	PrefetchedAvatars.Reset();
+
+	const int32 First = FMath::Clamp(Start, 0, TotalRows);
+	const int32 Last = FMath::Clamp(First + FMath::Max(Count, 0), First, TotalRows);
+	if (First == Last)
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("DestroySession: SessionInterface is invalid!"));
-		FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_INVALID);
-		return;
+		return true;
 	}
 
-	FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_DESTROYING);
+	const FFriendListSnapshot& Snapshot = FriendListView->GetSnapshot();
+	const EAvatarSize TargetSize = FAvatarPipeline::ResolveAvatarSize(AvatarSize, PixelSize);
 
-	OnDestroySessionCompleteFromNewHostingUserHandle = SessionInterface->AddOnDestroySessionCompleteDelegate_Handle(
-		FOnDestroySessionCompleteDelegate::CreateUObject(this, &UPNetworkingInstanceSteam::OnDestroySessionCompleteFromNewHostingUser));
-
-	if (OnDestroySessionCompleteFromNewHostingUserHandle.IsValid() && SessionInterface->DestroySession(FPNetworkingModule::GetSessionName()))
+	Rows.Reserve(Last - First);
+	for (int32 Index = First; Index < Last; Index++)
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("DestroySession: Old session from new Host destroy call successfull!"));
+		const int32 SnapshotRow = FriendListView->GetSnapshotRow(Index);
+
+		FFriendListRow& Row = Rows.AddDefaulted_GetRef();
+		Row.Index = Index;
+		Row.Friend = Snapshot.MakeEntry(SnapshotRow);
+		Row.Avatar = ProgressiveAvatarProvider.IsValid() ? ProgressiveAvatarProvider->Acquire(CSteamID(Snapshot.SteamIDs[SnapshotRow]), TargetSize) : nullptr;
 	}
-	else
+
+	// Prefetch: the provider holds handles weakly, so they are kept alive until next range, else not fetched avatars would never be.
+	if (ProgressiveAvatarProvider.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("DestroySession: Can't Destroy old session or not existing!"));
-		FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_INVALID);
-		if (OnDestroySessionCompleteFromNewHostingUserHandle.IsValid())
+		const int32 PrefetchFirst = FMath::Max(First - FRIEND_LIST_VIEW_PREFETCH_ROWS, 0);
+		const int32 PrefetchLast = FMath::Min(Last + FRIEND_LIST_VIEW_PREFETCH_ROWS, TotalRows);
+
+		for (int32 Index = PrefetchFirst; Index < PrefetchLast; Index++)
 		{
-			SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(OnDestroySessionCompleteFromNewHostingUserHandle);
-			OnDestroySessionCompleteFromNewHostingUserHandle.Reset();
+			if (Index < First || Index >= Last)
+			{
+				if (UProgressiveAvatar* Avatar = ProgressiveAvatarProvider->Acquire(CSteamID(Snapshot.SteamIDs[FriendListView->GetSnapshotRow(Index)]), TargetSize))
+				{
+					PrefetchedAvatars.Add(Avatar);
+				}
+			}
 		}
 	}
+
+	return true;
 }
 
-void UPNetworkingInstanceSteam::CreateSession()
+#pragma endregion FriendRoster
+
+#pragma region RichPresence
+
+bool UPNetworkingInstanceSteam::RequestFriendsRichPresence(const TArray<int32>& SteamIDs)
 {
-	IOnlineSessionPtr SessionInterface = FPNetworkingModule::GetOnlineSessionPointer();
-	if (!SessionInterface.IsValid())
+	if (!RichPresenceCache.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("CreateSession: SessionInterface is invalid!"));
-		FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_INVALID);
-		return;
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("RequestFriendsRichPresence: RichPresenceCache not initialized!"));
+		return false;
 	}
 
-	CreateSessionCompleteDelegateHandle = SessionInterface->AddOnCreateSessionCompleteDelegate_Handle(FOnCreateSessionCompleteDelegate::CreateUObject(this, &UPNetworkingInstanceSteam::OnCreateSessionComplete));
+	TArray<uint64> RequestedSteamIDs;
+	if (SteamIDs.Num() > 0)
+	{
+		RequestedSteamIDs.Reserve(SteamIDs.Num());
+		for (const int32 SteamID : SteamIDs)
+		{
+			RequestedSteamIDs.Add(ConvertInt32toCSteamID(SteamID).ConvertToUint64());
+		}
+	}
+	else if (FriendRoster.IsValid())
+	{
+		RequestedSteamIDs.Reserve(FriendRoster->Num());
+		for (int32 Index = 0; Index < FriendRoster->Num(); Index++)
+		{
+			RequestedSteamIDs.Add(FriendRoster->GetSteamID64(Index));
+		}
+	}
 
-	SessionInterface->CreateSession(0, FPNetworkingModule::GetSessionName(), TempCreationSessionSettings);
+	RichPresenceCache->Request(RequestedSteamIDs);
+	return true;
 }
 
-bool UPNetworkingInstanceSteam::InitializeNetworkingInstance()
+bool UPNetworkingInstanceSteam::GetFriendRichPresence(const int32 SteamID, const FString& Key, FString& Value)
 {
-	if (!FPNetworkingModule::IsOnlineAvailable(TEXT("IsOnlineAvailable: InitializeNetworkingInstance Called it")))
+	Value.Reset();
+
+	if (!RichPresenceCache.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("InitializeNetworkingInstance: Online not available!"));
 		return false;
 	}
 
-	FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_INVALID);
+	const FString* CachedValue = RichPresenceCache->Find(ConvertInt32toCSteamID(SteamID).ConvertToUint64(), FName(*Key));
+	if (!CachedValue)
+	{
+		return false;
+	}
 
-	SessionUserInviteAcceptedDelegateHandle = FPNetworkingModule::GetOnlineSessionPointer()->AddOnSessionUserInviteAcceptedDelegate_Handle(
-		FOnSessionUserInviteAcceptedDelegate::CreateUObject(this, &UPNetworkingInstanceSteam::OnInviteAccepted));
+	Value = *CachedValue;
+	return true;
+}
 
-	if (SessionUserInviteAcceptedDelegateHandle.IsValid())
+bool UPNetworkingInstanceSteam::GetFriendRichPresencePairs(const int32 SteamID, TMap<FString, FString>& Pairs)
+{
+	Pairs.Reset();
+
+	TArray<TPair<FName, FString>> CachedPairs;
+	if (!RichPresenceCache.IsValid() || !RichPresenceCache->GetPairs(ConvertInt32toCSteamID(SteamID).ConvertToUint64(), CachedPairs))
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("InitializeNetworkingInstance: AcceptInvite Callback Initialized!"));
+		return false;
 	}
-	else
+
+	Pairs.Reserve(CachedPairs.Num());
+	for (const TPair<FName, FString>& Pair : CachedPairs)
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("InitializeNetworkingInstance: AcceptInvite Callback not initialized!"));
-		return false;
+		Pairs.Add(Pair.Key.ToString(), Pair.Value);
 	}
 
-	if (GEngine)
+	return true;
+}
+
+bool UPNetworkingInstanceSteam::GetJoinableFriends(TArray<FFriendRosterEntry>& Friends)
+{
+	Friends.Reset();
+
+	if (!RichPresenceCache.IsValid() || !FriendRoster.IsValid())
 	{
-		OnNetworkFailureDelegateHandle = GEngine->OnNetworkFailure().AddUObject(this, &UPNetworkingInstanceSteam::OnNetworkFailure);
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("GetJoinableFriends: RichPresenceCache or FriendRoster not initialized!"));
+		return false;
+	}
 
-		if (OnNetworkFailureDelegateHandle.IsValid())
-		{
-			UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("InitializeNetworkingInstance: Network failure delegate registered!"));
-		}
-		else
+	// Joinable users met outside the friendlist (e.g. lobby members) are skipped.
+	for (const uint64 SteamID : RichPresenceCache->GetJoinableSteamIDs())
+	{
+		if (const FFriendRosterEntry* Entry = FriendRoster->Find(SteamID))
 		{
-			UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("InitializeNetworkingInstance: Network failure delegate not registered!"));
-			return false;
+			Friends.Add(*Entry);
 		}
 	}
-	else
+
+	return true;
+}
+
+#pragma endregion RichPresence
+
+#pragma region FriendsGroups
+
+bool UPNetworkingInstanceSteam::GetFriendsGroups(TArray<FFriendsGroup>& Groups, const bool bForceRefresh)
+{
+	const FFriendsGroupIndex* GroupIndex = GetFriendsGroupIndex(bForceRefresh);
+	if (!GroupIndex)
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("InitializeNetworkingInstance: GEngine is invalid!"));
+		Groups.Reset();
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("GetFriendsGroups: FriendsGroupIndex not available!"));
 		return false;
 	}
 
+	Groups = GroupIndex->GetGroups();
 	return true;
 }
 
-void UPNetworkingInstanceSteam::DeInitializeNetworkingInstance()
+bool UPNetworkingInstanceSteam::GetFriendsGroupMembers(const int32 GroupID, TArray<FFriendRosterEntry>& Members, const bool bOnlineOnly)
 {
-	IOnlineSessionPtr SessionInterface = FPNetworkingModule::GetOnlineSessionPointer();
-	if (!SessionInterface.IsValid())
-	{
-		return;
-	}
+	Members.Reset();
 
-	if (SessionUserInviteAcceptedDelegateHandle.IsValid())
+	const FFriendsGroupIndex* GroupIndex = GetFriendsGroupIndex();
+	const TArray<uint64>* GroupMembers = GroupIndex ? GroupIndex->GetMembers(GroupID) : nullptr;
+	if (!GroupMembers || !FriendRoster.IsValid())
 	{
-		SessionInterface->ClearOnSessionUserInviteAcceptedDelegate_Handle(SessionUserInviteAcceptedDelegateHandle);
-		SessionUserInviteAcceptedDelegateHandle.Reset();
+		return false;
 	}
 
-	if (GEngine)
+	Members.Reserve(GroupMembers->Num());
+	for (const uint64 SteamID : *GroupMembers)
 	{
-		if (OnNetworkFailureDelegateHandle.IsValid())
+		const FFriendRosterEntry* Entry = FriendRoster->Find(SteamID);
+		if (Entry && (!bOnlineOnly || Entry->IsOnline()))
 		{
-			GEngine->OnNetworkFailure().Remove(OnNetworkFailureDelegateHandle);
-			OnNetworkFailureDelegateHandle.Reset();
+			Members.Add(*Entry);
 		}
 	}
+
+	return true;
 }
 
-#pragma endregion PrivateUtilityFunctions
+bool UPNetworkingInstanceSteam::GetFriendGroups(const int32 SteamID, TArray<int32>& GroupIDs)
+{
+	GroupIDs.Reset();
 
-#pragma region CallbackFunctions
+	const FFriendsGroupIndex* GroupIndex = GetFriendsGroupIndex();
+	if (!GroupIndex)
+	{
+		return false;
+	}
+
+	GroupIDs = GroupIndex->GetGroupsOf(ConvertInt32toCSteamID(SteamID).ConvertToUint64());
+	return true;
+}
 
-void UPNetworkingInstanceSteam::OnCreateSessionComplete(FName NewName, bool bWasSuccessfull)
+int32 UPNetworkingInstanceSteam::GetFriendsGroupPlayersData(const int32 GroupID, const bool bAlphabeticalSort, const FOnFriendsDataReady& Callback, const EAvatarSize AvatarSize, const int32 PixelSize)
 {
-	if (CreateSessionCompleteDelegateHandle.IsValid())
+	if (!FPNetworkingModule::IsOnlineAvailable(TEXT("IsOnlineAvailable: GetFriendsGroupPlayersData Called it")))
 	{
-		FPNetworkingModule::GetOnlineSessionPointer()->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);
-		CreateSessionCompleteDelegateHandle.Reset();
-		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("OnCreateSessionComplete: OnCreateSessionComplete delegate cleared!"));
+		return 0;
 	}
 
-	if (!bWasSuccessfull)
+	const FFriendsGroupIndex* GroupIndex = GetFriendsGroupIndex();
+	const TArray<uint64>* GroupMembers = GroupIndex ? GroupIndex->GetMembers(GroupID) : nullptr;
+	if (!GroupMembers || !ProgressiveAvatarProvider.IsValid() || !FriendRoster.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("OnCreateSessionComplete: Creating Session error!"));
-		FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_INVALID);
-		return;
+		return 0;
 	}
 
-	if (!GEngine)
+	const EAvatarSize TargetSize = FAvatarPipeline::ResolveAvatarSize(AvatarSize, PixelSize);
+
+	TArray<FUserSteamData> UserSteamData;
+	UserSteamData.Reserve(GroupMembers->Num());
+
+	for (const uint64 SteamID : *GroupMembers)
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("OnCreateSessionComplete: GEngine is invalid!"));
-		FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_INVALID);
-		return;
+		const FFriendRosterEntry* Entry = FriendRoster->Find(SteamID);
+		if (!Entry)
+		{
+			continue;
+		}
+
+		UProgressiveAvatar* Avatar = ProgressiveAvatarProvider->Acquire(CSteamID(SteamID), TargetSize);
+
+		FUserSteamData& FriendData = UserSteamData.Add_GetRef(FUserSteamData(Entry->SteamID, Entry->UserName, Avatar->Texture));
+		FriendData.ProgressiveAvatar = Avatar;
 	}
 
-	UWorld* World = GEngine->GetWorldContexts().Num() > 0 ? GEngine->GetWorldContexts()[0].World() : nullptr;
-	if (!World)
+	if (bAlphabeticalSort)
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("OnCreateSessionComplete: World not found!"));
-		FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_INVALID);
-		return;
+		AlphabeticalSortFriends(UserSteamData);
 	}
 
-	const FString ServerMap = MapPathToTravel + TEXT("?listen");
-	const bool bServerTravelResult = World->ServerTravel(ServerMap);
-	if (bServerTravelResult)
+	Callback.ExecuteIfBound(UserSteamData);
+	return 1;
+}
+
+#pragma endregion FriendsGroups
+
+#pragma region RecentPlayers
+
+bool UPNetworkingInstanceSteam::GetRecentPlayers(TArray<FRecentPlayer>& Players, const int32 MaxPlayers, const EAvatarSize AvatarSize, const int32 PixelSize)
+{
+	Players.Reset();
+
+	if (!RecentPlayers.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("OnCreateSessionComplete: Server Travel Complete!"));
-		FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_VALID);
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("GetRecentPlayers: RecentPlayers not initialized!"));
+		return false;
 	}
-	else
+
+	TArray<const FRecentPlayers::FRecord*> Records;
+	RecentPlayers->GetPlayers(Records, MaxPlayers);
+
+	const EAvatarSize TargetSize = FAvatarPipeline::ResolveAvatarSize(AvatarSize, PixelSize);
+
+	Players.Reserve(Records.Num());
+	for (const FRecentPlayers::FRecord* Record : Records)
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("OnCreateSessionComplete: Server Travel Error!"));
-		FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_INVALID);
+		FRecentPlayer& Player = Players.AddDefaulted_GetRef();
+		Player.SteamID = static_cast<int32>(CSteamID(Record->SteamID).GetAccountID());
+		Player.UserName = FText::FromString(Record->UserName);
+		Player.LastPlayed = Record->LastPlayed;
+		Player.bIsFriend = FriendRoster.IsValid() && FriendRoster->Find(Record->SteamID) != nullptr;
+		Player.Avatar = ProgressiveAvatarProvider.IsValid() ? ProgressiveAvatarProvider->Acquire(CSteamID(Record->SteamID), TargetSize) : nullptr;
+	}
+
+	return true;
+}
+
+void UPNetworkingInstanceSteam::ClearRecentPlayers()
+{
+	if (RecentPlayers.IsValid())
+	{
+		RecentPlayers->Clear();
 	}
 }
 
-void UPNetworkingInstanceSteam::OnInviteAccepted(bool bWasSuccessful, int32 LocalUserNum, FUniqueNetIdPtr FriendID, const FOnlineSessionSearchResult& InviteResult)
+#pragma endregion RecentPlayers
+
+#pragma region UserDirectory
+
+int32 UPNetworkingInstanceSteam::ResolveUsers(const TArray<int32>& SteamIDs, const FOnFriendsDataReady& Callback, const EAvatarSize AvatarSize, const int32 PixelSize)
 {
-	IOnlineSessionPtr SessionInterface = FPNetworkingModule::GetOnlineSessionPointer();
-	if (!SessionInterface.IsValid())
+	if (!FPNetworkingModule::IsOnlineAvailable(TEXT("IsOnlineAvailable: ResolveUsers Called it")))
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("OnInviteAccepted: SessionInterface is invalid!"));
-		return;
+		return 0;
 	}
 
-	TempPrevSessionState = FPNetworkingModule::GetLocalSessionCurrentState();
+	if (!UserDirectory.IsValid() || !ProgressiveAvatarProvider.IsValid())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("ResolveUsers: UserDirectory not initialized!"));
+		return 0;
+	}
 
-	if (bWasSuccessful)
+	TArray<uint64> RequestedSteamIDs;
+	RequestedSteamIDs.Reserve(SteamIDs.Num());
+	for (const int32 SteamID : SteamIDs)
 	{
-		FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_PENDING);
+		RequestedSteamIDs.Add(ConvertInt32toCSteamID(SteamID).ConvertToUint64());
+	}
+
+	const EAvatarSize TargetSize = FAvatarPipeline::ResolveAvatarSize(AvatarSize, PixelSize);
+	TSharedRef<bool> bIsResolvedNow = MakeShared<bool>(false);
 
-		if (SessionInterface->GetNamedSession(FPNetworkingModule::GetSessionName()))
+	UserDirectory->Resolve(RequestedSteamIDs, FOnUserDirectoryBatchResolved::CreateWeakLambda(this, [this, Callback, TargetSize, bIsResolvedNow](const TArray<uint64>& ResolvedSteamIDs)
 		{
-			UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("OnInviteAccepted: Session existing, need to destroy it!"));
+			*bIsResolvedNow = true;
 
-			LastInviteResult = InviteResult;
-			OnClientNewInviteAcceptionDestroySessionCompleteHandle = SessionInterface->AddOnDestroySessionCompleteDelegate_Handle(
-				FOnDestroySessionCompleteDelegate::CreateUObject(this, &UPNetworkingInstanceSteam::OnClientNewInviteAcceptionDestroySessionComplete));
+			TArray<FUserSteamData> UserSteamData;
+			UserSteamData.Reserve(ResolvedSteamIDs.Num());
 
-			if (FPNetworkingModule::GetOnlineSessionPointer()->DestroySession(FPNetworkingModule::GetSessionName()))
-			{
-				FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_DESTROYING);
-				UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("OnInviteAccepted: DestroySession request true!"));
-			}
-			else
+			for (const uint64 SteamID : ResolvedSteamIDs)
 			{
-				if (OnClientNewInviteAcceptionDestroySessionCompleteHandle.IsValid())
-				{
-					SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(OnClientNewInviteAcceptionDestroySessionCompleteHandle);
-					OnClientNewInviteAcceptionDestroySessionCompleteHandle.Reset();
-				}
-
-				FPNetworkingModule::SetLocalSessionCurrentState(TempPrevSessionState);
+				const FUserDirectoryEntry* Entry = UserDirectory.IsValid() ? UserDirectory->Find(SteamID) : nullptr;
+				UProgressiveAvatar* Avatar = ProgressiveAvatarProvider.IsValid() ? ProgressiveAvatarProvider->Acquire(CSteamID(SteamID), TargetSize) : nullptr;
+
+				FUserSteamData& UserData = UserSteamData.AddDefaulted_GetRef();
+				UserData.SteamID = static_cast<int32>(CSteamID(SteamID).GetAccountID());
+				UserData.UserName = Entry ? FText::FromString(Entry->UserName) : UserData.UserName;
+				UserData.UserAvatar = Avatar ? Avatar->Texture : nullptr;
+				UserData.ProgressiveAvatar = Avatar;
 			}
 
-			return;
+			Callback.ExecuteIfBound(UserSteamData);
 		}
+	));
+
+	return *bIsResolvedNow ? 1 : -1;
+}
+
+#pragma endregion UserDirectory
 
-		JoinSessionCompleteDelegateHandle = SessionInterface->AddOnJoinSessionCompleteDelegate_Handle(
-			FOnJoinSessionCompleteDelegate::CreateUObject(this, &UPNetworkingInstanceSteam::OnJoinSessionComplete));
-		const bool bHasJoined = SessionInterface->JoinSession(0, FPNetworkingModule::GetSessionName(), InviteResult);
+#pragma region LobbyBrowser
+
+int32 UPNetworkingInstanceSteam::FindLobbies(const FLobbySearchParameters& Parameters, const FOnLobbiesFound& Callback)
+{
+	if (!LobbyBrowser.IsValid())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FindLobbies: LobbyBrowser not valid!"));
+		return 0;
+	}
 
-		if (bHasJoined)
+	return LobbyBrowser->Search(Parameters, FOnLobbySearchBatch::CreateWeakLambda(this, [Callback](const int32 SearchID, const TArray<FLobbySearchRow>& Lobbies, const bool bIsComplete)
 		{
-			UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("OnInviteAccepted: Invite Acception Success by %s"), *InviteResult.Session.OwningUserName);
+			Callback.ExecuteIfBound(SearchID, Lobbies, bIsComplete);
 		}
-		else
+	));
+}
+
+void UPNetworkingInstanceSteam::CancelLobbySearch()
+{
+	if (LobbyBrowser.IsValid())
+	{
+		LobbyBrowser->Cancel();
+	}
+}
+
+int32 UPNetworkingInstanceSteam::RequestLobbyDetails(const int64 LobbyID, FLobbyDetails& Details, const FOnLobbyDetailsReady& Callback)
+{
+	if (!LobbyBrowser.IsValid() || LobbyID == 0)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("RequestLobbyDetails: LobbyBrowser not valid!"));
+		return 0;
+	}
+
+	const bool bIsReady = LobbyBrowser->RequestDetails(static_cast<uint64>(LobbyID), Details, FOnLobbyDetailsRequested::CreateWeakLambda(this, [Callback](const FLobbyDetails& RequestedDetails)
 		{
-			UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("OnInviteAccepted: Invite Acception Error!"));
-			FPNetworkingModule::SetLocalSessionCurrentState(TempPrevSessionState);
+			Callback.ExecuteIfBound(RequestedDetails);
 		}
-	}
-	else
+	));
+
+	if (!bIsReady)
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("Invite Acception Error!"));
+		return -1;
 	}
+
+	return Details.bIsValid ? 1 : 0;
 }
 
-void UPNetworkingInstanceSteam::OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result)
+#pragma endregion LobbyBrowser
+
+#pragma region SessionManagement
+
+bool UPNetworkingInstanceSteam::RequestSessionCreation(FSessionCreationParameters SessionCreationParameters, int32& OperationID)
 {
-	IOnlineSessionPtr SessionInterface = FPNetworkingModule::GetOnlineSessionPointer();
-	if (!SessionInterface.IsValid())
+	OperationID = 0;
+
+	if (!SessionOrchestrator.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("OnJoinSessionComplete: SessionInterface is invalid!"));
-		FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_INVALID);
-		return;
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("RequestSessionCreation: SessionOrchestrator not valid!"));
+		return false;
 	}
 
-	if (JoinSessionCompleteDelegateHandle.IsValid())
+	FOnlineSessionSettings SessionSettings;
+	SessionSettings.NumPublicConnections = SessionCreationParameters.NumPublicConnections;
+	SessionSettings.NumPrivateConnections = SessionCreationParameters.NumPrivateConnections;
+	SessionSettings.bShouldAdvertise = SessionCreationParameters.bShouldAdvertise;
+	SessionSettings.bAllowJoinInProgress = SessionCreationParameters.bAllowJoinInProgress;
+	SessionSettings.bIsLANMatch = SessionCreationParameters.bIsLANMatch;
+	SessionSettings.bIsDedicated = SessionCreationParameters.bIsDedicated;
+	SessionSettings.bAllowInvites = SessionCreationParameters.bAllowInvites;
+	SessionSettings.bUsesPresence = SessionCreationParameters.bUsesPresence;
+	SessionSettings.bAllowJoinViaPresence = SessionCreationParameters.bAllowJoinViaPresence;
+	SessionSettings.bAllowJoinViaPresenceFriendsOnly = SessionCreationParameters.bAllowJoinViaPresenceFriendsOnly;
+	SessionSettings.bUseLobbiesIfAvailable = SessionCreationParameters.bUseLobbiesIfAvailable;
+
+	// Old session, if any, is destroyed first by the orchestrator, which also publishes host ping location.
+	OperationID = SessionOrchestrator->Create(SessionSettings, SessionCreationParameters.TravelToMapPath);
+	return OperationID != 0;
+}
+
+bool UPNetworkingInstanceSteam::RequestSessionDestruction(int32& OperationID)
+{
+	OperationID = 0;
+
+	if (!SessionOrchestrator.IsValid())
 	{
-		SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegateHandle);
-		JoinSessionCompleteDelegateHandle.Reset();
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("RequestSessionDestruction: SessionOrchestrator not valid!"));
+		return false;
 	}
 
-	if (Result != EOnJoinSessionCompleteResult::Success)
+	OperationID = SessionOrchestrator->Destroy();
+	return OperationID != 0;
+}
+
+bool UPNetworkingInstanceSteam::InviteFriend(const int32 SteamID, int32& OperationID)
+{
+	OperationID = 0;
+
+	if (!SessionOrchestrator.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("OnJoinSessionComplete: Join Session failed!"));
-		FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_INVALID);
-		return;
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("InviteFriend: SessionOrchestrator not valid!"));
+		return false;
 	}
 
-	FString ConnectInfo;
-	if (!SessionInterface->GetResolvedConnectString(SessionName, ConnectInfo))
+	const CSteamID FriendSteamID = ConvertInt32toCSteamID(SteamID);
+	FUniqueNetIdPtr FriendUniqueNetID;
+
+	if (!ConvertCSteamIDToFUniqueNetID(FriendSteamID, FriendUniqueNetID))
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("OnJoinSessionComplete: Failed to get resolved connect string!"));
-		FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_INVALID);
-		return;
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("InviteFriend: Can't convert SteamID!"));
+		return false;
 	}
 
-	UWorld* World = GEngine->GetWorldContexts().Num() > 0 ? GEngine->GetWorldContexts()[0].World() : nullptr;
-	if (!World)
+	// Sent once a session being created or joined is ready, instead of being rejected.
+	OperationID = SessionOrchestrator->Invite(FriendUniqueNetID);
+	return OperationID != 0;
+}
+
+void UPNetworkingInstanceSteam::QuitSession(const FString& TravelBackMapPath, int32& OperationID)
+{
+	OperationID = 0;
+
+	if (!SessionOrchestrator.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("OnJoinSessionComplete: World is null!"));
-		FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_INVALID);
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("QuitSession: SessionOrchestrator not valid!"));
 		return;
 	}
 
-	APlayerController* PlayerController = UGameplayStatics::GetPlayerController(World, 0);
-	if (!PlayerController)
+	OperationID = SessionOrchestrator->Quit(TravelBackMapPath);
+}
+
+bool UPNetworkingInstanceSteam::GetSessionParameters(FGetSessionParameters& SessionParameters) const
+{
+	IOnlineSessionPtr OnlineSession = FPNetworkingModule::GetOnlineSessionPointer();
+	if (!OnlineSession.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("OnJoinSessionComplete: PlayerController is null!"));
-		FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_INVALID);
-		return;
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("GetSessionParameters: OnlineSession is null!"));
+		return false;
 	}
 
-	FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_VALID);
-	PlayerController->ClientTravel(ConnectInfo, ETravelType::TRAVEL_Absolute);
+	FOnlineSessionSettings* SessionSettings = OnlineSession->GetSessionSettings(FPNetworkingModule::GetSessionName());
+	if (!SessionSettings)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("GetSessionParameters: SessionSettings is null!"));
+		return false;
+	}
+	
+	SessionParameters.NumPublicConnections = SessionSettings->NumPublicConnections;
+	SessionParameters.NumPrivateConnections = SessionSettings->NumPrivateConnections;
+	SessionParameters.bShouldAdvertise = SessionSettings->bShouldAdvertise;
+	SessionParameters.bAllowJoinInProgress = SessionSettings->bAllowJoinInProgress;
+	SessionParameters.bIsLANMatch = SessionSettings->bIsLANMatch;
+	SessionParameters.bIsDedicated = SessionSettings->bIsDedicated;
+	SessionParameters.bAllowInvites = SessionSettings->bAllowInvites;
 
-	UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("OnJoinSessionComplete: Client Travel to: %s"), *ConnectInfo);
+	return true;
 }
 
-void UPNetworkingInstanceSteam::OnNetworkFailure(UWorld* World, UNetDriver* NetDriver, ENetworkFailure::Type FailureType, const FString& ErrorString)
+bool UPNetworkingInstanceSteam::UpdateSessionParameters_AuthorityOnly(const AActor* Requester, const FUpdateSessionParameters& SessionParameters, const FOnSessionParametersUpdateReady& Callback, int32& OperationID)
 {
-	UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("OnNetworkFailure: Error -> %s"), *ErrorString);
-	IOnlineSessionPtr OnlineSession = FPNetworkingModule::GetOnlineSessionPointer();
-	if (!OnlineSession.IsValid())
+	OperationID = 0;
+
+	if (!SessionOrchestrator.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("OnNetworkFailure: OnlineSession is invalid!"));
-		FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_INVALID);
-		return;
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("UpdateSessionParameters_AuthorityOnly: SessionOrchestrator not valid!"));
+		return false;
+	}
+
+	if (!Requester) 
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("UpdateSessionParameters_AuthorityOnly: Requester is null!"));
+		return false;
+	}
+
+	if (!Requester->HasAuthority())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("UpdateSessionParameters_AuthorityOnly: Requester has no Autority!"));
+		return false;
+	}
+
+	// Settings are applied when the update runs, so they are never overwritten by a session still being created.
+	// Only fields changed by this call are applied: merged calls keep each other's changes.
+	OperationID = SessionOrchestrator->Update(SessionParameters, FOnSessionOperationDone::CreateWeakLambda(this, [Callback](const FSessionOperationResult& Result)
+		{
+			Callback.ExecuteIfBound(FPNetworkingModule::GetSessionName(), Result.bWasSuccessful);
+		}
+	));
+
+	return OperationID != 0;
+}
+
+void UPNetworkingInstanceSteam::SetSessionUpdateWindow(const float Seconds)
+{
+	if (!SessionOrchestrator.IsValid())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("SetSessionUpdateWindow: SessionOrchestrator not valid!"));
+		return;
+	}
+
+	SessionOrchestrator->SetUpdateWindow(Seconds);
+}
+
+bool UPNetworkingInstanceSteam::IsSessionJoinable() const
+{
+	FGetSessionParameters GotSessionParameters;
+	
+	if (!GetSessionParameters(GotSessionParameters))
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("IsSessionJoinable: Cannot retreive parameters!"));
+		return false;
+	}
+
+	return  FPNetworkingModule::GetLocalSessionCurrentState() == ELocalSessionState::SESSION_VALID &&
+		    GotSessionParameters.bShouldAdvertise &&
+		    GotSessionParameters.bAllowJoinInProgress &&
+		    GotSessionParameters.bAllowInvites;
+}
+
+bool UPNetworkingInstanceSteam::QuickJoinSession(const int32 MaxPingMs, const FOnQuickJoinComplete& Callback)
+{
+	IOnlineSessionPtr SessionInterface = FPNetworkingModule::GetOnlineSessionPointer();
+	if (!SessionInterface.IsValid() || !SessionOrchestrator.IsValid())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("QuickJoinSession: Session interface or SessionOrchestrator not valid!"));
+		return false;
+	}
+
+	if (QuickJoinSearch.IsValid())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("QuickJoinSession: Quick join already running!"));
+		return false;
+	}
+
+	QuickJoinSearch = MakeShared<FOnlineSessionSearch>();
+	QuickJoinSearch->MaxSearchResults = QUICK_JOIN_MAX_SEARCH_RESULTS;
+	QuickJoinSearch->bIsLanQuery = false;
+	QuickJoinSearch->QuerySettings.Set(SEARCH_LOBBIES, true, EOnlineComparisonOp::Equals);
+	QuickJoinMaxPingMs = MaxPingMs;
+	QuickJoinCallback = Callback;
+
+	QuickJoinFindSessionsDelegateHandle = SessionInterface->AddOnFindSessionsCompleteDelegate_Handle(
+		FOnFindSessionsCompleteDelegate::CreateUObject(this, &UPNetworkingInstanceSteam::OnQuickJoinSearchComplete));
+
+	// If the delegate already fired, Callback was already invoked.
+	if (!SessionInterface->FindSessions(0, QuickJoinSearch.ToSharedRef()) && QuickJoinSearch.IsValid())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("QuickJoinSession: FindSessions failed!"));
+		SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(QuickJoinFindSessionsDelegateHandle);
+		QuickJoinSearch.Reset();
+		QuickJoinCallback.Unbind();
+		return false;
+	}
+
+	return true;
+}
+
+bool UPNetworkingInstanceSteam::IsSessionBusy() const
+{
+	return SessionOrchestrator.IsValid() && SessionOrchestrator->IsBusy();
+}
+
+ERelayNetworkState UPNetworkingInstanceSteam::GetRelayNetworkState() const
+{
+	TSharedPtr<FRelayNetwork> RelayNetwork = FPNetworkingModule::GetRelayNetwork();
+	return RelayNetwork.IsValid() ? RelayNetwork->GetState() : ERelayNetworkState::RELAY_NOT_STARTED;
+}
+
+#pragma endregion SessionManagement
+
+#pragma region PrivateUtilityFunctions
+
+bool UPNetworkingInstanceSteam::GetFriendList(const FOnFriendsListReady& Callback, const EFriendsLists::Type Query, const int32 LocalUserNum, const bool bForceRefresh)
+{
+	IOnlineSubsystem* OnlineSubsystemPtr = FPNetworkingModule::GetOnlineSubsystemPointer();
+	if (!OnlineSubsystemPtr)
+	{
+		return false;
+	}
+
+	IOnlineFriendsPtr FriendsInterface = OnlineSubsystemPtr->GetFriendsInterface();
+	if (!FriendsInterface.IsValid())
+	{
+		return false;
+	}
+
+	const uint64 CacheKey = (static_cast<uint64>(static_cast<uint32>(LocalUserNum)) << 32) | static_cast<uint32>(Query);
+	FFriendListNamesCacheEntry& CacheEntry = FriendListNamesCache.FindOrAdd(CacheKey);
+
+	// Fresh list: no Online Subsystem call and no copy of FOnlineFriend data.
+	if (!bForceRefresh && CacheEntry.ReadTime > 0.0 && FPlatformTime::Seconds() - CacheEntry.ReadTime < FriendListNamesCacheTTL)
+	{
+		Callback.ExecuteIfBound(CacheEntry.Names);
+		return true;
+	}
+
+	// A read is already running: its result is fresh enough, even if forced.
+	CacheEntry.Waiters.Add(Callback);
+	if (CacheEntry.bIsReading)
+	{
+		return true;
+	}
+
+	CacheEntry.bIsReading = true;
+
+	// Read the friends list before get all the names.
+	const bool bGetFriendsSuccessful = FriendsInterface->ReadFriendsList(
+		LocalUserNum,
+		EFriendsLists::ToString(Query),
+		FOnReadFriendsListComplete::CreateWeakLambda(this, [this, CacheKey](int32 LocalUserNum, bool bWasSuccessful, const FString& ListName, const FString& ErrorStr)
+			{
+				FFriendListNamesCacheEntry* ReadEntry = FriendListNamesCache.Find(CacheKey);
+				if (!ReadEntry)
+				{
+					return;
+				}
+
+				ReadEntry->bIsReading = false;
+				TArray<FOnFriendsListReady> Waiters = MoveTemp(ReadEntry->Waiters);
+
+				if (!bWasSuccessful)
+				{
+					return;
+				}
+
+				IOnlineSubsystem* OnlineSubsystemPtr = FPNetworkingModule::GetOnlineSubsystemPointer();
+				if (!OnlineSubsystemPtr)
+				{
+					return;
+				}
+
+				IOnlineFriendsPtr OnlineFriendsPtr = OnlineSubsystemPtr->GetFriendsInterface();
+				if (!OnlineFriendsPtr.IsValid())
+				{
+					return;
+				}
+
+				TArray<TSharedRef<FOnlineFriend>> FriendsList;
+				OnlineFriendsPtr->GetFriendsList(LocalUserNum, ListName, FriendsList); // Getting all friends.
+
+				ReadEntry->Names.Reset(FriendsList.Num());
+				for (const TSharedRef<FOnlineFriend>& Friend : FriendsList)
+				{
+					ReadEntry->Names.Add(Friend->GetDisplayName()); // Adding all friend's names.
+				}
+				ReadEntry->ReadTime = FPlatformTime::Seconds();
+
+				// Waiters may call again and change the map: they get a stable copy.
+				const TArray<FString> FriendsListNames = ReadEntry->Names;
+				for (const FOnFriendsListReady& Waiter : Waiters)
+				{
+					Waiter.ExecuteIfBound(FriendsListNames); // Invoking the delegate: the function is ready!
+				}
+			}));
+
+	if (!bGetFriendsSuccessful)
+	{
+		FFriendListNamesCacheEntry& FailedEntry = FriendListNamesCache.FindOrAdd(CacheKey);
+		FailedEntry.bIsReading = false;
+		FailedEntry.Waiters.Reset();
+	}
+
+	return bGetFriendsSuccessful;
+}
+
+void UPNetworkingInstanceSteam::InvalidateFriendListNamesCache()
+{
+	// Running reads are kept: their waiters still get a result.
+	for (TPair<uint64, FFriendListNamesCacheEntry>& Pair : FriendListNamesCache)
+	{
+		Pair.Value.ReadTime = 0.0;
+	}
+}
+
+void UPNetworkingInstanceSteam::AlphabeticalSortFriends(TArray<FUserSteamData>& FriendsToSort)
+{
+	// Collation ranks are precomputed once per roster change.
+	const FFriendNameIndex* NameIndex = GetFriendNameIndex();
+	if (NameIndex)
+	{
+		FriendsToSort.Sort([NameIndex](const FUserSteamData& First, const FUserSteamData& Second)
+			{
+				const int32 FirstRank = NameIndex->GetCollationRank(static_cast<uint32>(First.SteamID));
+				const int32 SecondRank = NameIndex->GetCollationRank(static_cast<uint32>(Second.SteamID));
+
+				// Not indexed yet (e.g. roster still loading): after indexed friends, sorted by name.
+				if (FirstRank == INDEX_NONE || SecondRank == INDEX_NONE)
+				{
+					return FirstRank != SecondRank ? SecondRank == INDEX_NONE : First.UserName.CompareTo(Second.UserName) < 0;
+				}
+
+				return FirstRank < SecondRank;
+			}
+		);
+		return;
+	}
+
+	FriendsToSort.Sort([](const FUserSteamData& First, const FUserSteamData& Second) { return First.UserName.CompareTo(Second.UserName) < 0; });
+}
+
+const FFriendNameIndex* UPNetworkingInstanceSteam::GetFriendNameIndex()
+{
+	if (!FriendRoster.IsValid())
+	{
+		return nullptr;
+	}
+
+	if (!FriendNameIndex.IsValid() || FriendNameIndex->GetVersion() != FriendRoster->GetVersion())
+	{
+		FriendNameIndex = MakeShared<FFriendNameIndex>(*FriendRoster->GetSnapshot());
+	}
+
+	return FriendNameIndex.Get();
+}
+
+const FFriendsGroupIndex* UPNetworkingInstanceSteam::GetFriendsGroupIndex(const bool bForceRefresh)
+{
+	if (!FriendsGroupIndex.IsValid())
+	{
+		return nullptr;
+	}
+
+	if ((bForceRefresh || FriendsGroupIndex->IsStale()) && !FriendsGroupIndex->Rebuild())
+	{
+		return nullptr;
+	}
+
+	return FriendsGroupIndex.Get();
+}
+
+bool UPNetworkingInstanceSteam::ConvertCSteamIDToFUniqueNetID(const CSteamID SteamID, FUniqueNetIdPtr& CorrespondanceNetID)
+{
+	IOnlineSubsystem* OnlineSubsystemPtr = FPNetworkingModule::GetOnlineSubsystemPointer();
+
+	if (!OnlineSubsystemPtr)
+	{
+		return false;
+	}
+
+	uint64 SteamID64 = SteamID.ConvertToUint64();
+	FString SteamIDString = FString::Printf(TEXT("%llu"), SteamID64);
+
+	IOnlineIdentityPtr IdentityInterface = OnlineSubsystemPtr->GetIdentityInterface();
+	if (!IdentityInterface.IsValid())
+	{
+		return false;
+	}
+
+	FUniqueNetIdPtr UniqueNetId = IdentityInterface->CreateUniquePlayerId(SteamIDString);
+	if (UniqueNetId.IsValid())
+	{
+		CorrespondanceNetID = UniqueNetId;
+		return true;
+	}
+
+	return false;
+}
+
+CSteamID UPNetworkingInstanceSteam::ConvertInt32toCSteamID(const int32 SteamID)
+{
+	if (!FPNetworkingModule::IsOnlineAvailable(TEXT("IsOnlineAvailable: ConvertInt32toCSteamID Called it")))
+	{
+		return CSteamID();
+	}
+
+	const uint32 UnsignedSteamID = static_cast<uint32>(SteamID);
+	CSteamID RealSteamID(UnsignedSteamID, EUniverse::k_EUniversePublic, EAccountType::k_EAccountTypeIndividual);
+	return RealSteamID;
+}
+
+bool UPNetworkingInstanceSteam::InitializeNetworkingInstance()
+{
+	if (!FPNetworkingModule::IsOnlineAvailable(TEXT("IsOnlineAvailable: InitializeNetworkingInstance Called it")))
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("InitializeNetworkingInstance: Online not available!"));
+		return false;
+	}
+
+	FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_INVALID);
+
+	AvatarTexturePool = MakeShared<FAvatarTexturePool>();
+	AvatarCache = MakeShared<FAvatarCache>();
+	AvatarCache->SetTexturePool(AvatarTexturePool);
+	AvatarDiskCache = MakeShared<FAvatarDiskCache>();
+	AvatarDiskCache->Load();
+	AvatarPipeline = MakeShared<FAvatarPipeline>(AvatarCache, AvatarDiskCache, AvatarTexturePool);
+	AvatarAtlas = MakeShared<FAvatarAtlas>(AvatarPipeline);
+	AvatarAtlas->OnRepacked.AddWeakLambda(this, [this]() { OnAvatarAtlasRepacked.Broadcast(); });
+	AvatarAtlas->OnEvicted.AddWeakLambda(this, [this](const uint64 SteamID) { OnAvatarAtlasEvicted.Broadcast(static_cast<int32>(CSteamID(SteamID).GetAccountID())); });
+	ProgressiveAvatarProvider = MakeShared<FProgressiveAvatarProvider>(AvatarPipeline);
+
+	FriendsGroupIndex = MakeShared<FFriendsGroupIndex>();
+
+	FriendRoster = MakeShared<FFriendRoster>();
+	if (FriendRoster->Initialize())
+	{
+		// Persisted friends whose avatar on disk is unchanged keep it: their live avatar handle does not refresh it.
+		FriendRoster->ValidateAvatarHashes([this](const uint64 SteamID)
+			{
+				uint32 AvatarHash = 0;
+				return AvatarDiskCache->FindHash(SteamID, AvatarHash) ? AvatarHash : 0;
+			}
+		);
+		AvatarPipeline->OnTextureUpdated.AddWeakLambda(this, [this](const uint64 SteamID, const EAvatarSize AvatarSize, UTexture2D* AvatarTexture)
+			{
+				uint32 AvatarHash = 0;
+				if (FriendRoster.IsValid() && AvatarDiskCache.IsValid() && AvatarDiskCache->FindHash(SteamID, AvatarHash))
+				{
+					FriendRoster->UpdateAvatarHash(SteamID, AvatarHash);
+				}
+			}
+		);
+
+		// New or removed friends may change groups membership and cached friends lists.
+		FriendRoster->OnAdded.AddWeakLambda(this, [this](const FFriendRosterEntry& Entry) { FriendsGroupIndex->MarkDirty(); InvalidateFriendListNamesCache(); OnFriendAdded.Broadcast(Entry); });
+		FriendRoster->OnUpdated.AddWeakLambda(this, [this](const FFriendRosterEntry& Entry) { OnFriendUpdated.Broadcast(Entry); });
+		FriendRoster->OnRemoved.AddWeakLambda(this, [this](const int32 SteamID) { FriendsGroupIndex->MarkDirty(); InvalidateFriendListNamesCache(); OnFriendRemoved.Broadcast(SteamID); });
+		FriendRoster->OnVersionChanged.AddWeakLambda(this, [this]()
+			{
+				if (OnFriendListSnapshotChanged.IsBound())
+				{
+					OnFriendListSnapshotChanged.Broadcast(GetFriendListSnapshot());
+				}
+			}
+		);
+	}
+	else
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("InitializeNetworkingInstance: FriendRoster not initialized!"));
+		FriendRoster.Reset();
+	}
+
+	UserDirectory = MakeShared<FUserDirectory>();
+	if (UserDirectory->Initialize())
+	{
+		UserDirectory->OnEntryChanged.AddWeakLambda(this, [this](const uint64 SteamID) { OnUserDataChanged.Broadcast(static_cast<int32>(CSteamID(SteamID).GetAccountID())); });
+	}
+	else
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("InitializeNetworkingInstance: UserDirectory not initialized!"));
+		UserDirectory.Reset();
+	}
+
+	RecentPlayers = MakeShared<FRecentPlayers>();
+	if (RecentPlayers->Initialize())
+	{
+		RecentPlayers->OnChanged.AddWeakLambda(this, [this]() { OnRecentPlayersChanged.Broadcast(); });
+		RecentPlayersScanHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UPNetworkingInstanceSteam::OnRecentPlayersScan), RECENT_PLAYERS_SCAN_INTERVAL);
+	}
+	else
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("InitializeNetworkingInstance: RecentPlayers not initialized!"));
+		RecentPlayers.Reset();
+	}
+
+	TArray<uint64> RichPresenceSeed;
+	if (FriendRoster.IsValid())
+	{
+		for (int32 Index = 0; Index < FriendRoster->Num(); Index++)
+		{
+			if (FriendRoster->GetEntries()[Index].bIsPlayingThisGame)
+			{
+				RichPresenceSeed.Add(FriendRoster->GetSteamID64(Index));
+			}
+		}
+	}
+
+	RichPresenceCache = MakeShared<FRichPresenceCache>();
+	if (RichPresenceCache->Initialize(RichPresenceSeed))
+	{
+		RichPresenceCache->OnChanged.AddWeakLambda(this, [this](const uint64 SteamID) { OnFriendRichPresenceChanged.Broadcast(static_cast<int32>(CSteamID(SteamID).GetAccountID())); });
+	}
+	else
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("InitializeNetworkingInstance: RichPresenceCache not initialized!"));
+		RichPresenceCache.Reset();
+	}
+
+	SessionOrchestrator = MakeShared<FSessionOrchestrator>();
+	if (SessionOrchestrator->Initialize())
+	{
+		SessionOrchestrator->OnOperationCompleted.AddWeakLambda(this, [this](const FSessionOperationResult& Result) { OnSessionOperationComplete.Broadcast(Result); });
+	}
+	else
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("InitializeNetworkingInstance: SessionOrchestrator not initialized!"));
+		SessionOrchestrator.Reset();
+	}
+
+	// Relay network is started with the module, unless SteamAPI was not available yet.
+	TSharedPtr<FRelayNetwork> RelayNetwork = FPNetworkingModule::GetRelayNetwork();
+	if (RelayNetwork.IsValid())
+	{
+		RelayNetwork->Start();
+		RelayNetworkStateChangedHandle = RelayNetwork->OnStateChanged.AddWeakLambda(this, [this](ERelayNetworkState State)
+			{
+				OnRelayNetworkStateChanged.Broadcast(State);
+			}
+		);
+	}
+
+	LobbyBrowser = MakeShared<FLobbyBrowser>();
+	if (!LobbyBrowser->Initialize())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("InitializeNetworkingInstance: LobbyBrowser not initialized!"));
+		LobbyBrowser.Reset();
+	}
+
+	SessionUserInviteAcceptedDelegateHandle = FPNetworkingModule::GetOnlineSessionPointer()->AddOnSessionUserInviteAcceptedDelegate_Handle(
+		FOnSessionUserInviteAcceptedDelegate::CreateUObject(this, &UPNetworkingInstanceSteam::OnInviteAccepted));
+
+	if (SessionUserInviteAcceptedDelegateHandle.IsValid())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("InitializeNetworkingInstance: AcceptInvite Callback Initialized!"));
+	}
+	else
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("InitializeNetworkingInstance: AcceptInvite Callback not initialized!"));
+		return false;
+	}
+
+	if (GEngine)
+	{
+		OnNetworkFailureDelegateHandle = GEngine->OnNetworkFailure().AddUObject(this, &UPNetworkingInstanceSteam::OnNetworkFailure);
+
+		if (OnNetworkFailureDelegateHandle.IsValid())
+		{
+			UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("InitializeNetworkingInstance: Network failure delegate registered!"));
+		}
+		else
+		{
+			UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("InitializeNetworkingInstance: Network failure delegate not registered!"));
+			return false;
+		}
+	}
+	else
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("InitializeNetworkingInstance: GEngine is invalid!"));
+		return false;
+	}
+
+	return true;
+}
+
+void UPNetworkingInstanceSteam::DeInitializeNetworkingInstance()
+{
+	ActiveFriendsAvatarResolvers.Empty();
+	FriendListSnapshot = nullptr;
+	FriendListView.Reset();
+	PrefetchedAvatars.Reset();
+	RichPresenceCache.Reset();
+	FriendNameIndex.Reset();
+
+	UserDirectory.Reset();
+	SessionOrchestrator.Reset();
+	LobbyBrowser.Reset();
+	QuickJoinSearch.Reset();
+	QuickJoinCallback.Unbind();
+
+	TSharedPtr<FRelayNetwork> RelayNetwork = FPNetworkingModule::GetRelayNetwork();
+	if (RelayNetwork.IsValid())
+	{
+		RelayNetwork->OnStateChanged.Remove(RelayNetworkStateChangedHandle);
+		RelayNetworkStateChangedHandle.Reset();
+	}
+
+	FTSTicker::GetCoreTicker().RemoveTicker(RecentPlayersScanHandle);
+	RecentPlayersScanHandle.Reset();
+	if (RecentPlayers.IsValid())
+	{
+		RecentPlayers->Save();
+		RecentPlayers.Reset();
 	}
 
-	if (FPNetworkingModule::GetOnlineSessionPointer()->GetNamedSession(FPNetworkingModule::GetSessionName()))
+	if (FriendRoster.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("OnNetworkFailure: Session existing, need to destroy it!"));
-		OnClientDestroySessionCompleteHandle = FPNetworkingModule::GetOnlineSessionPointer()->AddOnDestroySessionCompleteDelegate_Handle(
-			FOnDestroySessionCompleteDelegate::CreateUObject(this, &UPNetworkingInstanceSteam::OnClientDestroySessionComplete));
+		// Next run serves this roster before reading SteamAPI.
+		FriendRoster->Save([this](const uint64 SteamID)
+			{
+				uint32 AvatarHash = 0;
+				return AvatarDiskCache.IsValid() && AvatarDiskCache->FindHash(SteamID, AvatarHash) ? AvatarHash : 0;
+			}
+		);
+		FriendRoster.Reset();
+	}
 
-		if (FPNetworkingModule::GetOnlineSessionPointer()->DestroySession(FPNetworkingModule::GetSessionName()))
-		{
-			UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("OnNetworkFailure: DestroySession request true!"));
-			FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_DESTROYING);
-		}
+	FriendsGroupIndex.Reset();
+	ProgressiveAvatarProvider.Reset();
+	AvatarAtlas.Reset();
+	AvatarPipeline.Reset();
+	AvatarCache.Reset();
+	AvatarTexturePool.Reset();
 
-		return;
+	if (AvatarDiskCache.IsValid())
+	{
+		AvatarDiskCache->Save();
+		AvatarDiskCache.Reset();
 	}
 
-	FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_INVALID);
-}
-
-void UPNetworkingInstanceSteam::OnDestroySessionCompleteFromNewHostingUser(FName SessionName, bool bWasSuccessfull)
-{
 	IOnlineSessionPtr SessionInterface = FPNetworkingModule::GetOnlineSessionPointer();
 	if (!SessionInterface.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("OnDestroySessionCompleteFromNewHostingUser: SessionInterface is invalid!"));
-		FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_INVALID);
 		return;
 	}
 
-	if (OnDestroySessionCompleteFromNewHostingUserHandle.IsValid())
+	if (SessionUserInviteAcceptedDelegateHandle.IsValid())
 	{
-		SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(OnDestroySessionCompleteFromNewHostingUserHandle);
-		OnDestroySessionCompleteFromNewHostingUserHandle.Reset();
+		SessionInterface->ClearOnSessionUserInviteAcceptedDelegate_Handle(SessionUserInviteAcceptedDelegateHandle);
+		SessionUserInviteAcceptedDelegateHandle.Reset();
 	}
 
-	if (bWasSuccessfull)
+	if (QuickJoinFindSessionsDelegateHandle.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("OnDestroySessionCompleteFromNewHostingUser: Session destroyed! -> %s"), *SessionName.ToString());
-		FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_PENDING);
-		CreateSession();
+		SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(QuickJoinFindSessionsDelegateHandle);
+		QuickJoinFindSessionsDelegateHandle.Reset();
 	}
-	else
+
+	if (GEngine)
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("OnDestroySessionCompleteFromNewHostingUser: Session not destroyed!"));
-		FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_INVALID);
+		if (OnNetworkFailureDelegateHandle.IsValid())
+		{
+			GEngine->OnNetworkFailure().Remove(OnNetworkFailureDelegateHandle);
+			OnNetworkFailureDelegateHandle.Reset();
+		}
 	}
 }
 
-void UPNetworkingInstanceSteam::OnClientDestroySessionComplete(FName SessionName, bool bWasSuccessfull)
+#pragma endregion PrivateUtilityFunctions
+
+#pragma region CallbackFunctions
+
+void UPNetworkingInstanceSteam::OnInviteAccepted(bool bWasSuccessful, int32 LocalUserNum, FUniqueNetIdPtr FriendID, const FOnlineSessionSearchResult& InviteResult)
 {
-	IOnlineSessionPtr OnlineSession = FPNetworkingModule::GetOnlineSessionPointer();
-	if (!OnlineSession.IsValid())
+	if (!bWasSuccessful)
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("OnClientDestroySessionComplete: OnlineSession is null!"));
-		FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_INVALID);
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("OnInviteAccepted: Invite Acception Error!"));
 		return;
 	}
 
-	if (OnClientDestroySessionCompleteHandle.IsValid())
+	if (!SessionOrchestrator.IsValid())
 	{
-		OnlineSession->ClearOnDestroySessionCompleteDelegate_Handle(OnClientDestroySessionCompleteHandle);
-		OnClientDestroySessionCompleteHandle.Reset();
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("OnInviteAccepted: SessionOrchestrator not valid!"));
+		return;
 	}
 
-	if (bWasSuccessfull)
-	{
-		FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_INVALID);
-		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("OnClientDestroySessionComplete: Session %s destroyed"), *SessionName.ToString());
-	}
+	// Queued behind running requests (e.g. a quit): old session, if existing, is destroyed before joining.
+	UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("OnInviteAccepted: Joining session of %s"), *InviteResult.Session.OwningUserName);
+	SessionOrchestrator->Join(InviteResult);
 }
 
-void UPNetworkingInstanceSteam::OnClientNewInviteAcceptionDestroySessionComplete(FName SessionName, bool bWasSuccessfull)
+void UPNetworkingInstanceSteam::OnQuickJoinSearchComplete(bool bWasSuccessful)
 {
-	IOnlineSessionPtr SessionInterface = FPNetworkingModule::GetOnlineSessionPointer();
-	if (!SessionInterface.IsValid())
+	if (!QuickJoinSearch.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("OnClientNewInviteAcceptionDestroySessionComplete: SessionInterface is invalid!"));
-		FPNetworkingModule::SetLocalSessionCurrentState(TempPrevSessionState);
 		return;
 	}
 
-	if (OnClientNewInviteAcceptionDestroySessionCompleteHandle.IsValid())
+	IOnlineSessionPtr SessionInterface = FPNetworkingModule::GetOnlineSessionPointer();
+	if (SessionInterface.IsValid())
 	{
-		SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(OnClientNewInviteAcceptionDestroySessionCompleteHandle);
-		OnClientNewInviteAcceptionDestroySessionCompleteHandle.Reset();
+		SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(QuickJoinFindSessionsDelegateHandle);
 	}
 
-	if (bWasSuccessfull)
+	// Reset before joining, so Callback can start a new quick join.
+	const TSharedPtr<FOnlineSessionSearch> Search = MoveTemp(QuickJoinSearch);
+	const FOnQuickJoinComplete Callback = QuickJoinCallback;
+	QuickJoinCallback.Unbind();
+
+	if (!bWasSuccessful || !SessionOrchestrator.IsValid())
 	{
-		FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_PENDING);
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("OnQuickJoinSearchComplete: Search failed!"));
+		Callback.ExecuteIfBound(false, PING_LOCATION_UNKNOWN);
+		return;
+	}
 
-		JoinSessionCompleteDelegateHandle = SessionInterface->AddOnJoinSessionCompleteDelegate_Handle(
-			FOnJoinSessionCompleteDelegate::CreateUObject(this, &UPNetworkingInstanceSteam::OnJoinSessionComplete));
+	TArray<TPair<int32, int32>> Ranking;
+	FPingLocation::RankSessions(Search->SearchResults, QuickJoinMaxPingMs, Ranking);
 
-		const bool bHasJoined = FPNetworkingModule::GetOnlineSessionPointer()->JoinSession(0, FPNetworkingModule::GetSessionName(), LastInviteResult);
-		if (bHasJoined)
-		{
-			UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("OnClientNewInviteAcceptionDestroySessionComplete: Invite Acception Success by %s"), *LastInviteResult.Session.OwningUserName);
-		}
-		else
+	if (Ranking.Num() == 0)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("OnQuickJoinSearchComplete: No joinable session within %d ms among %d found!"), QuickJoinMaxPingMs, Search->SearchResults.Num());
+		Callback.ExecuteIfBound(false, PING_LOCATION_UNKNOWN);
+		return;
+	}
+
+	const FOnlineSessionSearchResult& ClosestResult = Search->SearchResults[Ranking[0].Key];
+	const int32 PingMs = Ranking[0].Value;
+	UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("OnQuickJoinSearchComplete: Joining session of %s, estimated ping %d ms (%d candidates)"), *ClosestResult.Session.OwningUserName, PingMs, Ranking.Num());
+
+	const int32 OperationID = SessionOrchestrator->Join(ClosestResult, FOnSessionOperationDone::CreateWeakLambda(this, [Callback, PingMs](const FSessionOperationResult& Result)
 		{
-			UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("OnClientNewInviteAcceptionDestroySessionComplete: Invite Acception Error!"));
-			FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_INVALID);
+			Callback.ExecuteIfBound(Result.bWasSuccessful, PingMs);
 		}
-	}
-	else
+	));
+
+	if (OperationID == 0)
 	{
-		FPNetworkingModule::SetLocalSessionCurrentState(TempPrevSessionState);
+		Callback.ExecuteIfBound(false, PingMs);
 	}
 }
 
-#pragma endregion CallbackFunctions
-
-#pragma region SteamworksFunctions
-
-UTexture2D* UPNetworkingInstanceSteam::GetAvatar(const CSteamID SteamID, int32& QueryResult)
+bool UPNetworkingInstanceSteam::OnRecentPlayersScan(float DeltaTime)
 {
-	int32 AvatarID = SteamFriends()->GetLargeFriendAvatar(SteamID);
-
-	if (AvatarID == 0)
+	if (!RecentPlayers.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("GetAvatar: ERROR: Invalid Avatar ID!"));
-		QueryResult = 0;
-		return nullptr;
+		return true;
 	}
 
-	if (AvatarID == -1)
+	if (FPNetworkingModule::GetLocalSessionCurrentState() != ELocalSessionState::SESSION_VALID)
 	{
-		QueryResult = -1;
-		return nullptr;
+		RecentPlayers->EndSession();
+		return true;
 	}
 
-	// Avatar size.
-	uint32 Width, Height;
-	if (!SteamUtils()->GetImageSize(AvatarID, &Width, &Height))
+	UWorld* World = GEngine && GEngine->GetWorldContexts().Num() > 0 ? GEngine->GetWorldContexts()[0].World() : nullptr;
+	AGameStateBase* GameState = World ? World->GetGameState() : nullptr;
+	ISteamUser* SteamUserInterface = SteamUser();
+	if (!GameState || !SteamUserInterface)
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("GetAvatar: ERROR: GetImageSize()"));
-		return nullptr;
+		return true;
 	}
 
-	// Avatar RGBA datas.
-	TArray<uint8> AvatarData;
-	const uint32 BufferSize = Width * Height * 4;
-	AvatarData.Reserve(BufferSize);
-	if (!SteamUtils()->GetImageRGBA(AvatarID, AvatarData.GetData(), BufferSize))
+	const uint64 LocalSteamID = SteamUserInterface->GetSteamID().ConvertToUint64();
+	bool bHasRecorded = false;
+
+	// PlayerArray is replicated: same players on host and clients.
+	for (const APlayerState* PlayerState : GameState->PlayerArray)
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("GetAvatar: ERROR: GetImageRGBA()"));
-		return nullptr;
+		if (!PlayerState)
+		{
+			continue;
+		}
+
+		const FUniqueNetIdRepl& UniqueNetID = PlayerState->GetUniqueId();
+		if (!UniqueNetID.IsValid() || UniqueNetID.GetType() != STEAM_SUBSYSTEM)
+		{
+			continue;
+		}
+
+		const uint64 PlayerSteamID = FCString::Strtoui64(*UniqueNetID->ToString(), nullptr, 10);
+		if (PlayerSteamID != 0 && PlayerSteamID != LocalSteamID && RecentPlayers->Record(PlayerSteamID))
+		{
+			// Avatar downloaded now, so it is ready when a re-invite screen asks for it.
+			if (ProgressiveAvatarProvider.IsValid())
+			{
+				ProgressiveAvatarProvider->Acquire(CSteamID(PlayerSteamID), EAvatarSize::AVATAR_MEDIUM);
+			}
+			bHasRecorded = true;
+		}
 	}
 
-	// Apply RGBA datas into texture.
-	UTexture2D* AvatarTexture = UTexture2D::CreateTransient(Width, Height, EPixelFormat::PF_R8G8B8A8);
-	if (!AvatarTexture)
+	if (bHasRecorded)
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("GetAvatar: ERROR: Invalid Avatar Texture!"));
-		return nullptr;
+		RecentPlayers->Save();
 	}
 
-	void* TextureData = AvatarTexture->GetPlatformData()->Mips[0].BulkData.Lock(LOCK_READ_WRITE);
-	FMemory::Memcpy(TextureData, AvatarData.GetData(), BufferSize);
-	AvatarTexture->GetPlatformData()->Mips[0].BulkData.Unlock();
+	return true;
+}
 
-	AvatarTexture->UpdateResource();
+void UPNetworkingInstanceSteam::OnNetworkFailure(UWorld* World, UNetDriver* NetDriver, ENetworkFailure::Type FailureType, const FString& ErrorString)
+{
+	UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("OnNetworkFailure: Error -> %s"), *ErrorString);
+	if (!SessionOrchestrator.IsValid())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("OnNetworkFailure: SessionOrchestrator not valid!"));
+		FPNetworkingModule::SetLocalSessionCurrentState(ELocalSessionState::SESSION_INVALID);
+		return;
+	}
 
-	QueryResult = 1;
-	return AvatarTexture;
+	// Local session datas, if existing, are unregistered once running requests are completed.
+	SessionOrchestrator->Destroy();
 }
 
-int32 UPNetworkingInstanceSteam::GetLocalUserAvatarRecursive(TSharedPtr<FOnLocalAvatarReady> Callback)
-{
-	int32 QueryResult = 0;
+#pragma endregion CallbackFunctions
+
+#pragma region SteamworksFunctions
 
+int32 UPNetworkingInstanceSteam::GetLocalUserAvatarRecursive(const EAvatarSize AvatarSize, TSharedPtr<FOnLocalAvatarReady> Callback)
+{
 	ISteamUser* SteamUserInterface = SteamUser();
 	if(!SteamUserInterface)
 	{
@@ -1084,320 +1827,261 @@ int32 UPNetworkingInstanceSteam::GetLocalUserAvatarRecursive(TSharedPtr<FOnLocal
 		return 0;
 	}
 
-	UTexture2D* AvatarBuffer = GetAvatar(SteamID, QueryResult);
-
-	if (AvatarBuffer != nullptr && QueryResult == 1)
+	if (!FPNetworkingModule::GetSteamAPIManager().IsValid() || !AvatarPipeline.IsValid())
 	{
-		if (FPNetworkingModule::GetSteamAPIManager().IsValid())
-		{
-			FPNetworkingModule::GetSteamAPIManager()->OnAvatarReadyDelegateLocalUser.Unbind();
-		}
-		else
-		{
-			return 0;
-		}
+		return 0;
+	}
 
-		if (AvatarBuffer && Callback.IsValid())
-		{
-			Callback->ExecuteIfBound(AvatarBuffer);
-		}
-		else
-		{
-			return 0;
-		}
+	const int32 AvatarHandle = FAvatarPipeline::GetAvatarHandle(SteamID, AvatarSize);
+
+	// Avatar of a previous session, shown while SteamAPI downloads the live one.
+	if (AvatarHandle == -1 && Callback.IsValid() && AvatarPipeline->RequestPersistedTexture(SteamID, AvatarSize, FOnAvatarPipelineComplete::CreateLambda([Callback](UTexture2D* AvatarTexture) { Callback->ExecuteIfBound(AvatarTexture); })))
+	{
+		return 1;
 	}
-	else if (AvatarBuffer == nullptr && QueryResult == -1)
+
+	if (AvatarHandle == -1)
 	{
-		if (FPNetworkingModule::GetSteamAPIManager().IsValid())
-		{
-			FPNetworkingModule::GetSteamAPIManager()->OnAvatarReadyDelegateLocalUser.Unbind();
-			FPNetworkingModule::GetSteamAPIManager()->OnAvatarReadyDelegateLocalUser.BindLambda([Callback](AvatarImageLoaded_t* pCallback)
+		FPNetworkingModule::GetSteamAPIManager()->AddAvatarWaiter(SteamID, FOnAvatarReadyFromSteamAPI::CreateLambda([AvatarSize, Callback](AvatarImageLoaded_t* pCallback)
+			{
+				if (pCallback)
 				{
-					if (pCallback)
-					{
-						AsyncTask(ENamedThreads::GameThread, [Callback]()
+					AsyncTask(ENamedThreads::GameThread, [AvatarSize, Callback]()
+						{
+							UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("GetLocalUserAvatarRecursive: Callback AvatarImageLoaded ready from SteamAPI!"));
+
+							// Caller already got -1: it must be told that no avatar is coming.
+							UPNetworkingInstanceSteam* Instance = UPNetworkingInstanceSteam::GetUniqueInstance();
+							if ((!Instance || Instance->GetLocalUserAvatarRecursive(AvatarSize, Callback) == 0) && Callback.IsValid())
 							{
-								UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("GetLocalUserAvatarRecursive: Callback AvatarImageLoaded ready from SteamAPI!"));
-								UPNetworkingInstanceSteam::GetUniqueInstance()->GetLocalUserAvatarRecursive(Callback);
+								Callback->ExecuteIfBound(nullptr);
 							}
-						);
-					}
+						}
+					);
 				}
-			);
-		}
-		else
-		{
-			return 0;
-		}
+			}
+		));
 
 		return -1;
 	}
-	else
+
+	if (AvatarHandle == 0 || !Callback.IsValid())
 	{
 		return 0;
 	}
 
-	return 1;
+	// Caller may already have -1: it is told about failures too, with a null texture.
+	const bool bReady = AvatarPipeline->RequestTexture(SteamID, AvatarHandle, AvatarSize, FOnAvatarPipelineComplete::CreateLambda([Callback](UTexture2D* AvatarTexture)
+		{
+			Callback->ExecuteIfBound(AvatarTexture);
+		}
+	));
+
+	return bReady ? 1 : -1;
 }
 
-int32 UPNetworkingInstanceSteam::GetRequestedFriendAvatarRecursive(const CSteamID SteamID, TSharedPtr<FOnRequestedFriendAvatarReady> Callback)
+int32 UPNetworkingInstanceSteam::GetRequestedFriendAvatarRecursive(const CSteamID SteamID, const EAvatarSize AvatarSize, TSharedPtr<FOnRequestedFriendAvatarReady> Callback)
 {
-	int32 QueryResult = 0;
-	
-	UTexture2D* RequestedFriendAvatar;
-	RequestedFriendAvatar = GetAvatar(SteamID, QueryResult);
-
-	if (RequestedFriendAvatar != nullptr && QueryResult == 1)
+	if (!FPNetworkingModule::GetSteamAPIManager().IsValid() || !AvatarPipeline.IsValid())
 	{
-		if (FPNetworkingModule::GetSteamAPIManager().IsValid())
-		{
-			FPNetworkingModule::GetSteamAPIManager()->OnAvatarReadyFriendRequested.Unbind();
-		}
-		else
-		{
-			return 0;
-		}
+		return 0;
+	}
 
-		if (RequestedFriendAvatar && Callback.IsValid())
-		{
-			Callback->ExecuteIfBound(RequestedFriendAvatar);
-		}
-		else
-		{
-			return 0;
-		}
+	const int32 AvatarHandle = FAvatarPipeline::GetAvatarHandle(SteamID, AvatarSize);
+
+	// Avatar of a previous session, shown while SteamAPI downloads the live one.
+	if (AvatarHandle == -1 && Callback.IsValid() && AvatarPipeline->RequestPersistedTexture(SteamID, AvatarSize, FOnAvatarPipelineComplete::CreateLambda([Callback](UTexture2D* AvatarTexture) { Callback->ExecuteIfBound(AvatarTexture); })))
+	{
+		return 1;
 	}
-	else if (RequestedFriendAvatar == nullptr && QueryResult == -1)
+
+	if (AvatarHandle == -1)
 	{
-		if (FPNetworkingModule::GetSteamAPIManager().IsValid())
-		{
-			FPNetworkingModule::GetSteamAPIManager()->OnAvatarReadyFriendRequested.Unbind();
-			FPNetworkingModule::GetSteamAPIManager()->OnAvatarReadyFriendRequested.BindLambda([SteamID, Callback](AvatarImageLoaded_t* pCallback)
+		FPNetworkingModule::GetSteamAPIManager()->AddAvatarWaiter(SteamID, FOnAvatarReadyFromSteamAPI::CreateLambda([SteamID, AvatarSize, Callback](AvatarImageLoaded_t* pCallback)
+			{
+				if (pCallback)
 				{
-					if (pCallback)
-					{
-						AsyncTask(ENamedThreads::GameThread, [SteamID, Callback]()
+					AsyncTask(ENamedThreads::GameThread, [SteamID, AvatarSize, Callback]()
+						{
+							UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("GetRequestedFriendAvatarRecursive: Callback AvatarImageLoaded ready from SteamAPI!"));
+
+							// Caller already got -1: it must be told that no avatar is coming.
+							UPNetworkingInstanceSteam* Instance = UPNetworkingInstanceSteam::GetUniqueInstance();
+							if ((!Instance || Instance->GetRequestedFriendAvatarRecursive(SteamID, AvatarSize, Callback) == 0) && Callback.IsValid())
 							{
-								UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("GetRequestedFriendAvatarRecursive: Callback AvatarImageLoaded ready from SteamAPI!"));
-								UPNetworkingInstanceSteam::GetUniqueInstance()->GetRequestedFriendAvatarRecursive(SteamID, Callback);
+								Callback->ExecuteIfBound(nullptr);
 							}
-						);
-					}
+						}
+					);
 				}
-			);
-		}
-		else
-		{
-			return 0;
-		}
+			}
+		));
 
 		return -1;
 	}
-	else
+
+	if (AvatarHandle == 0 || !Callback.IsValid())
 	{
 		return 0;
 	}
 
-	return 1;
+	// Caller may already have -1: it is told about failures too, with a null texture.
+	const bool bReady = AvatarPipeline->RequestTexture(SteamID, AvatarHandle, AvatarSize, FOnAvatarPipelineComplete::CreateLambda([Callback](UTexture2D* AvatarTexture)
+		{
+			Callback->ExecuteIfBound(AvatarTexture);
+		}
+	));
+
+	return bReady ? 1 : -1;
 }
 
-int32 UPNetworkingInstanceSteam::GetFriendsAvatarRecursive(TSharedPtr<FOnFriendsAvatarReady> Callback)
+int32 UPNetworkingInstanceSteam::ResolveFriendsAvatar(const float TimeoutSeconds, const EAvatarSize AvatarSize, TSharedPtr<FOnFriendsAvatarReady> Callback)
 {
-	bool bPendingFlag = false;
-	int32 QueryResult = 0;
-
-	ISteamFriends* SteamFriendsInterface = SteamFriends();
-	if (!SteamFriendsInterface)
+	if (!FPNetworkingModule::GetSteamAPIManager().IsValid() || !AvatarPipeline.IsValid() || !FriendRoster.IsValid() || !Callback.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("GetFriendsAvatarRecursive: SteamUserInterface steamwork_sdk not valid!"));
 		return 0;
 	}
 
-	int32 FriendsCount = SteamFriendsInterface->GetFriendCount(k_EFriendFlagImmediate);
-	if (FriendsCount < 0)
+	const int32 FriendsCount = FriendRoster->Num();
+	if (FriendsCount <= 0)
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("GetFriendsAvatarRecursive: ERROR: GetFriendsCount()"));
-		FriendsCount = 0;
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("ResolveFriendsAvatar: ERROR: Empty friend roster"));
 		return 0;
 	}
 
-	TArray<UTexture2D*> FriendsAvatar;
+	TArray<CSteamID> FriendsID;
+	FriendsID.Reserve(FriendsCount);
 	for (int32 Index = 0; Index < FriendsCount; Index++)
 	{
-		const CSteamID CurrentSteamID = SteamFriendsInterface->GetFriendByIndex(Index, k_EFriendFlagImmediate);
-		UTexture2D* AvatarBuffer = GetAvatar(CurrentSteamID, QueryResult);
-
-		if (AvatarBuffer != nullptr && QueryResult == 1)
-		{
-			FriendsAvatar.Add(AvatarBuffer);
-		}
-		else if (AvatarBuffer == nullptr && QueryResult == -1)
-		{
-			bPendingFlag = true;
-			break;
-		}
-		else
-		{
-			return 0;
-		}
+		FriendsID.Add(CSteamID(FriendRoster->GetSteamID64(Index)));
 	}
 
-	if (!bPendingFlag)
-	{
-		if (FPNetworkingModule::GetSteamAPIManager().IsValid())
-		{
-			FPNetworkingModule::GetSteamAPIManager()->OnAvatarReadyDelegateFriendList.Unbind();
-		}
-		else
-		{
-			return 0;
-		}
-
-		if (FriendsAvatar.Num() > 0 && Callback.IsValid())
-		{
-			Callback->ExecuteIfBound(FriendsAvatar);
-		}
-		else
+	TSharedRef<FFriendsAvatarResolver> Resolver = MakeShared<FFriendsAvatarResolver>(AvatarPipeline, FriendsID, AvatarSize, FOnFriendsAvatarResolved::CreateLambda([Callback](const TArray<UTexture2D*>& Textures)
 		{
-			return 0;
-		}
-	}
-	else
-	{
-		if (FPNetworkingModule::GetSteamAPIManager().IsValid())
-		{
-			FPNetworkingModule::GetSteamAPIManager()->OnAvatarReadyDelegateFriendList.Unbind();
-			FPNetworkingModule::GetSteamAPIManager()->OnAvatarReadyDelegateFriendList.BindLambda([Callback](AvatarImageLoaded_t* pCallback)
+			TArray<UTexture2D*> FriendsAvatar;
+			FriendsAvatar.Reserve(Textures.Num());
+			for (UTexture2D* Texture : Textures)
+			{
+				if (Texture)
 				{
-					if (pCallback)
-					{
-						AsyncTask(ENamedThreads::GameThread, [Callback]()
-							{
-								UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("GetFriendsAvatarRecursive: Callback AvatarImageLoaded ready from SteamAPI!"));
-								UPNetworkingInstanceSteam::GetUniqueInstance()->GetFriendsAvatarRecursive(Callback);
-							}
-						);
-					}
+					FriendsAvatar.Add(Texture);
 				}
-			);
-		}
-		else
-		{
-			return 0;
-		}
+			}
 
-		return -1;
-	}
+			// Fired even if empty (timeout, no avatar resolvable): caller may be waiting after -1.
+			Callback->ExecuteIfBound(FriendsAvatar);
+		}
+	));
 
-	return 1;
+	return StartFriendsAvatarResolver(Resolver, TimeoutSeconds);
 }
 
-int32 UPNetworkingInstanceSteam::GetPlayerDataRecursive(const bool bAlphabeticalSort, TSharedPtr<FOnFriendsDataReady> Callback)
+int32 UPNetworkingInstanceSteam::ResolvePlayersData(const bool bAlphabeticalSort, const float TimeoutSeconds, const EAvatarSize AvatarSize, TSharedPtr<FOnFriendsDataReady> Callback)
 {
-	TArray<FUserSteamData> UserSteamData;
-	bool bPendingFlag = false;
-	int32 QueryResult = 0;
-
-	ISteamFriends* SteamFriendsInterface = SteamFriends();
-	if (!SteamFriendsInterface)
+	if (!FPNetworkingModule::GetSteamAPIManager().IsValid() || !AvatarPipeline.IsValid() || !FriendRoster.IsValid() || !Callback.IsValid())
 	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("GetPlayerDataRecursive: SteamUserInterface steamworks_sdk not valid!"));
 		return 0;
 	}
 
-	int32 FriendsCount = SteamFriendsInterface->GetFriendCount(k_EFriendFlagImmediate);
-	if (FriendsCount < 0)
-	{
-		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("GetPlayerDataRecursive: ERROR: GetFriendsCount()"));
-		FriendsCount = 0;
-		return 0;
-	}
+	// Names and states come from the resident roster: no SteamAPI friendlist iteration.
+	const TArray<FFriendRosterEntry>& Friends = FriendRoster->GetEntries();
 
-	// Just online friends (better: not offline).
-	UserSteamData.Reserve(GetOnlineFriendsFromFriendCount(FriendsCount));
+	TArray<FUserSteamData> UserSteamData;
+	TArray<CSteamID> FriendsID;
+	UserSteamData.Reserve(FriendRoster->NumOnline());
+	FriendsID.Reserve(FriendRoster->NumOnline());
 
-	for (int32 Index = 0; Index < FriendsCount; Index++)
+	for (int32 Index = 0; Index < Friends.Num(); Index++)
 	{
-		const CSteamID CurrentSteamID = SteamFriendsInterface->GetFriendByIndex(Index, k_EFriendFlagImmediate);
-		const EPersonaState CurrentPlayerState = SteamFriendsInterface->GetFriendPersonaState(CurrentSteamID);
-
 		// Just online friends (better: not offline).
-		if (CurrentPlayerState != EPersonaState::k_EPersonaStateOffline)
+		if (Friends[Index].IsOnline())
 		{
-			const FString CurrentNickname(SteamFriendsInterface->GetFriendPersonaName(CurrentSteamID));
-			UTexture2D* CurrentTexture = GetAvatar(CurrentSteamID, QueryResult);
+			UserSteamData.Add(FUserSteamData(Friends[Index].SteamID, Friends[Index].UserName, nullptr));
+			FriendsID.Add(CSteamID(FriendRoster->GetSteamID64(Index)));
+		}
+	}
 
-			if (CurrentTexture != nullptr && QueryResult == 1)
-			{
-				UserSteamData.Add(FUserSteamData(static_cast<int32>(CurrentSteamID.GetAccountID()), FText::FromString(CurrentNickname), CurrentTexture));
-			}
-			else if (CurrentTexture == nullptr && QueryResult == -1)
+	if (UserSteamData.Num() == 0)
+	{
+		return 0;
+	}
+
+	// Names are ready, avatars are filled in as they are resolved.
+	TSharedRef<FFriendsAvatarResolver> Resolver = MakeShared<FFriendsAvatarResolver>(AvatarPipeline, FriendsID, AvatarSize, FOnFriendsAvatarResolved::CreateLambda([this, bAlphabeticalSort, Callback, UserSteamData = MoveTemp(UserSteamData)](const TArray<UTexture2D*>& Textures) mutable
+		{
+			for (int32 Index = 0; Index < UserSteamData.Num(); Index++)
 			{
-				bPendingFlag = true;
-				break;
+				UserSteamData[Index].UserAvatar = Textures[Index];
 			}
-			else
+
+			if (bAlphabeticalSort)
 			{
-				return 0;
+				AlphabeticalSortFriends(UserSteamData);
 			}
+
+			Callback->ExecuteIfBound(UserSteamData);
 		}
-	}
+	));
+
+	return StartFriendsAvatarResolver(Resolver, TimeoutSeconds);
+}
 
-	if (bAlphabeticalSort && UserSteamData.Num() > 0)
+int32 UPNetworkingInstanceSteam::ResolveFriendsAvatarAtlas(const float TimeoutSeconds, const EAvatarSize AvatarSize, TSharedPtr<FOnFriendsAvatarAtlasReady> Callback)
+{
+	if (!FPNetworkingModule::GetSteamAPIManager().IsValid() || !AvatarPipeline.IsValid() || !AvatarAtlas.IsValid() || !FriendRoster.IsValid() || !Callback.IsValid())
 	{
-		AlphabeticalSortFriends(UserSteamData);
+		return 0;
 	}
 
-	if (!bPendingFlag)
+	const int32 FriendsCount = FriendRoster->Num();
+	if (FriendsCount <= 0)
 	{
-		if (FPNetworkingModule::GetSteamAPIManager().IsValid())
-		{
-			FPNetworkingModule::GetSteamAPIManager()->OnAvatarReadyFriendListData.Unbind();
-		}
-		else
-		{
-			return 0;
-		}
-
-		if (UserSteamData.Num() > 0 && Callback.IsValid())
-		{
-			Callback->ExecuteIfBound(UserSteamData);
-		}
-		else
-		{
-			return 0;
-		}
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("ResolveFriendsAvatarAtlas: ERROR: Empty friend roster"));
+		return 0;
 	}
-	else
+
+	TArray<CSteamID> FriendsID;
+	FriendsID.Reserve(FriendsCount);
+	for (int32 Index = 0; Index < FriendsCount; Index++)
 	{
-		if (FPNetworkingModule::GetSteamAPIManager().IsValid())
+		FriendsID.Add(CSteamID(FriendRoster->GetSteamID64(Index)));
+	}
+
+	TSharedRef<FFriendsAvatarResolver> Resolver = MakeShared<FFriendsAvatarResolver>(AvatarPipeline, AvatarAtlas, FriendsID, AvatarSize, FOnFriendsAvatarAtlasResolved::CreateLambda([Callback](const TArray<FAvatarAtlasSlot>& Slots)
 		{
-			FPNetworkingModule::GetSteamAPIManager()->OnAvatarReadyFriendListData.Unbind();
-			FPNetworkingModule::GetSteamAPIManager()->OnAvatarReadyFriendListData.BindLambda([bAlphabeticalSort, Callback](AvatarImageLoaded_t* pCallback)
+			TArray<FAvatarAtlasSlot> FriendsSlots;
+			FriendsSlots.Reserve(Slots.Num());
+			for (const FAvatarAtlasSlot& Slot : Slots)
+			{
+				if (Slot.AtlasPage)
 				{
-					if (pCallback)
-					{
-						AsyncTask(ENamedThreads::GameThread, [bAlphabeticalSort, Callback]()
-							{
-								UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("GetPlayerDataRecursive: Callback AvatarImageLoaded ready from SteamAPI!"));
-								//GEngine->AddOnScreenDebugMessage(-1, 1.5f, FColor::Emerald, TEXT("RE-Query GetAvatar"));
-
-								UPNetworkingInstanceSteam::GetUniqueInstance()->GetPlayerDataRecursive(bAlphabeticalSort, Callback);
-							}
-						);
-					}
+					FriendsSlots.Add(Slot);
 				}
-			);
-		}
-		else
-		{
-			return 0;
+			}
+
+			// Fired even if empty (timeout, no avatar resolvable): caller may be waiting after -1.
+			Callback->ExecuteIfBound(FriendsSlots);
 		}
+	));
 
-		return -1;
+	return StartFriendsAvatarResolver(Resolver, TimeoutSeconds);
+}
+
+int32 UPNetworkingInstanceSteam::StartFriendsAvatarResolver(TSharedRef<FFriendsAvatarResolver> Resolver, const float TimeoutSeconds)
+{
+	// Resolvers completed since last call are not needed anymore, neither their waiters.
+	ActiveFriendsAvatarResolvers.RemoveAll([](const TSharedRef<FFriendsAvatarResolver>& ActiveResolver) { return ActiveResolver->IsComplete(); });
+	FPNetworkingModule::GetSteamAPIManager()->PruneAvatarWaiters();
+
+	if (Resolver->Start(TimeoutSeconds))
+	{
+		return 1;
 	}
 
-	return 1; 
+	// Kept alive until complete: it wakes up only for the avatars named by SteamAPI.
+	ActiveFriendsAvatarResolvers.Add(Resolver);
+
+	return -1;
 }
 
-#pragma endregion SteamworksFunctions
\ No newline at end of file
+#pragma endregion SteamworksFunctions
@@ -0,0 +1,120 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#include "PingLocation.h"
+#include "PNetworking.h"
+#include "OnlineSessionSettings.h"
+#include "Algo/StableSort.h"
+
+bool FPingLocation::GetLocalLocationString(FString& OutLocation)
+{
+	OutLocation.Reset();
+
+	ISteamNetworkingUtils* SteamNetworkingUtilsInterface = SteamNetworkingUtils();
+	if (!SteamNetworkingUtilsInterface)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FPingLocation: SteamNetworkingUtilsInterface steamworks_sdk not valid!"));
+		return false;
+	}
+
+	// Negative age means relay network data is not ready yet: start (or keep) measuring it.
+	SteamNetworkPingLocation_t LocalLocation;
+	if (SteamNetworkingUtilsInterface->GetLocalPingLocation(LocalLocation) < 0.0f)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FPingLocation: Local ping location not available yet!"));
+		SteamNetworkingUtilsInterface->InitRelayNetworkAccess();
+		return false;
+	}
+
+	char Buffer[k_cchMaxSteamNetworkingPingLocationString];
+	SteamNetworkingUtilsInterface->ConvertPingLocationToString(LocalLocation, Buffer, sizeof(Buffer));
+	OutLocation = UTF8_TO_TCHAR(Buffer);
+	return !OutLocation.IsEmpty();
+}
+
+int32 FPingLocation::EstimatePingMs(const FString& Location)
+{
+	ISteamNetworkingUtils* SteamNetworkingUtilsInterface = SteamNetworkingUtils();
+	if (!SteamNetworkingUtilsInterface || Location.IsEmpty())
+	{
+		return PING_LOCATION_UNKNOWN;
+	}
+
+	SteamNetworkPingLocation_t RemoteLocation;
+	if (!SteamNetworkingUtilsInterface->ParsePingLocationString(TCHAR_TO_UTF8(*Location), RemoteLocation))
+	{
+		return PING_LOCATION_UNKNOWN;
+	}
+
+	// Failed (no common relay) and Unknown (local data not ready) are both reported as unknown.
+	const int32 PingMs = SteamNetworkingUtilsInterface->EstimatePingTimeFromLocalHost(RemoteLocation);
+	return PingMs >= 0 ? PingMs : PING_LOCATION_UNKNOWN;
+}
+
+int32 FPingLocation::EstimateLobbyPingMs(const uint64 LobbyID)
+{
+	ISteamMatchmaking* SteamMatchmakingInterface = SteamMatchmaking();
+	if (!SteamMatchmakingInterface || LobbyID == 0)
+	{
+		return PING_LOCATION_UNKNOWN;
+	}
+
+	// Lobby data of searched lobbies is already local: no request sent.
+	const char* Location = SteamMatchmakingInterface->GetLobbyData(CSteamID(LobbyID), SESSION_PING_LOCATION_KEY);
+	return EstimatePingMs(UTF8_TO_TCHAR(Location));
+}
+
+int32 FPingLocation::EstimateSessionPingMs(const FOnlineSessionSearchResult& SearchResult)
+{
+	FString Location;
+	if (SearchResult.Session.SessionSettings.Get(FName(TEXT(SESSION_PING_LOCATION_KEY)), Location))
+	{
+		return EstimatePingMs(Location);
+	}
+
+	// Steam OSS sessions are lobbies: read lobby data directly if the setting was not parsed back.
+	return EstimateLobbyPingMs(FCString::Strtoui64(*SearchResult.GetSessionIdStr(), nullptr, 10));
+}
+
+bool FPingLocation::IsWithinMaxPing(const int32 PingMs, const int32 MaxPingMs)
+{
+	return MaxPingMs <= 0 || PingMs == PING_LOCATION_UNKNOWN || PingMs <= MaxPingMs;
+}
+
+bool FPingLocation::IsCloser(const int32 PingMs, const int32 OtherPingMs)
+{
+	if (PingMs == PING_LOCATION_UNKNOWN || OtherPingMs == PING_LOCATION_UNKNOWN)
+	{
+		return OtherPingMs == PING_LOCATION_UNKNOWN && PingMs != PING_LOCATION_UNKNOWN;
+	}
+
+	return PingMs < OtherPingMs;
+}
+
+void FPingLocation::RankSessions(const TArray<FOnlineSessionSearchResult>& SearchResults, const int32 MaxPingMs, TArray<TPair<int32, int32>>& OutRanking)
+{
+	OutRanking.Reset(SearchResults.Num());
+
+	for (int32 Index = 0; Index < SearchResults.Num(); Index++)
+	{
+		const FOnlineSessionSearchResult& SearchResult = SearchResults[Index];
+		if (!SearchResult.IsValid() || SearchResult.Session.NumOpenPublicConnections <= 0)
+		{
+			continue;
+		}
+
+		const int32 PingMs = EstimateSessionPingMs(SearchResult);
+		if (IsWithinMaxPing(PingMs, MaxPingMs))
+		{
+			OutRanking.Add(TPair<int32, int32>(Index, PingMs));
+		}
+	}
+
+	// Stable: hosts at the same ping keep search order.
+	Algo::StableSort(OutRanking, [](const TPair<int32, int32>& A, const TPair<int32, int32>& B)
+		{
+			return IsCloser(A.Value, B.Value);
+		}
+	);
+}
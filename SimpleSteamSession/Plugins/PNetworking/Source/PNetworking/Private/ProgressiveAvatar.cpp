@@ -0,0 +1,250 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#include "ProgressiveAvatar.h"
+#include "AvatarPipeline.h"
+#include "PNetworking.h"
+#include "Async/Async.h"
+#include "Engine/Texture2D.h"
+#include "UObject/Package.h"
+
+UProgressiveAvatar::UProgressiveAvatar()
+	: SteamID(0)
+	, Texture(nullptr)
+	, AvatarSize(EAvatarSize::AVATAR_SMALL)
+	, TargetSize(EAvatarSize::AVATAR_LARGE)
+	, bIsPlaceholder(true)
+	, bIsFinal(false)
+{
+}
+
+FProgressiveAvatarProvider::FProgressiveAvatarProvider(TSharedPtr<FAvatarPipeline> InAvatarPipeline)
+	: AvatarPipeline(InAvatarPipeline)
+	, Placeholder(nullptr)
+	, NextPruneNum(64)
+{
+	CreatePlaceholder();
+
+	if (AvatarPipeline.IsValid())
+	{
+		TextureUpdatedHandle = AvatarPipeline->OnTextureUpdated.AddRaw(this, &FProgressiveAvatarProvider::OnTextureUpdated);
+	}
+}
+
+FProgressiveAvatarProvider::~FProgressiveAvatarProvider()
+{
+	if (AvatarPipeline.IsValid())
+	{
+		AvatarPipeline->OnTextureUpdated.Remove(TextureUpdatedHandle);
+	}
+}
+
+UProgressiveAvatar* FProgressiveAvatarProvider::Acquire(const CSteamID SteamID, const EAvatarSize TargetSize)
+{
+	check(IsInGameThread());
+
+	const uint64 SteamID64 = SteamID.ConvertToUint64();
+
+	if (UProgressiveAvatar* ExistingAvatar = Avatars.FindRef(SteamID64).Get())
+	{
+		// Shared handle: it grows to the biggest tier requested.
+		if (TargetSize > ExistingAvatar->TargetSize)
+		{
+			ExistingAvatar->TargetSize = TargetSize;
+			ExistingAvatar->bIsFinal = false;
+			Refine(SteamID64);
+		}
+
+		return ExistingAvatar;
+	}
+
+	if (Avatars.Num() >= NextPruneNum)
+	{
+		PruneStaleAvatars();
+	}
+
+	UProgressiveAvatar* NewAvatar = NewObject<UProgressiveAvatar>(GetTransientPackage());
+	NewAvatar->SteamID = static_cast<int32>(SteamID.GetAccountID());
+	NewAvatar->Texture = Placeholder;
+	NewAvatar->TargetSize = TargetSize;
+	Avatars.Add(SteamID64, NewAvatar);
+
+	// Tiers already cached are applied before returning.
+	Refine(SteamID64);
+
+	return NewAvatar;
+}
+
+UTexture2D* FProgressiveAvatarProvider::GetPlaceholder() const
+{
+	return Placeholder;
+}
+
+void FProgressiveAvatarProvider::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	Collector.AddReferencedObject(Placeholder);
+}
+
+FString FProgressiveAvatarProvider::GetReferencerName() const
+{
+	return TEXT("FProgressiveAvatarProvider");
+}
+
+void FProgressiveAvatarProvider::Refine(const uint64 SteamID)
+{
+	UProgressiveAvatar* Avatar = Avatars.FindRef(SteamID).Get();
+	if (!Avatar)
+	{
+		Avatars.Remove(SteamID);
+		return;
+	}
+
+	if (Avatar->bIsFinal || !AvatarPipeline.IsValid())
+	{
+		return;
+	}
+
+	// Small tier first: usually already on SteamAPI side, and only 4KB to upload.
+	TArray<EAvatarSize, TInlineAllocator<2>> Tiers;
+	if (Avatar->TargetSize != EAvatarSize::AVATAR_SMALL)
+	{
+		Tiers.Add(EAvatarSize::AVATAR_SMALL);
+	}
+	Tiers.Add(Avatar->TargetSize);
+
+	bool bIsWaitingSteamAPI = false;
+
+	for (const EAvatarSize Tier : Tiers)
+	{
+		if (!Avatar->bIsPlaceholder && Avatar->AvatarSize > Tier)
+		{
+			continue;
+		}
+
+		const int32 AvatarHandle = FAvatarPipeline::GetAvatarHandle(CSteamID(SteamID), Tier);
+		if (AvatarHandle == 0)
+		{
+			continue;
+		}
+
+		if (AvatarHandle == -1)
+		{
+			// Avatar of a previous session, shown while SteamAPI downloads the live one.
+			AvatarPipeline->RequestPersistedTexture(CSteamID(SteamID), Tier, FOnAvatarPipelineComplete::CreateSPLambda(this, [this, SteamID, Tier](UTexture2D* AvatarTexture)
+				{
+					ApplyTexture(SteamID, AvatarTexture, Tier, false);
+				}
+			));
+
+			bIsWaitingSteamAPI = true;
+			continue;
+		}
+
+		AvatarPipeline->RequestTexture(CSteamID(SteamID), AvatarHandle, Tier, FOnAvatarPipelineComplete::CreateSPLambda(this, [this, SteamID, Tier](UTexture2D* AvatarTexture)
+			{
+				ApplyTexture(SteamID, AvatarTexture, Tier, true);
+			}
+		));
+	}
+
+	if (bIsWaitingSteamAPI)
+	{
+		AddAvatarWaiter(SteamID);
+	}
+}
+
+void FProgressiveAvatarProvider::ApplyTexture(const uint64 SteamID, UTexture2D* NewTexture, const EAvatarSize NewSize, const bool bIsLive)
+{
+	UProgressiveAvatar* Avatar = Avatars.FindRef(SteamID).Get();
+	if (!Avatar || !NewTexture)
+	{
+		return;
+	}
+
+	if (bIsLive && NewSize >= Avatar->TargetSize)
+	{
+		Avatar->bIsFinal = true;
+	}
+
+	// Same tier with a different texture: persisted avatar replaced by the live one.
+	const bool bIsBetter = Avatar->bIsPlaceholder || NewSize > Avatar->AvatarSize || (NewSize == Avatar->AvatarSize && NewTexture != Avatar->Texture);
+	if (!bIsBetter)
+	{
+		return;
+	}
+
+	Avatar->Texture = NewTexture;
+	Avatar->AvatarSize = NewSize;
+	Avatar->bIsPlaceholder = false;
+	Avatar->OnChanged.Broadcast(Avatar);
+}
+
+void FProgressiveAvatarProvider::OnTextureUpdated(const uint64 SteamID, const EAvatarSize NewSize, UTexture2D* NewTexture)
+{
+	// Also reached by final handles: the user may have changed avatar.
+	ApplyTexture(SteamID, NewTexture, NewSize, true);
+}
+
+void FProgressiveAvatarProvider::AddAvatarWaiter(const uint64 SteamID)
+{
+	if (!FPNetworkingModule::GetSteamAPIManager().IsValid() || WaitingSteamIDs.Contains(SteamID))
+	{
+		return;
+	}
+
+	WaitingSteamIDs.Add(SteamID);
+
+	// Waiter is dropped by the manager once this provider is destroyed. Fired on SteamAPI thread.
+	FPNetworkingModule::GetSteamAPIManager()->AddAvatarWaiter(CSteamID(SteamID), FOnAvatarReadyFromSteamAPI::CreateSPLambda(this, [WeakThis = AsWeak(), SteamID](AvatarImageLoaded_t* pCallback)
+		{
+			AsyncTask(ENamedThreads::GameThread, [WeakThis, SteamID]()
+				{
+					TSharedPtr<FProgressiveAvatarProvider> PinnedThis = WeakThis.Pin();
+					if (PinnedThis.IsValid())
+					{
+						PinnedThis->WaitingSteamIDs.Remove(SteamID);
+						PinnedThis->Refine(SteamID);
+					}
+				}
+			);
+		}
+	));
+}
+
+void FProgressiveAvatarProvider::PruneStaleAvatars()
+{
+	for (auto It = Avatars.CreateIterator(); It; ++It)
+	{
+		if (!It.Value().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	NextPruneNum = FMath::Max(Avatars.Num() * 2, 64);
+}
+
+void FProgressiveAvatarProvider::CreatePlaceholder()
+{
+	Placeholder = UTexture2D::CreateTransient(PROGRESSIVE_AVATAR_PLACEHOLDER_SIZE, PROGRESSIVE_AVATAR_PLACEHOLDER_SIZE, EPixelFormat::PF_R8G8B8A8);
+	if (!Placeholder)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FProgressiveAvatarProvider: ERROR: Invalid Placeholder Texture!"));
+		return;
+	}
+
+	// Tiny and created once: written directly in mip data before the resource exists.
+	FTexture2DMipMap& Mip = Placeholder->GetPlatformData()->Mips[0];
+	uint8* MipData = static_cast<uint8*>(Mip.BulkData.Lock(LOCK_READ_WRITE));
+	for (int32 Pixel = 0; Pixel < PROGRESSIVE_AVATAR_PLACEHOLDER_SIZE * PROGRESSIVE_AVATAR_PLACEHOLDER_SIZE; Pixel++)
+	{
+		MipData[Pixel * 4 + 0] = PROGRESSIVE_AVATAR_PLACEHOLDER_GREY;
+		MipData[Pixel * 4 + 1] = PROGRESSIVE_AVATAR_PLACEHOLDER_GREY;
+		MipData[Pixel * 4 + 2] = PROGRESSIVE_AVATAR_PLACEHOLDER_GREY;
+		MipData[Pixel * 4 + 3] = 255;
+	}
+	Mip.BulkData.Unlock();
+
+	Placeholder->UpdateResource();
+}
@@ -0,0 +1,330 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#include "RecentPlayers.h"
+#include "PNetworking.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+FRecentPlayers::FRecentPlayers()
+	: LocalSteamID(0)
+	, bIsDirty(false)
+	, DirtySteamIDs(MakeShared<FDirtyQueue, ESPMode::ThreadSafe>())
+{
+	Slots.Reserve(RECENT_PLAYERS_CAPACITY);
+}
+
+FRecentPlayers::~FRecentPlayers()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+
+	TSharedPtr<SteamAPICallbackManager> PinnedManager = SteamAPIManager.Pin();
+	if (PinnedManager.IsValid())
+	{
+		PinnedManager->OnPersonaStateChanged.Remove(PersonaStateChangedHandle);
+	}
+}
+
+bool FRecentPlayers::Initialize()
+{
+	check(IsInGameThread());
+
+	ISteamFriends* SteamFriendsInterface = SteamFriends();
+	TSharedPtr<SteamAPICallbackManager> PinnedManager = FPNetworkingModule::GetSteamAPIManager();
+	if (!SteamFriendsInterface || !PinnedManager.IsValid())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FRecentPlayers: SteamFriendsInterface steamworks_sdk not valid!"));
+		return false;
+	}
+
+	// Players met by another account (e.g. shared PC) must never be served.
+	ISteamUser* SteamUserInterface = SteamUser();
+	LocalSteamID = SteamUserInterface ? SteamUserInterface->GetSteamID().ConvertToUint64() : 0;
+
+	SteamAPIManager = PinnedManager;
+	PersonaStateChangedHandle = PinnedManager->OnPersonaStateChanged.AddLambda([DirtySteamIDs = DirtySteamIDs](uint64 SteamID, int32 ChangeFlags)
+		{
+			if (ChangeFlags & k_EPersonaChangeName)
+			{
+				DirtySteamIDs->Enqueue(SteamID);
+			}
+		}
+	);
+
+	Load();
+
+	// Steam coplay list: players of previous sessions, also recorded by other games using SetPlayedWith.
+	const AppId_t AppID = SteamUtils() ? SteamUtils()->GetAppID() : 0;
+	const int32 CoplayCount = SteamFriendsInterface->GetCoplayFriendCount();
+	for (int32 Index = 0; Index < CoplayCount; Index++)
+	{
+		const CSteamID CoplaySteamID = SteamFriendsInterface->GetCoplayFriend(Index);
+		if (CoplaySteamID.IsValid() && SteamFriendsInterface->GetFriendCoplayGame(CoplaySteamID) == AppID)
+		{
+			Put(CoplaySteamID.ConvertToUint64(), FDateTime::FromUnixTimestamp(SteamFriendsInterface->GetFriendCoplayTime(CoplaySteamID)));
+		}
+	}
+
+	// Names and avatars are downloaded in the background: persisted names are shown meanwhile.
+	for (FRecord& Record : Slots)
+	{
+		if (!SteamFriendsInterface->RequestUserInformation(CSteamID(Record.SteamID), false))
+		{
+			ReadName(Record);
+		}
+	}
+
+	TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FRecentPlayers::Tick));
+
+	UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("FRecentPlayers: Loaded %d players"), Slots.Num());
+	return true;
+}
+
+bool FRecentPlayers::Save()
+{
+	if (!bIsDirty)
+	{
+		return true;
+	}
+
+	const FString FilePath = GetFilePath();
+	if (FilePath.IsEmpty())
+	{
+		return false;
+	}
+
+	TArray<uint8> Buffer;
+	FMemoryWriter Writer(Buffer);
+
+	uint32 Magic = RECENT_PLAYERS_MAGIC;
+	uint32 Version = RECENT_PLAYERS_VERSION;
+	int32 NumRecords = Slots.Num();
+	Writer << Magic << Version << NumRecords;
+
+	for (FRecord& Record : Slots)
+	{
+		int64 Ticks = Record.LastPlayed.GetTicks();
+		Writer << Record.SteamID << Ticks << Record.UserName;
+	}
+
+	// Written aside and then moved, so a crash while saving never leaves a truncated file.
+	const FString TempPath = FilePath + TEXT(".tmp");
+	if (!FFileHelper::SaveArrayToFile(Buffer, *TempPath) || !IFileManager::Get().Move(*FilePath, *TempPath, true, true))
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FRecentPlayers: Can't write %s!"), *FilePath);
+		IFileManager::Get().Delete(*TempPath);
+		return false;
+	}
+
+	bIsDirty = false;
+	return true;
+}
+
+bool FRecentPlayers::Record(const uint64 SteamID)
+{
+	check(IsInGameThread());
+
+	ISteamFriends* SteamFriendsInterface = SteamFriends();
+	if (!SteamFriendsInterface || SessionSteamIDs.Contains(SteamID))
+	{
+		return false;
+	}
+
+	SessionSteamIDs.Add(SteamID);
+
+	const CSteamID PlayerSteamID(SteamID);
+	SteamFriendsInterface->SetPlayedWith(PlayerSteamID);
+
+	Put(SteamID, FDateTime::UtcNow());
+
+	// False means name and avatar are already on SteamAPI side.
+	if (!SteamFriendsInterface->RequestUserInformation(PlayerSteamID, false))
+	{
+		if (const int32* Slot = SlotBySteamID.Find(SteamID))
+		{
+			ReadName(Slots[*Slot]);
+		}
+	}
+
+	OnChanged.Broadcast();
+	return true;
+}
+
+void FRecentPlayers::EndSession()
+{
+	SessionSteamIDs.Reset();
+}
+
+void FRecentPlayers::Clear()
+{
+	Slots.Reset();
+	SlotBySteamID.Reset();
+	SessionSteamIDs.Reset();
+	bIsDirty = true;
+
+	Save();
+	OnChanged.Broadcast();
+}
+
+void FRecentPlayers::GetPlayers(TArray<const FRecord*>& OutRecords, const int32 MaxPlayers) const
+{
+	OutRecords.Reset(Slots.Num());
+	for (const FRecord& Record : Slots)
+	{
+		OutRecords.Add(&Record);
+	}
+
+	OutRecords.Sort([](const FRecord& First, const FRecord& Second) { return First.LastPlayed > Second.LastPlayed; });
+
+	if (MaxPlayers >= 0 && OutRecords.Num() > MaxPlayers)
+	{
+		OutRecords.SetNum(MaxPlayers, EAllowShrinking::No);
+	}
+}
+
+int32 FRecentPlayers::Num() const
+{
+	return Slots.Num();
+}
+
+bool FRecentPlayers::Load()
+{
+	Slots.Reset();
+	SlotBySteamID.Reset();
+
+	const FString FilePath = GetFilePath();
+	TArray<uint8> Buffer;
+	if (FilePath.IsEmpty() || !IFileManager::Get().FileExists(*FilePath) || !FFileHelper::LoadFileToArray(Buffer, *FilePath))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Buffer);
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	int32 NumRecords = 0;
+	Reader << Magic << Version << NumRecords;
+
+	if (Magic != RECENT_PLAYERS_MAGIC || Version != RECENT_PLAYERS_VERSION || NumRecords < 0 || NumRecords > RECENT_PLAYERS_CAPACITY)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FRecentPlayers: Invalid file, ignored!"));
+		return false;
+	}
+
+	for (int32 Index = 0; Index < NumRecords; Index++)
+	{
+		uint64 SteamID = 0;
+		int64 Ticks = 0;
+		FString UserName;
+		Reader << SteamID << Ticks << UserName;
+
+		// Truncated file: keep records read so far.
+		if (Reader.IsError() || SlotBySteamID.Contains(SteamID))
+		{
+			break;
+		}
+
+		SlotBySteamID.Add(SteamID, Slots.Num());
+		Slots.Add({ SteamID, FDateTime(FMath::Clamp(Ticks, FDateTime::MinValue().GetTicks(), FDateTime::MaxValue().GetTicks())), MoveTemp(UserName) });
+	}
+
+	return true;
+}
+
+bool FRecentPlayers::Tick(float DeltaTime)
+{
+	if (DirtySteamIDs->IsEmpty())
+	{
+		return true;
+	}
+
+	bool bHasChanged = false;
+	uint64 SteamID = 0;
+	while (DirtySteamIDs->Dequeue(SteamID))
+	{
+		// Most notifications are about friends not in this list.
+		if (const int32* Slot = SlotBySteamID.Find(SteamID))
+		{
+			bHasChanged |= ReadName(Slots[*Slot]);
+		}
+	}
+
+	if (bHasChanged)
+	{
+		OnChanged.Broadcast();
+	}
+
+	return true;
+}
+
+void FRecentPlayers::Put(const uint64 SteamID, const FDateTime LastPlayed)
+{
+	if (const int32* Slot = SlotBySteamID.Find(SteamID))
+	{
+		FRecord& Record = Slots[*Slot];
+		if (LastPlayed > Record.LastPlayed)
+		{
+			Record.LastPlayed = LastPlayed;
+			bIsDirty = true;
+		}
+		return;
+	}
+
+	bIsDirty = true;
+
+	if (Slots.Num() < RECENT_PLAYERS_CAPACITY)
+	{
+		SlotBySteamID.Add(SteamID, Slots.Num());
+		Slots.Add({ SteamID, LastPlayed, FString() });
+		return;
+	}
+
+	int32 OldestSlot = 0;
+	for (int32 Slot = 1; Slot < Slots.Num(); Slot++)
+	{
+		if (Slots[Slot].LastPlayed < Slots[OldestSlot].LastPlayed)
+		{
+			OldestSlot = Slot;
+		}
+	}
+
+	SlotBySteamID.Remove(Slots[OldestSlot].SteamID);
+	SlotBySteamID.Add(SteamID, OldestSlot);
+	Slots[OldestSlot] = { SteamID, LastPlayed, FString() };
+}
+
+bool FRecentPlayers::ReadName(FRecord& Record)
+{
+	ISteamFriends* SteamFriendsInterface = SteamFriends();
+	if (!SteamFriendsInterface)
+	{
+		return false;
+	}
+
+	const FString UserName = FString(UTF8_TO_TCHAR(SteamFriendsInterface->GetFriendPersonaName(CSteamID(Record.SteamID))));
+
+	// SteamAPI answers "[unknown]" until persona is downloaded: keep the persisted name.
+	if (UserName.IsEmpty() || UserName == TEXT("[unknown]") || UserName.Equals(Record.UserName, ESearchCase::CaseSensitive))
+	{
+		return false;
+	}
+
+	Record.UserName = UserName;
+	bIsDirty = true;
+	return true;
+}
+
+FString FRecentPlayers::GetFilePath() const
+{
+	if (LocalSteamID == 0)
+	{
+		return FString();
+	}
+
+	return FPaths::Combine(FPaths::ProjectSavedDir(), FString::Printf(RECENT_PLAYERS_FILE_NAME, LocalSteamID));
+}
@@ -0,0 +1,116 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#include "RelayNetwork.h"
+#include "PNetworking.h"
+
+FRelayNetwork::FRelayNetwork()
+	: State(ERelayNetworkState::RELAY_NOT_STARTED)
+	, StartTime(0.0)
+	, PollInterval(RELAY_NETWORK_POLL_INTERVAL)
+{
+}
+
+FRelayNetwork::~FRelayNetwork()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+}
+
+bool FRelayNetwork::Start()
+{
+	check(IsInGameThread());
+
+	if (State != ERelayNetworkState::RELAY_NOT_STARTED)
+	{
+		return true;
+	}
+
+	ISteamNetworkingUtils* SteamNetworkingUtilsInterface = SteamNetworkingUtils();
+	if (!SteamAPI_IsSteamRunning() || !SteamNetworkingUtilsInterface)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FRelayNetwork: SteamNetworkingUtilsInterface steamworks_sdk not available yet!"));
+		return false;
+	}
+
+	SteamNetworkingUtilsInterface->InitRelayNetworkAccess();
+
+	StartTime = FPlatformTime::Seconds();
+	SetState(ERelayNetworkState::RELAY_WARMING);
+
+	// Relays may already be known from a previous call: read status now.
+	Tick(0.0f);
+	PollInterval = GetPollInterval();
+	TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FRelayNetwork::Tick), PollInterval);
+	return true;
+}
+
+ERelayNetworkState FRelayNetwork::GetState() const
+{
+	return State;
+}
+
+bool FRelayNetwork::IsSettled() const
+{
+	return State != ERelayNetworkState::RELAY_WARMING;
+}
+
+bool FRelayNetwork::Tick(float DeltaTime)
+{
+	ISteamNetworkingUtils* SteamNetworkingUtilsInterface = SteamNetworkingUtils();
+	if (!SteamNetworkingUtilsInterface)
+	{
+		SetState(ERelayNetworkState::RELAY_UNAVAILABLE);
+		return true;
+	}
+
+	const ESteamNetworkingAvailability Availability = SteamNetworkingUtilsInterface->GetRelayNetworkStatus(nullptr);
+
+	SteamNetworkPingLocation_t LocalLocation;
+	const bool bIsCurrent = Availability == k_ESteamNetworkingAvailability_Current && SteamNetworkingUtilsInterface->GetLocalPingLocation(LocalLocation) >= 0.0f;
+
+	if (bIsCurrent)
+	{
+		SetState(ERelayNetworkState::RELAY_READY);
+	}
+	else if (Availability <= k_ESteamNetworkingAvailability_Previously)
+	{
+		// CannotTry, Failed, Previously: SteamAPI gave up for now. Retrying is still an attempt in progress.
+		SetState(ERelayNetworkState::RELAY_UNAVAILABLE);
+	}
+	else if (State == ERelayNetworkState::RELAY_WARMING && FPlatformTime::Seconds() - StartTime > RELAY_NETWORK_WARMUP_TIMEOUT)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FRelayNetwork: Warm up timed out!"));
+		SetState(ERelayNetworkState::RELAY_UNAVAILABLE);
+	}
+
+	// Otherwise (waiting, attempting, retrying) current state is kept: a ready network re-measuring is still usable.
+
+	// State moved in or out of ready: poll again with the matching interval.
+	if (TickHandle.IsValid() && GetPollInterval() != PollInterval)
+	{
+		PollInterval = GetPollInterval();
+		TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FRelayNetwork::Tick), PollInterval);
+		return false;
+	}
+
+	return true;
+}
+
+void FRelayNetwork::SetState(const ERelayNetworkState NewState)
+{
+	if (State == NewState)
+	{
+		return;
+	}
+
+	UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("FRelayNetwork: %s -> %s after %.3fs"), *UEnum::GetValueAsString(State), *UEnum::GetValueAsString(NewState), FPlatformTime::Seconds() - StartTime);
+
+	State = NewState;
+	OnStateChanged.Broadcast(State);
+}
+
+float FRelayNetwork::GetPollInterval() const
+{
+	return State == ERelayNetworkState::RELAY_READY ? RELAY_NETWORK_READY_POLL_INTERVAL : RELAY_NETWORK_POLL_INTERVAL;
+}
@@ -0,0 +1,227 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#include "RichPresenceCache.h"
+#include "PNetworking.h"
+
+FRichPresenceCache::FRichPresenceCache()
+	: DirtySteamIDs(MakeShared<FDirtyQueue, ESPMode::ThreadSafe>())
+{
+}
+
+FRichPresenceCache::~FRichPresenceCache()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+
+	TSharedPtr<SteamAPICallbackManager> PinnedManager = SteamAPIManager.Pin();
+	if (PinnedManager.IsValid())
+	{
+		PinnedManager->OnRichPresenceUpdated.Remove(RichPresenceUpdatedHandle);
+	}
+}
+
+bool FRichPresenceCache::Initialize(const TArray<uint64>& SeedSteamIDs)
+{
+	check(IsInGameThread());
+
+	TSharedPtr<SteamAPICallbackManager> PinnedManager = FPNetworkingModule::GetSteamAPIManager();
+	if (!SteamFriends() || !PinnedManager.IsValid())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FRichPresenceCache: SteamFriendsInterface steamworks_sdk not valid!"));
+		return false;
+	}
+
+	SteamAPIManager = PinnedManager;
+	RichPresenceUpdatedHandle = PinnedManager->OnRichPresenceUpdated.AddLambda([DirtySteamIDs = DirtySteamIDs](uint64 SteamID)
+		{
+			DirtySteamIDs->Enqueue(SteamID);
+		}
+	);
+
+	// Friends playing this game already have their rich presence on SteamAPI side: no request needed.
+	Presences.Reserve(SeedSteamIDs.Num());
+	for (const uint64 SteamID : SeedSteamIDs)
+	{
+		Read(SteamID);
+	}
+
+	TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FRichPresenceCache::Tick));
+
+	UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("FRichPresenceCache: Seeded with %d users, %d joinable"), Presences.Num(), JoinableSteamIDs.Num());
+	return true;
+}
+
+void FRichPresenceCache::Request(TConstArrayView<uint64> SteamIDs)
+{
+	check(IsInGameThread());
+
+	const double Now = FPlatformTime::Seconds();
+	for (const uint64 SteamID : SteamIDs)
+	{
+		const FRichPresence* Presence = Presences.Find(SteamID);
+		if (Presence && Presence->RequestTime > 0.0 && Now - Presence->RequestTime < RICH_PRESENCE_REQUEST_COOLDOWN)
+		{
+			continue;
+		}
+
+		bool bIsAlreadyPending = false;
+		PendingRequestSet.Add(SteamID, &bIsAlreadyPending);
+		if (!bIsAlreadyPending)
+		{
+			PendingRequests.Add(SteamID);
+		}
+	}
+}
+
+const FString* FRichPresenceCache::Find(const uint64 SteamID, const FName Key) const
+{
+	const FRichPresence* Presence = Presences.Find(SteamID);
+	if (!Presence)
+	{
+		return nullptr;
+	}
+
+	for (const TPair<FName, FString>& Pair : Presence->Pairs)
+	{
+		if (Pair.Key == Key)
+		{
+			return &Pair.Value;
+		}
+	}
+
+	return nullptr;
+}
+
+bool FRichPresenceCache::GetPairs(const uint64 SteamID, TArray<TPair<FName, FString>>& OutPairs) const
+{
+	const FRichPresence* Presence = Presences.Find(SteamID);
+	if (!Presence || Presence->Pairs.Num() == 0)
+	{
+		OutPairs.Reset();
+		return false;
+	}
+
+	OutPairs = Presence->Pairs;
+	return true;
+}
+
+const TSet<uint64>& FRichPresenceCache::GetJoinableSteamIDs() const
+{
+	return JoinableSteamIDs;
+}
+
+int32 FRichPresenceCache::GetNumPendingRequests() const
+{
+	return PendingRequests.Num();
+}
+
+bool FRichPresenceCache::Tick(float DeltaTime)
+{
+	// Bursts name the same user many times: read it once.
+	if (!DirtySteamIDs->IsEmpty())
+	{
+		TSet<uint64> ChangedSteamIDs;
+		uint64 SteamID = 0;
+		while (DirtySteamIDs->Dequeue(SteamID))
+		{
+			ChangedSteamIDs.Add(SteamID);
+		}
+
+		for (const uint64 ChangedSteamID : ChangedSteamIDs)
+		{
+			if (Read(ChangedSteamID))
+			{
+				OnChanged.Broadcast(ChangedSteamID);
+			}
+		}
+	}
+
+	if (PendingRequests.Num() > 0)
+	{
+		ISteamFriends* SteamFriendsInterface = SteamFriends();
+		if (!SteamFriendsInterface)
+		{
+			return true;
+		}
+
+		const double Now = FPlatformTime::Seconds();
+		const int32 NumToSend = FMath::Min(PendingRequests.Num(), RICH_PRESENCE_REQUESTS_PER_TICK);
+
+		for (int32 Index = 0; Index < NumToSend; Index++)
+		{
+			const uint64 SteamID = PendingRequests[Index];
+			SteamFriendsInterface->RequestFriendRichPresence(CSteamID(SteamID));
+			Presences.FindOrAdd(SteamID).RequestTime = Now;
+			PendingRequestSet.Remove(SteamID);
+		}
+
+		PendingRequests.RemoveAt(0, NumToSend, EAllowShrinking::No);
+	}
+
+	return true;
+}
+
+bool FRichPresenceCache::Read(const uint64 SteamID)
+{
+	ISteamFriends* SteamFriendsInterface = SteamFriends();
+	if (!SteamFriendsInterface)
+	{
+		return false;
+	}
+
+	const CSteamID FriendSteamID(SteamID);
+	const int32 KeyCount = SteamFriendsInterface->GetFriendRichPresenceKeyCount(FriendSteamID);
+
+	TArray<TPair<FName, FString>> NewPairs;
+	NewPairs.Reserve(KeyCount);
+	for (int32 Index = 0; Index < KeyCount; Index++)
+	{
+		const char* Key = SteamFriendsInterface->GetFriendRichPresenceKeyByIndex(FriendSteamID, Index);
+		if (!Key || Key[0] == '\0')
+		{
+			continue;
+		}
+
+		NewPairs.Emplace(FName(UTF8_TO_TCHAR(Key)), FString(UTF8_TO_TCHAR(SteamFriendsInterface->GetFriendRichPresence(FriendSteamID, Key))));
+	}
+
+	FRichPresence* Presence = Presences.Find(SteamID);
+	if (!Presence)
+	{
+		if (NewPairs.Num() == 0)
+		{
+			return false;
+		}
+
+		Presence = &Presences.Add(SteamID);
+	}
+	else if (Presence->Pairs.Num() == NewPairs.Num())
+	{
+		// Same keys in the same order: nothing to notify.
+		bool bIsSame = true;
+		for (int32 Index = 0; Index < NewPairs.Num() && bIsSame; Index++)
+		{
+			bIsSame = Presence->Pairs[Index].Key == NewPairs[Index].Key && Presence->Pairs[Index].Value.Equals(NewPairs[Index].Value, ESearchCase::CaseSensitive);
+		}
+
+		if (bIsSame)
+		{
+			return false;
+		}
+	}
+
+	Presence->Pairs = MoveTemp(NewPairs);
+
+	const FString* Connect = Find(SteamID, FName(TEXT(RICH_PRESENCE_CONNECT_KEY)));
+	if (Connect && !Connect->IsEmpty())
+	{
+		JoinableSteamIDs.Add(SteamID);
+	}
+	else
+	{
+		JoinableSteamIDs.Remove(SteamID);
+	}
+
+	return true;
+}
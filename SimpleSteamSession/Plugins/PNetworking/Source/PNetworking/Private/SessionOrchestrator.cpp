@@ -0,0 +1,915 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#include "SessionOrchestrator.h"
+#include "PNetworking.h"
+#include "RelayNetwork.h"
+#include "PingLocation.h"
+#include "Engine/Engine.h"
+#include "Kismet/GameplayStatics.h"
+
+FSessionOrchestrator::FSessionOrchestrator()
+	: Phase(EPhase::IDLE)
+	, AbandonedPhase(EPhase::IDLE)
+	, AbandonTime(0.0)
+	, NextOperationID(1)
+	, UpdateWindow(SESSION_UPDATE_WINDOW)
+	, NextTransition(0)
+	, StateEnterTime(0.0)
+{
+	Transitions.Reserve(SESSION_TRANSITION_HISTORY);
+}
+
+FSessionOrchestrator::~FSessionOrchestrator()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+	FTSTicker::GetCoreTicker().RemoveTicker(UpdateWindowHandle);
+
+	TSharedPtr<FRelayNetwork> PinnedRelayNetwork = RelayNetwork.Pin();
+	if (PinnedRelayNetwork.IsValid())
+	{
+		PinnedRelayNetwork->OnStateChanged.Remove(RelayNetworkStateChangedHandle);
+	}
+
+	IOnlineSessionPtr PinnedSession = SessionInterface.Pin();
+	if (!PinnedSession.IsValid())
+	{
+		return;
+	}
+
+	PinnedSession->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteHandle);
+	PinnedSession->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteHandle);
+	PinnedSession->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteHandle);
+	PinnedSession->ClearOnUpdateSessionCompleteDelegate_Handle(UpdateSessionCompleteHandle);
+}
+
+bool FSessionOrchestrator::Initialize()
+{
+	check(IsInGameThread());
+
+	IOnlineSessionPtr PinnedSession = FPNetworkingModule::GetOnlineSessionPointer();
+	if (!PinnedSession.IsValid())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FSessionOrchestrator: SessionInterface is invalid!"));
+		return false;
+	}
+
+	SessionInterface = PinnedSession;
+	CreateSessionCompleteHandle = PinnedSession->AddOnCreateSessionCompleteDelegate_Handle(
+		FOnCreateSessionCompleteDelegate::CreateRaw(this, &FSessionOrchestrator::OnCreateSessionComplete));
+	DestroySessionCompleteHandle = PinnedSession->AddOnDestroySessionCompleteDelegate_Handle(
+		FOnDestroySessionCompleteDelegate::CreateRaw(this, &FSessionOrchestrator::OnDestroySessionComplete));
+	JoinSessionCompleteHandle = PinnedSession->AddOnJoinSessionCompleteDelegate_Handle(
+		FOnJoinSessionCompleteDelegate::CreateRaw(this, &FSessionOrchestrator::OnJoinSessionComplete));
+	UpdateSessionCompleteHandle = PinnedSession->AddOnUpdateSessionCompleteDelegate_Handle(
+		FOnUpdateSessionCompleteDelegate::CreateRaw(this, &FSessionOrchestrator::OnUpdateSessionComplete));
+
+	TSharedPtr<FRelayNetwork> PinnedRelayNetwork = FPNetworkingModule::GetRelayNetwork();
+	if (PinnedRelayNetwork.IsValid())
+	{
+		RelayNetwork = PinnedRelayNetwork;
+		RelayNetworkStateChangedHandle = PinnedRelayNetwork->OnStateChanged.AddRaw(this, &FSessionOrchestrator::OnRelayNetworkStateChanged);
+	}
+
+	StateEnterTime = FPlatformTime::Seconds();
+
+	// Only timeouts are checked here: operations are started as soon as the previous one completes.
+	TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FSessionOrchestrator::Tick), 1.0f);
+	return true;
+}
+
+int32 FSessionOrchestrator::Create(const FOnlineSessionSettings& Settings, const FString& TravelToMapPath, FOnSessionOperationDone Callback)
+{
+	TSharedRef<FOperation> Operation = MakeShared<FOperation>();
+	Operation->Type = ESessionOperationType::OPERATION_CREATE;
+	Operation->Settings = Settings;
+	Operation->MapPath = TravelToMapPath;
+	return Enqueue(Operation, MoveTemp(Callback));
+}
+
+int32 FSessionOrchestrator::Destroy(FOnSessionOperationDone Callback)
+{
+	TSharedRef<FOperation> Operation = MakeShared<FOperation>();
+	Operation->Type = ESessionOperationType::OPERATION_DESTROY;
+	return Enqueue(Operation, MoveTemp(Callback));
+}
+
+int32 FSessionOrchestrator::Join(const FOnlineSessionSearchResult& SearchResult, FOnSessionOperationDone Callback)
+{
+	TSharedRef<FOperation> Operation = MakeShared<FOperation>();
+	Operation->Type = ESessionOperationType::OPERATION_JOIN;
+	Operation->SearchResult = SearchResult;
+	return Enqueue(Operation, MoveTemp(Callback));
+}
+
+int32 FSessionOrchestrator::Update(const FUpdateSessionParameters& Parameters, FOnSessionOperationDone Callback)
+{
+	TSharedRef<FOperation> Operation = MakeShared<FOperation>();
+	Operation->Type = ESessionOperationType::OPERATION_UPDATE;
+	Operation->UpdateParameters = Parameters;
+
+	// Fields left as they are by the caller must not overwrite changes of merged requests.
+	Operation->UpdateMask = GetChangedUpdateFields(Parameters);
+	return Enqueue(Operation, MoveTemp(Callback));
+}
+
+int32 FSessionOrchestrator::Quit(const FString& TravelBackMapPath, FOnSessionOperationDone Callback)
+{
+	TSharedRef<FOperation> Operation = MakeShared<FOperation>();
+	Operation->Type = ESessionOperationType::OPERATION_QUIT;
+	Operation->MapPath = TravelBackMapPath;
+	return Enqueue(Operation, MoveTemp(Callback));
+}
+
+int32 FSessionOrchestrator::Invite(const FUniqueNetIdPtr& FriendNetID, FOnSessionOperationDone Callback)
+{
+	TSharedRef<FOperation> Operation = MakeShared<FOperation>();
+	Operation->Type = ESessionOperationType::OPERATION_INVITE;
+	Operation->FriendNetID = FriendNetID;
+	return Enqueue(Operation, MoveTemp(Callback));
+}
+
+void FSessionOrchestrator::SetUpdateWindow(const double Seconds)
+{
+	UpdateWindow = FMath::Max(Seconds, 0.0);
+}
+
+bool FSessionOrchestrator::IsBusy() const
+{
+	return Running.IsValid() || AbandonedPhase != EPhase::IDLE || Queue.Num() > 0;
+}
+
+int32 FSessionOrchestrator::GetNumQueued() const
+{
+	return Queue.Num();
+}
+
+void FSessionOrchestrator::GetTransitions(TArray<FSessionTransition>& OutTransitions) const
+{
+	OutTransitions.Reset(Transitions.Num());
+
+	const int32 First = Transitions.Num() < SESSION_TRANSITION_HISTORY ? 0 : NextTransition;
+	for (int32 Index = 0; Index < Transitions.Num(); Index++)
+	{
+		OutTransitions.Add(Transitions[(First + Index) % Transitions.Num()]);
+	}
+}
+
+int32 FSessionOrchestrator::Enqueue(TSharedRef<FOperation> Operation, FOnSessionOperationDone Callback)
+{
+	check(IsInGameThread());
+
+	if (!SessionInterface.IsValid())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FSessionOrchestrator: SessionInterface is invalid!"));
+		return 0;
+	}
+
+	const int32 OperationID = NextOperationID;
+	NextOperationID = NextOperationID == MAX_int32 ? 1 : NextOperationID + 1;
+
+	Operation->Requests.Add({ OperationID, Operation->Type, FPlatformTime::Seconds(), MoveTemp(Callback) });
+
+	if (TryMerge(*Operation))
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("FSessionOrchestrator: Operation %d (%s) merged into queued %s"),
+			OperationID, *UEnum::GetValueAsString(Operation->Type), *UEnum::GetValueAsString(Queue.Last()->Type));
+	}
+	else
+	{
+		Queue.Add(Operation);
+	}
+
+	StartNext();
+	return OperationID;
+}
+
+bool FSessionOrchestrator::TryMerge(FOperation& Operation)
+{
+	// Only the last one: merging across other operations would change their order.
+	if (Queue.Num() == 0)
+	{
+		return false;
+	}
+
+	FOperation& Last = *Queue.Last();
+	bool bIsRedundant = false;
+
+	switch (Operation.Type)
+	{
+	case ESessionOperationType::OPERATION_CREATE:
+	case ESessionOperationType::OPERATION_JOIN:
+		// Both destroy the old session first, so a queued Destroy adds nothing.
+		bIsRedundant = Last.Type == Operation.Type || Last.Type == ESessionOperationType::OPERATION_DESTROY;
+		break;
+
+	case ESessionOperationType::OPERATION_UPDATE:
+	case ESessionOperationType::OPERATION_DESTROY:
+	case ESessionOperationType::OPERATION_QUIT:
+		bIsRedundant = Last.Type == Operation.Type;
+		break;
+
+	case ESessionOperationType::OPERATION_INVITE:
+		bIsRedundant = Last.Type == Operation.Type && Last.FriendNetID.IsValid() && Operation.FriendNetID.IsValid() && *Last.FriendNetID == *Operation.FriendNetID;
+		break;
+	}
+
+	if (!bIsRedundant)
+	{
+		return false;
+	}
+
+	// Last requested parameters win. Updates only override fields they changed.
+	Last.Type = Operation.Type;
+	Last.Settings = MoveTemp(Operation.Settings);
+	Last.SearchResult = MoveTemp(Operation.SearchResult);
+	if (Operation.Type == ESessionOperationType::OPERATION_UPDATE)
+	{
+		CopyUpdateFields(Operation.UpdateParameters, Operation.UpdateMask, Last.UpdateParameters);
+		Last.UpdateMask |= Operation.UpdateMask;
+	}
+	Last.MapPath = MoveTemp(Operation.MapPath);
+	Last.FriendNetID = MoveTemp(Operation.FriendNetID);
+	Last.Requests.Append(MoveTemp(Operation.Requests));
+	return true;
+}
+
+uint8 FSessionOrchestrator::GetChangedUpdateFields(const FUpdateSessionParameters& Parameters) const
+{
+	IOnlineSessionPtr PinnedSession = SessionInterface.Pin();
+	const FOnlineSessionSettings* SessionSettings = PinnedSession.IsValid() ? PinnedSession->GetSessionSettings(FPNetworkingModule::GetSessionName()) : nullptr;
+
+	const auto IsCreateOrJoin = [](const FOperation& Operation)
+	{
+		return Operation.Type == ESessionOperationType::OPERATION_CREATE || Operation.Type == ESessionOperationType::OPERATION_JOIN;
+	};
+
+	// Session not there yet, or replaced before the update runs: every field is applied.
+	if (!SessionSettings || (Running.IsValid() && IsCreateOrJoin(*Running)) || Queue.ContainsByPredicate([&IsCreateOrJoin](const TSharedRef<FOperation>& Queued) { return IsCreateOrJoin(*Queued); }))
+	{
+		return UPDATE_FIELDS_ALL;
+	}
+
+	// Values the session will have once pending updates are sent.
+	FUpdateSessionParameters Expected;
+	CopyUpdateFields(*SessionSettings, UPDATE_FIELDS_ALL, Expected);
+
+	if (Running.IsValid() && Running->Type == ESessionOperationType::OPERATION_UPDATE)
+	{
+		CopyUpdateFields(Running->UpdateParameters, Running->UpdateMask, Expected);
+	}
+
+	for (const TSharedRef<FOperation>& Queued : Queue)
+	{
+		if (Queued->Type == ESessionOperationType::OPERATION_UPDATE)
+		{
+			CopyUpdateFields(Queued->UpdateParameters, Queued->UpdateMask, Expected);
+		}
+	}
+
+	return CopyUpdateFields(Parameters, UPDATE_FIELDS_ALL, Expected);
+}
+
+template<typename FromType, typename ToType>
+uint8 FSessionOrchestrator::CopyUpdateFields(const FromType& From, const uint8 Mask, ToType& To)
+{
+	uint8 ChangedFields = 0;
+
+	const auto CopyField = [Mask, &ChangedFields](const auto& FromField, auto& ToField, const uint8 Field)
+	{
+		if ((Mask & Field) != 0 && ToField != FromField)
+		{
+			ToField = FromField;
+			ChangedFields |= Field;
+		}
+	};
+
+	CopyField(From.NumPublicConnections, To.NumPublicConnections, UPDATE_NUM_PUBLIC_CONNECTIONS);
+	CopyField(From.NumPrivateConnections, To.NumPrivateConnections, UPDATE_NUM_PRIVATE_CONNECTIONS);
+	CopyField(From.bShouldAdvertise, To.bShouldAdvertise, UPDATE_SHOULD_ADVERTISE);
+	CopyField(From.bAllowJoinInProgress, To.bAllowJoinInProgress, UPDATE_ALLOW_JOIN_IN_PROGRESS);
+	CopyField(From.bIsLANMatch, To.bIsLANMatch, UPDATE_IS_LAN_MATCH);
+	CopyField(From.bIsDedicated, To.bIsDedicated, UPDATE_IS_DEDICATED);
+	CopyField(From.bAllowInvites, To.bAllowInvites, UPDATE_ALLOW_INVITES);
+
+	return ChangedFields;
+}
+
+void FSessionOrchestrator::StartNext()
+{
+	// A timed out OSS call may still answer: nothing else is sent until it does.
+	if (Running.IsValid() || AbandonedPhase != EPhase::IDLE || Queue.Num() == 0)
+	{
+		return;
+	}
+
+	// An update is held for its window, measured from its first request: updates requested meanwhile merge into it.
+	const double Now = FPlatformTime::Seconds();
+	const double HoldUntil = Queue[0]->Type == ESessionOperationType::OPERATION_UPDATE ? Queue[0]->Requests[0].EnqueueTime + UpdateWindow : 0.0;
+	if (Now < HoldUntil)
+	{
+		if (!UpdateWindowHandle.IsValid())
+		{
+			UpdateWindowHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FSessionOrchestrator::OnUpdateWindowElapsed), static_cast<float>(HoldUntil - Now));
+		}
+		return;
+	}
+
+	Running = Queue[0];
+	Queue.RemoveAt(0);
+	Running->StartTime = FPlatformTime::Seconds();
+
+	UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("FSessionOrchestrator: Running operation %d (%s), %d queued"),
+		Running->Requests[0].OperationID, *UEnum::GetValueAsString(Running->Type), Queue.Num());
+
+	Run();
+}
+
+void FSessionOrchestrator::Run()
+{
+	switch (Running->Type)
+	{
+	case ESessionOperationType::OPERATION_CREATE:
+	case ESessionOperationType::OPERATION_JOIN:
+		if (!IsRelayNetworkSettled())
+		{
+			UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("FSessionOrchestrator: Operation %d waiting relay network warm up"), Running->Requests[0].OperationID);
+			Phase = EPhase::WAITING_RELAY;
+			break;
+		}
+		RunCreateOrJoin();
+		break;
+
+	case ESessionOperationType::OPERATION_DESTROY:
+		RunDestroy();
+		break;
+
+	case ESessionOperationType::OPERATION_UPDATE:
+		RunUpdate();
+		break;
+
+	case ESessionOperationType::OPERATION_QUIT:
+		RunQuit();
+		break;
+
+	case ESessionOperationType::OPERATION_INVITE:
+		RunInvite();
+		break;
+	}
+}
+
+void FSessionOrchestrator::RunCreateOrJoin()
+{
+	IOnlineSessionPtr PinnedSession = SessionInterface.Pin();
+	if (!PinnedSession.IsValid())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FSessionOrchestrator: SessionInterface is invalid!"));
+		Complete(false);
+		return;
+	}
+
+	if (!PinnedSession->GetNamedSession(FPNetworkingModule::GetSessionName()))
+	{
+		Running->Type == ESessionOperationType::OPERATION_CREATE ? StartCreate() : StartJoin();
+		return;
+	}
+
+	UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FSessionOrchestrator: Old session found, destroying it first!"));
+
+	const TSharedPtr<FOperation> Operation = Running;
+	Transition(ELocalSessionState::SESSION_DESTROYING);
+	Phase = EPhase::DESTROYING_OLD;
+
+	// OSS may answer inside the call: only a failure still waited is handled here.
+	if (!PinnedSession->DestroySession(FPNetworkingModule::GetSessionName()) && Running == Operation && Phase == EPhase::DESTROYING_OLD)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FSessionOrchestrator: Can't destroy old session!"));
+		Transition(ELocalSessionState::SESSION_INVALID);
+		Complete(false);
+	}
+}
+
+void FSessionOrchestrator::RunDestroy()
+{
+	IOnlineSessionPtr PinnedSession = SessionInterface.Pin();
+	if (!PinnedSession.IsValid())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FSessionOrchestrator: SessionInterface is invalid!"));
+		Complete(false);
+		return;
+	}
+
+	if (!PinnedSession->GetNamedSession(FPNetworkingModule::GetSessionName()))
+	{
+		Transition(ELocalSessionState::SESSION_INVALID);
+		Complete(true);
+		return;
+	}
+
+	StartDestroy();
+}
+
+void FSessionOrchestrator::RunUpdate()
+{
+	IOnlineSessionPtr PinnedSession = SessionInterface.Pin();
+	FOnlineSessionSettings* SessionSettings = PinnedSession.IsValid() ? PinnedSession->GetSessionSettings(FPNetworkingModule::GetSessionName()) : nullptr;
+	if (!SessionSettings)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FSessionOrchestrator: SessionSettings is null!"));
+		Complete(false);
+		return;
+	}
+
+	// Only fields changed by requests, and still different from the session, are written.
+	const uint8 ChangedFields = CopyUpdateFields(Running->UpdateParameters, Running->UpdateMask, *SessionSettings);
+	if (ChangedFields == 0)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("FSessionOrchestrator: Update %d changes nothing, not sent"), Running->Requests[0].OperationID);
+		Complete(true);
+		return;
+	}
+
+	UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("FSessionOrchestrator: Update %d sent with fields 0x%02x for %d requests"), Running->Requests[0].OperationID, ChangedFields, Running->Requests.Num());
+
+	const TSharedPtr<FOperation> Operation = Running;
+	Phase = EPhase::UPDATING;
+
+	if (!PinnedSession->UpdateSession(FPNetworkingModule::GetSessionName(), *SessionSettings) && Running == Operation && Phase == EPhase::UPDATING)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FSessionOrchestrator: UpdateSession request failed!"));
+		Complete(false);
+	}
+}
+
+void FSessionOrchestrator::RunQuit()
+{
+	if (FPNetworkingModule::GetLocalSessionCurrentState() != ELocalSessionState::SESSION_VALID)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FSessionOrchestrator: Quit without a valid session!"));
+		Complete(false);
+		return;
+	}
+
+	UWorld* World = GEngine && GEngine->GetWorldContexts().Num() > 0 ? GEngine->GetWorldContexts()[0].World() : nullptr;
+	APlayerController* PlayerController = World ? UGameplayStatics::GetPlayerController(World, 0) : nullptr;
+	if (!PlayerController)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FSessionOrchestrator: PlayerController is null!"));
+		Complete(false);
+		return;
+	}
+
+	PlayerController->ClientTravel(Running->MapPath, ETravelType::TRAVEL_Absolute);
+
+	IOnlineSessionPtr PinnedSession = SessionInterface.Pin();
+	if (!PinnedSession.IsValid() || !PinnedSession->GetNamedSession(FPNetworkingModule::GetSessionName()))
+	{
+		Transition(ELocalSessionState::SESSION_INVALID);
+		Complete(true);
+		return;
+	}
+
+	StartDestroy();
+}
+
+void FSessionOrchestrator::RunInvite()
+{
+	IOnlineSessionPtr PinnedSession = SessionInterface.Pin();
+	if (FPNetworkingModule::GetLocalSessionCurrentState() != ELocalSessionState::SESSION_VALID || !PinnedSession.IsValid() ||
+		!PinnedSession->GetNamedSession(FPNetworkingModule::GetSessionName()) || !Running->FriendNetID.IsValid())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FSessionOrchestrator: Invite without a valid session!"));
+		Complete(false);
+		return;
+	}
+
+	Complete(PinnedSession->SendSessionInviteToFriend(0, FPNetworkingModule::GetSessionName(), *Running->FriendNetID));
+}
+
+bool FSessionOrchestrator::IsRelayNetworkSettled() const
+{
+	TSharedPtr<FRelayNetwork> PinnedRelayNetwork = RelayNetwork.Pin();
+	return !PinnedRelayNetwork.IsValid() || PinnedRelayNetwork->IsSettled();
+}
+
+void FSessionOrchestrator::StartCreate()
+{
+	IOnlineSessionPtr PinnedSession = SessionInterface.Pin();
+	if (!PinnedSession.IsValid())
+	{
+		Transition(ELocalSessionState::SESSION_INVALID);
+		Complete(false);
+		return;
+	}
+
+	// Host location, used by clients to rank sessions by ping. Relay network has been waited, so it is known unless unavailable.
+	FString PingLocation;
+	if (FPingLocation::GetLocalLocationString(PingLocation))
+	{
+		Running->Settings.Set(FName(TEXT(SESSION_PING_LOCATION_KEY)), PingLocation, EOnlineDataAdvertisementType::ViaOnlineService);
+	}
+
+	const TSharedPtr<FOperation> Operation = Running;
+	Transition(ELocalSessionState::SESSION_PENDING);
+	Phase = EPhase::CREATING;
+
+	if (!PinnedSession->CreateSession(0, FPNetworkingModule::GetSessionName(), Operation->Settings) && Running == Operation && Phase == EPhase::CREATING)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FSessionOrchestrator: CreateSession request failed!"));
+		Transition(ELocalSessionState::SESSION_INVALID);
+		Complete(false);
+	}
+}
+
+void FSessionOrchestrator::StartJoin()
+{
+	IOnlineSessionPtr PinnedSession = SessionInterface.Pin();
+	if (!PinnedSession.IsValid())
+	{
+		Transition(ELocalSessionState::SESSION_INVALID);
+		Complete(false);
+		return;
+	}
+
+	const TSharedPtr<FOperation> Operation = Running;
+	Transition(ELocalSessionState::SESSION_PENDING);
+	Phase = EPhase::JOINING;
+
+	if (!PinnedSession->JoinSession(0, FPNetworkingModule::GetSessionName(), Operation->SearchResult) && Running == Operation && Phase == EPhase::JOINING)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FSessionOrchestrator: JoinSession request failed!"));
+		Transition(ELocalSessionState::SESSION_INVALID);
+		Complete(false);
+	}
+}
+
+void FSessionOrchestrator::StartDestroy()
+{
+	IOnlineSessionPtr PinnedSession = SessionInterface.Pin();
+	if (!PinnedSession.IsValid())
+	{
+		Transition(ELocalSessionState::SESSION_INVALID);
+		Complete(false);
+		return;
+	}
+
+	const TSharedPtr<FOperation> Operation = Running;
+	Transition(ELocalSessionState::SESSION_DESTROYING);
+	Phase = EPhase::DESTROYING;
+
+	if (!PinnedSession->DestroySession(FPNetworkingModule::GetSessionName()) && Running == Operation && Phase == EPhase::DESTROYING)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FSessionOrchestrator: DestroySession request failed!"));
+		Transition(ELocalSessionState::SESSION_INVALID);
+		Complete(false);
+	}
+}
+
+void FSessionOrchestrator::Complete(const bool bWasSuccessful)
+{
+	if (!Running.IsValid())
+	{
+		return;
+	}
+
+	const TSharedRef<FOperation> Operation = Running.ToSharedRef();
+	Running.Reset();
+	Phase = EPhase::IDLE;
+
+	const double RunSeconds = FPlatformTime::Seconds() - Operation->StartTime;
+
+	UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("FSessionOrchestrator: Operation %d (%s) %s in %.3fs, %d requests"),
+		Operation->Requests[0].OperationID, *UEnum::GetValueAsString(Operation->Type), bWasSuccessful ? TEXT("succeeded") : TEXT("failed"), RunSeconds, Operation->Requests.Num());
+
+	for (FRequest& Request : Operation->Requests)
+	{
+		FSessionOperationResult Result;
+		Result.OperationID = Request.OperationID;
+		Result.Type = Request.Type;
+		Result.bWasSuccessful = bWasSuccessful;
+		Result.QueuedSeconds = static_cast<float>(Operation->StartTime - Request.EnqueueTime);
+		Result.RunSeconds = static_cast<float>(RunSeconds);
+
+		Request.Callback.ExecuteIfBound(Result);
+		OnOperationCompleted.Broadcast(Result);
+	}
+
+	StartNext();
+}
+
+void FSessionOrchestrator::TearDownAbandoned()
+{
+	IOnlineSessionPtr PinnedSession = SessionInterface.Pin();
+	if (!PinnedSession.IsValid() || !PinnedSession->GetNamedSession(FPNetworkingModule::GetSessionName()))
+	{
+		Transition(ELocalSessionState::SESSION_INVALID);
+		ResumeAfterAbandoned();
+		return;
+	}
+
+	UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FSessionOrchestrator: Tearing down abandoned session!"));
+
+	Transition(ELocalSessionState::SESSION_DESTROYING);
+	AbandonedPhase = EPhase::DESTROYING;
+	AbandonTime = FPlatformTime::Seconds();
+
+	if (!PinnedSession->DestroySession(FPNetworkingModule::GetSessionName()) && AbandonedPhase == EPhase::DESTROYING)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FSessionOrchestrator: DestroySession request failed!"));
+		Transition(ELocalSessionState::SESSION_INVALID);
+		ResumeAfterAbandoned();
+	}
+}
+
+void FSessionOrchestrator::ResumeAfterAbandoned()
+{
+	AbandonedPhase = EPhase::IDLE;
+	StartNext();
+}
+
+bool FSessionOrchestrator::Transition(const ELocalSessionState NewState)
+{
+	const ELocalSessionState CurrentState = FPNetworkingModule::GetLocalSessionCurrentState();
+	if (CurrentState == NewState)
+	{
+		return true;
+	}
+
+	if (!IsTransitionAllowed(CurrentState, NewState))
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FSessionOrchestrator: Transition %s -> %s not allowed!"), GetStateName(CurrentState), GetStateName(NewState));
+		return false;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	const FSessionTransition Record = { CurrentState, NewState, Running.IsValid() ? Running->Requests[0].OperationID : 0, Now - StateEnterTime };
+
+	if (Transitions.Num() < SESSION_TRANSITION_HISTORY)
+	{
+		Transitions.Add(Record);
+	}
+	else
+	{
+		Transitions[NextTransition] = Record;
+	}
+	NextTransition = (NextTransition + 1) % SESSION_TRANSITION_HISTORY;
+
+	UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("FSessionOrchestrator: %s -> %s after %.3fs (operation %d)"),
+		GetStateName(CurrentState), GetStateName(NewState), Record.Seconds, Record.OperationID);
+
+	FPNetworkingModule::SetLocalSessionCurrentState(NewState);
+	StateEnterTime = Now;
+	return true;
+}
+
+bool FSessionOrchestrator::IsTransitionAllowed(const ELocalSessionState From, const ELocalSessionState To)
+{
+	// Edges of the state graph: one bit per reachable state, indexed by ELocalSessionState.
+	static const uint8 AllowedTargets[] =
+	{
+		/* SESSION_PENDING */		(1 << SESSION_DESTROYING) | (1 << SESSION_VALID) | (1 << SESSION_INVALID),
+		/* SESSION_DESTROYING */	(1 << SESSION_PENDING) | (1 << SESSION_INVALID),
+		/* SESSION_VALID */			(1 << SESSION_PENDING) | (1 << SESSION_DESTROYING) | (1 << SESSION_INVALID),
+		/* SESSION_INVALID */		(1 << SESSION_PENDING) | (1 << SESSION_DESTROYING)
+	};
+
+	return From < UE_ARRAY_COUNT(AllowedTargets) && (AllowedTargets[From] & (1 << To)) != 0;
+}
+
+const TCHAR* FSessionOrchestrator::GetStateName(const ELocalSessionState State)
+{
+	switch (State)
+	{
+	case SESSION_PENDING:		return TEXT("Pending");
+	case SESSION_DESTROYING:	return TEXT("Destroying");
+	case SESSION_VALID:			return TEXT("Valid");
+	case SESSION_INVALID:		return TEXT("Invalid");
+	default:					return TEXT("Unknown");
+	}
+}
+
+bool FSessionOrchestrator::Tick(float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	if (AbandonedPhase != EPhase::IDLE && Now - AbandonTime >= SESSION_OPERATION_TIMEOUT)
+	{
+		// An update never answered leaves the session as it was. A create/join may have made one: it is torn down.
+		if (AbandonedPhase == EPhase::UPDATING)
+		{
+			UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FSessionOrchestrator: Update never answered, resuming queue!"));
+			ResumeAfterAbandoned();
+		}
+		else if (AbandonedPhase == EPhase::DESTROYING)
+		{
+			UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FSessionOrchestrator: Session tear down never answered, resuming queue!"));
+			Transition(ELocalSessionState::SESSION_INVALID);
+			ResumeAfterAbandoned();
+		}
+		else
+		{
+			TearDownAbandoned();
+		}
+		return true;
+	}
+
+	if (!Running.IsValid() || Now - Running->StartTime < SESSION_OPERATION_TIMEOUT)
+	{
+		return true;
+	}
+
+	UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FSessionOrchestrator: Operation %d (%s) timed out!"), Running->Requests[0].OperationID, *UEnum::GetValueAsString(Running->Type));
+
+	// OSS call still in flight: local state is left as it is, and its late answer is waited before the next operation.
+	if (Phase != EPhase::IDLE && Phase != EPhase::WAITING_RELAY)
+	{
+		AbandonedPhase = Phase;
+		AbandonTime = Now;
+	}
+
+	Complete(false);
+	return true;
+}
+
+void FSessionOrchestrator::OnCreateSessionComplete(FName SessionName, bool bWasSuccessful)
+{
+	if (SessionName == FPNetworkingModule::GetSessionName() && AbandonedPhase == EPhase::CREATING)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FSessionOrchestrator: Late create answer of a timed out operation"));
+		if (bWasSuccessful)
+		{
+			TearDownAbandoned();
+			return;
+		}
+
+		Transition(ELocalSessionState::SESSION_INVALID);
+		ResumeAfterAbandoned();
+		return;
+	}
+
+	if (SessionName != FPNetworkingModule::GetSessionName() || Phase != EPhase::CREATING)
+	{
+		return;
+	}
+
+	if (!bWasSuccessful)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FSessionOrchestrator: Creating Session error!"));
+		Transition(ELocalSessionState::SESSION_INVALID);
+		Complete(false);
+		return;
+	}
+
+	UWorld* World = GEngine && GEngine->GetWorldContexts().Num() > 0 ? GEngine->GetWorldContexts()[0].World() : nullptr;
+	if (!World || !World->ServerTravel(Running->MapPath + TEXT("?listen")))
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FSessionOrchestrator: Server Travel Error!"));
+		Transition(ELocalSessionState::SESSION_INVALID);
+		Complete(false);
+		return;
+	}
+
+	UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FSessionOrchestrator: Server Travel Complete!"));
+	Transition(ELocalSessionState::SESSION_VALID);
+	Complete(true);
+}
+
+void FSessionOrchestrator::OnDestroySessionComplete(FName SessionName, bool bWasSuccessful)
+{
+	if (SessionName != FPNetworkingModule::GetSessionName())
+	{
+		return;
+	}
+
+	if (AbandonedPhase == EPhase::DESTROYING_OLD || AbandonedPhase == EPhase::DESTROYING)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FSessionOrchestrator: Late destroy answer of a timed out operation"));
+		Transition(ELocalSessionState::SESSION_INVALID);
+		ResumeAfterAbandoned();
+		return;
+	}
+
+	if (Phase == EPhase::DESTROYING_OLD)
+	{
+		if (!bWasSuccessful)
+		{
+			UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FSessionOrchestrator: Old session not destroyed!"));
+			Transition(ELocalSessionState::SESSION_INVALID);
+			Complete(false);
+			return;
+		}
+
+		Running->Type == ESessionOperationType::OPERATION_CREATE ? StartCreate() : StartJoin();
+	}
+	else if (Phase == EPhase::DESTROYING)
+	{
+		if (bWasSuccessful)
+		{
+			UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FSessionOrchestrator: Session %s destroyed"), *SessionName.ToString());
+		}
+		else
+		{
+			UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FSessionOrchestrator: Session %s not destroyed!"), *SessionName.ToString());
+		}
+
+		Transition(ELocalSessionState::SESSION_INVALID);
+		Complete(bWasSuccessful);
+	}
+}
+
+void FSessionOrchestrator::OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result)
+{
+	if (SessionName == FPNetworkingModule::GetSessionName() && AbandonedPhase == EPhase::JOINING)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FSessionOrchestrator: Late join answer of a timed out operation"));
+		if (Result == EOnJoinSessionCompleteResult::Success)
+		{
+			TearDownAbandoned();
+			return;
+		}
+
+		Transition(ELocalSessionState::SESSION_INVALID);
+		ResumeAfterAbandoned();
+		return;
+	}
+
+	if (SessionName != FPNetworkingModule::GetSessionName() || Phase != EPhase::JOINING)
+	{
+		return;
+	}
+
+	if (Result != EOnJoinSessionCompleteResult::Success)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FSessionOrchestrator: Join Session failed!"));
+		Transition(ELocalSessionState::SESSION_INVALID);
+		Complete(false);
+		return;
+	}
+
+	IOnlineSessionPtr PinnedSession = SessionInterface.Pin();
+	FString ConnectInfo;
+	if (!PinnedSession.IsValid() || !PinnedSession->GetResolvedConnectString(SessionName, ConnectInfo))
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FSessionOrchestrator: Failed to get resolved connect string!"));
+		Transition(ELocalSessionState::SESSION_INVALID);
+		Complete(false);
+		return;
+	}
+
+	UWorld* World = GEngine && GEngine->GetWorldContexts().Num() > 0 ? GEngine->GetWorldContexts()[0].World() : nullptr;
+	APlayerController* PlayerController = World ? UGameplayStatics::GetPlayerController(World, 0) : nullptr;
+	if (!PlayerController)
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FSessionOrchestrator: PlayerController is null!"));
+		Transition(ELocalSessionState::SESSION_INVALID);
+		Complete(false);
+		return;
+	}
+
+	Transition(ELocalSessionState::SESSION_VALID);
+	PlayerController->ClientTravel(ConnectInfo, ETravelType::TRAVEL_Absolute);
+
+	UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FSessionOrchestrator: Client Travel to: %s"), *ConnectInfo);
+	Complete(true);
+}
+
+void FSessionOrchestrator::OnUpdateSessionComplete(FName SessionName, bool bWasSuccessful)
+{
+	if (SessionName == FPNetworkingModule::GetSessionName() && AbandonedPhase == EPhase::UPDATING)
+	{
+		ResumeAfterAbandoned();
+		return;
+	}
+
+	if (SessionName != FPNetworkingModule::GetSessionName() || Phase != EPhase::UPDATING)
+	{
+		return;
+	}
+
+	Complete(bWasSuccessful);
+}
+
+void FSessionOrchestrator::OnRelayNetworkStateChanged(ERelayNetworkState State)
+{
+	if (Phase != EPhase::WAITING_RELAY || !Running.IsValid() || State == ERelayNetworkState::RELAY_WARMING)
+	{
+		return;
+	}
+
+	// Unavailable relays are not waited anymore: the net driver handles them as before.
+	UE_LOG(LogSteamNetworkingPlugin, Display, TEXT("FSessionOrchestrator: Operation %d resumed after %.3fs, relay network %s"),
+		Running->Requests[0].OperationID, FPlatformTime::Seconds() - Running->StartTime, *UEnum::GetValueAsString(State));
+
+	Phase = EPhase::IDLE;
+	RunCreateOrJoin();
+}
+
+bool FSessionOrchestrator::OnUpdateWindowElapsed(float DeltaTime)
+{
+	UpdateWindowHandle.Reset();
+	StartNext();
+
+	// One shot: StartNext adds it again if the window is not over yet.
+	return false;
+}
@@ -16,11 +16,88 @@ SteamAPICallbackManager::~SteamAPICallbackManager()
 // No double declaration + implementation to work as STEAM_MACRO callback.
 void SteamAPICallbackManager::OnImageAvatarLoadedCallback(AvatarImageLoaded_t* callback)
 {
-	// If something is bound to the delegates, call it. 
-	// These delegates are triggered when STEAM_API is triggered by AvatarImageLoaded callback.
+	if (!callback)
+	{
+		return;
+	}
 
-	OnAvatarReadyDelegateLocalUser.ExecuteIfBound(callback);
-	OnAvatarReadyDelegateFriendList.ExecuteIfBound(callback);
-	OnAvatarReadyFriendListData.ExecuteIfBound(callback);
-	OnAvatarReadyFriendRequested.ExecuteIfBound(callback);
+	// Only waiters of this SteamID are woken up. They are removed before being fired, so they can register again.
+	TArray<FOnAvatarReadyFromSteamAPI> Waiters;
+	{
+		FScopeLock Lock(&AvatarWaitersLock);
+		AvatarWaiters.RemoveAndCopyValue(callback->m_steamID.ConvertToUint64(), Waiters);
+	}
+
+	for (FOnAvatarReadyFromSteamAPI& Waiter : Waiters)
+	{
+		Waiter.ExecuteIfBound(callback);
+	}
+}
+
+void SteamAPICallbackManager::OnPersonaStateChangeCallback(PersonaStateChange_t* callback)
+{
+	if (!callback)
+	{
+		return;
+	}
+
+	OnPersonaStateChanged.Broadcast(callback->m_ulSteamID, callback->m_nChangeFlags);
+}
+
+void SteamAPICallbackManager::OnFriendRichPresenceUpdateCallback(FriendRichPresenceUpdate_t* callback)
+{
+	if (!callback)
+	{
+		return;
+	}
+
+	OnRichPresenceUpdated.Broadcast(callback->m_steamIDFriend.ConvertToUint64());
+}
+
+void SteamAPICallbackManager::OnLobbyDataUpdateCallback(LobbyDataUpdate_t* callback)
+{
+	// Member metadata changes are not used: only lobby ones are forwarded.
+	if (!callback || callback->m_ulSteamIDLobby != callback->m_ulSteamIDMember)
+	{
+		return;
+	}
+
+	OnLobbyDataUpdated.Broadcast(callback->m_ulSteamIDLobby, callback->m_bSuccess != 0);
+}
+
+bool SteamAPICallbackManager::AddAvatarWaiter(const CSteamID SteamID, FOnAvatarReadyFromSteamAPI Waiter)
+{
+	FScopeLock Lock(&AvatarWaitersLock);
+
+	TArray<FOnAvatarReadyFromSteamAPI>& Waiters = AvatarWaiters.FindOrAdd(SteamID.ConvertToUint64());
+	Waiters.RemoveAll([](const FOnAvatarReadyFromSteamAPI& OldWaiter) { return !OldWaiter.IsBound(); });
+	Waiters.Add(MoveTemp(Waiter));
+
+	return Waiters.Num() == 1;
+}
+
+void SteamAPICallbackManager::PruneAvatarWaiters()
+{
+	FScopeLock Lock(&AvatarWaitersLock);
+
+	for (auto It = AvatarWaiters.CreateIterator(); It; ++It)
+	{
+		It.Value().RemoveAll([](const FOnAvatarReadyFromSteamAPI& Waiter) { return !Waiter.IsBound(); });
+		if (It.Value().Num() == 0)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+int32 SteamAPICallbackManager::GetNumAvatarWaiters() const
+{
+	FScopeLock Lock(&AvatarWaitersLock);
+
+	int32 NumWaiters = 0;
+	for (const TPair<uint64, TArray<FOnAvatarReadyFromSteamAPI>>& Pair : AvatarWaiters)
+	{
+		NumWaiters += Pair.Value.Num();
+	}
+	return NumWaiters;
 }
@@ -0,0 +1,292 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#include "UserDirectory.h"
+#include "PNetworking.h"
+
+FUserDirectory::FUserDirectory()
+	: NumEntries(0)
+	, DirtySteamIDs(MakeShared<FDirtyQueue, ESPMode::ThreadSafe>())
+{
+	Keys.SetNumZeroed(USER_DIRECTORY_INITIAL_CAPACITY);
+	Values.SetNum(USER_DIRECTORY_INITIAL_CAPACITY);
+}
+
+FUserDirectory::~FUserDirectory()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+
+	TSharedPtr<SteamAPICallbackManager> PinnedManager = SteamAPIManager.Pin();
+	if (PinnedManager.IsValid())
+	{
+		PinnedManager->OnPersonaStateChanged.Remove(PersonaStateChangedHandle);
+	}
+}
+
+bool FUserDirectory::Initialize()
+{
+	check(IsInGameThread());
+
+	TSharedPtr<SteamAPICallbackManager> PinnedManager = FPNetworkingModule::GetSteamAPIManager();
+	if (!SteamFriends() || !PinnedManager.IsValid())
+	{
+		UE_LOG(LogSteamNetworkingPlugin, Error, TEXT("FUserDirectory: SteamFriendsInterface steamworks_sdk not valid!"));
+		return false;
+	}
+
+	SteamAPIManager = PinnedManager;
+	PersonaStateChangedHandle = PinnedManager->OnPersonaStateChanged.AddLambda([DirtySteamIDs = DirtySteamIDs](uint64 SteamID, int32 ChangeFlags)
+		{
+			DirtySteamIDs->Enqueue(SteamID);
+		}
+	);
+
+	TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FUserDirectory::Tick));
+	return true;
+}
+
+void FUserDirectory::Resolve(TConstArrayView<uint64> SteamIDs, FOnUserDirectoryBatchResolved Callback)
+{
+	check(IsInGameThread());
+
+	TSharedRef<FBatch> Batch = MakeShared<FBatch>();
+	Batch->SteamIDs = SteamIDs;
+	Batch->NumPending = 0;
+	Batch->Callback = MoveTemp(Callback);
+
+	for (const uint64 SteamID : SteamIDs)
+	{
+		if (SteamID == 0)
+		{
+			continue;
+		}
+
+		FUserDirectoryEntry& Entry = FindOrAdd(SteamID);
+		if (Entry.State == EUserFetchState::READY)
+		{
+			continue;
+		}
+
+		// Same user twice in the batch: wait it once.
+		TArray<TSharedRef<FBatch>, TInlineAllocator<1>>& SteamIDWaiters = Waiters.FindOrAdd(SteamID);
+		if (SteamIDWaiters.Num() > 0 && SteamIDWaiters.Last() == Batch)
+		{
+			continue;
+		}
+
+		SteamIDWaiters.Add(Batch);
+		Batch->NumPending++;
+
+		// Already queued or in flight for another batch: no new request.
+		if (Entry.State != EUserFetchState::PENDING)
+		{
+			Entry.State = EUserFetchState::PENDING;
+			PendingRequests.Add(SteamID);
+		}
+	}
+
+	if (Batch->NumPending == 0)
+	{
+		Batch->Callback.ExecuteIfBound(Batch->SteamIDs);
+	}
+}
+
+const FUserDirectoryEntry* FUserDirectory::Find(const uint64 SteamID) const
+{
+	if (SteamID == 0)
+	{
+		return nullptr;
+	}
+
+	const int32 Slot = FindSlot(SteamID);
+	return Keys[Slot] == SteamID ? &Values[Slot] : nullptr;
+}
+
+int32 FUserDirectory::Num() const
+{
+	return NumEntries;
+}
+
+int32 FUserDirectory::GetNumPendingRequests() const
+{
+	return PendingRequests.Num() + InFlightSteamIDs.Num();
+}
+
+bool FUserDirectory::Tick(float DeltaTime)
+{
+	// Answers: pending users are completed, ready ones are read again (name or avatar changed).
+	if (!DirtySteamIDs->IsEmpty())
+	{
+		TSet<uint64> ChangedSteamIDs;
+		uint64 SteamID = 0;
+		while (DirtySteamIDs->Dequeue(SteamID))
+		{
+			ChangedSteamIDs.Add(SteamID);
+		}
+
+		for (const uint64 ChangedSteamID : ChangedSteamIDs)
+		{
+			const FUserDirectoryEntry* Entry = Find(ChangedSteamID);
+			if (Entry && Entry->State != EUserFetchState::UNKNOWN)
+			{
+				Complete(ChangedSteamID, EUserFetchState::READY);
+			}
+		}
+	}
+
+	const double Now = FPlatformTime::Seconds();
+
+	if (InFlightSteamIDs.Num() > 0)
+	{
+		TArray<uint64, TInlineAllocator<16>> TimedOutSteamIDs;
+		for (const uint64 SteamID : InFlightSteamIDs)
+		{
+			if (Now - Find(SteamID)->RequestTime > USER_DIRECTORY_REQUEST_TIMEOUT)
+			{
+				TimedOutSteamIDs.Add(SteamID);
+			}
+		}
+
+		for (const uint64 SteamID : TimedOutSteamIDs)
+		{
+			UE_LOG(LogSteamNetworkingPlugin, Warning, TEXT("FUserDirectory: RequestUserInformation timed out for %llu!"), SteamID);
+			Complete(SteamID, EUserFetchState::FAILED);
+		}
+	}
+
+	ISteamFriends* SteamFriendsInterface = SteamFriends();
+	if (PendingRequests.Num() == 0 || !SteamFriendsInterface)
+	{
+		return true;
+	}
+
+	const int32 NumToSend = FMath::Min(PendingRequests.Num(), USER_DIRECTORY_REQUESTS_PER_TICK);
+	TArray<uint64, TInlineAllocator<USER_DIRECTORY_REQUESTS_PER_TICK>> SentSteamIDs(PendingRequests.GetData(), NumToSend);
+	PendingRequests.RemoveAt(0, NumToSend, EAllowShrinking::No);
+
+	for (const uint64 SteamID : SentSteamIDs)
+	{
+		// Completed by a PersonaStateChange_t while still queued: nothing to ask.
+		if (Find(SteamID)->State != EUserFetchState::PENDING)
+		{
+			continue;
+		}
+
+		// False means persona is already on SteamAPI side: no PersonaStateChange_t will come.
+		if (SteamFriendsInterface->RequestUserInformation(CSteamID(SteamID), false))
+		{
+			FindOrAdd(SteamID).RequestTime = Now;
+			InFlightSteamIDs.Add(SteamID);
+		}
+		else
+		{
+			Complete(SteamID, EUserFetchState::READY);
+		}
+	}
+
+	return true;
+}
+
+int32 FUserDirectory::FindSlot(const uint64 SteamID) const
+{
+	const int32 Mask = Keys.Num() - 1;
+	int32 Slot = HashSteamID(SteamID) & Mask;
+
+	// Load factor is kept under 1/2: an empty slot is always found.
+	while (Keys[Slot] != 0 && Keys[Slot] != SteamID)
+	{
+		Slot = (Slot + 1) & Mask;
+	}
+
+	return Slot;
+}
+
+FUserDirectoryEntry& FUserDirectory::FindOrAdd(const uint64 SteamID)
+{
+	int32 Slot = FindSlot(SteamID);
+	if (Keys[Slot] == SteamID)
+	{
+		return Values[Slot];
+	}
+
+	if ((NumEntries + 1) * 2 > Keys.Num())
+	{
+		Grow();
+		Slot = FindSlot(SteamID);
+	}
+
+	Keys[Slot] = SteamID;
+	Values[Slot] = FUserDirectoryEntry();
+	NumEntries++;
+	return Values[Slot];
+}
+
+void FUserDirectory::Grow()
+{
+	TArray<uint64> OldKeys = MoveTemp(Keys);
+	TArray<FUserDirectoryEntry> OldValues = MoveTemp(Values);
+
+	Keys.SetNumZeroed(OldKeys.Num() * 2);
+	Values.SetNum(OldKeys.Num() * 2);
+
+	for (int32 OldSlot = 0; OldSlot < OldKeys.Num(); OldSlot++)
+	{
+		if (OldKeys[OldSlot] != 0)
+		{
+			const int32 Slot = FindSlot(OldKeys[OldSlot]);
+			Keys[Slot] = OldKeys[OldSlot];
+			Values[Slot] = MoveTemp(OldValues[OldSlot]);
+		}
+	}
+}
+
+void FUserDirectory::Complete(const uint64 SteamID, const EUserFetchState NewState)
+{
+	ISteamFriends* SteamFriendsInterface = SteamFriends();
+	if (!SteamFriendsInterface)
+	{
+		return;
+	}
+
+	const CSteamID UserSteamID(SteamID);
+	const FString UserName = FString(UTF8_TO_TCHAR(SteamFriendsInterface->GetFriendPersonaName(UserSteamID)));
+	const int32 AvatarHandle = SteamFriendsInterface->GetSmallFriendAvatar(UserSteamID);
+
+	FUserDirectoryEntry& Entry = FindOrAdd(SteamID);
+	const bool bHasChanged = Entry.State != NewState || Entry.AvatarHandle != AvatarHandle || !Entry.UserName.Equals(UserName, ESearchCase::CaseSensitive);
+
+	Entry.UserName = UserName;
+	Entry.AvatarHandle = AvatarHandle;
+	Entry.State = NewState;
+	InFlightSteamIDs.Remove(SteamID);
+
+	TArray<TSharedRef<FBatch>, TInlineAllocator<1>> SteamIDWaiters;
+	if (Waiters.RemoveAndCopyValue(SteamID, SteamIDWaiters))
+	{
+		for (const TSharedRef<FBatch>& Batch : SteamIDWaiters)
+		{
+			if (--Batch->NumPending == 0)
+			{
+				Batch->Callback.ExecuteIfBound(Batch->SteamIDs);
+			}
+		}
+	}
+
+	if (bHasChanged)
+	{
+		OnEntryChanged.Broadcast(SteamID);
+	}
+}
+
+uint32 FUserDirectory::HashSteamID(const uint64 SteamID)
+{
+	// SteamIDs of individual accounts share their high bits: mix them all (MurmurHash3 finalizer).
+	uint64 Hash = SteamID;
+	Hash ^= Hash >> 33;
+	Hash *= 0xff51afd7ed558ccdULL;
+	Hash ^= Hash >> 33;
+	Hash *= 0xc4ceb9fe1a85ec53ULL;
+	Hash ^= Hash >> 33;
+	return static_cast<uint32>(Hash);
+}
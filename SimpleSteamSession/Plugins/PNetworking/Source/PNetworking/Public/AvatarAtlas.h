@@ -0,0 +1,147 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/GCObject.h"
+#include "AvatarAtlas.generated.h"
+
+// Size (pixels) of every atlas page texture.
+#define AVATAR_ATLAS_PAGE_SIZE 2048
+
+// Size (pixels) of an atlas cell. Large Steam avatars are 184x184.
+#define AVATAR_ATLAS_CELL_SIZE 184
+
+// Empty pixels between cells, to prevent bilinear filtering bleeding.
+#define AVATAR_ATLAS_CELL_PADDING 2
+
+// Max number of atlas pages. When full, least recently used avatars are evicted.
+#define AVATAR_ATLAS_MAX_PAGES 4
+
+class CSteamID;
+class UTexture2D;
+class FAvatarPipeline;
+struct FAvatarPixels;
+enum class EAvatarSize : uint8;
+
+// Location of an avatar inside an atlas page. It is made in order to use it in blueprints.
+USTRUCT(BlueprintType)
+struct FAvatarAtlasSlot
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "AvatarAtlas")
+	int32 SteamID; // Blueprint not supported "uint32", so we need to do some casts.
+
+	UPROPERTY(BlueprintReadOnly, Category = "AvatarAtlas", meta = (ToolTip = "Atlas texture containing the avatar. Null if avatar is not available."))
+	UTexture2D* AtlasPage;
+
+	UPROPERTY(BlueprintReadOnly, Category = "AvatarAtlas", meta = (ToolTip = "Top left UV of avatar inside AtlasPage."))
+	FVector2D UVMin;
+
+	UPROPERTY(BlueprintReadOnly, Category = "AvatarAtlas", meta = (ToolTip = "Bottom right UV of avatar inside AtlasPage."))
+	FVector2D UVMax;
+
+	FAvatarAtlasSlot() : SteamID(0), AtlasPage(nullptr), UVMin(FVector2D::ZeroVector), UVMax(FVector2D::ZeroVector) {}
+};
+
+// Delegate fired on GameThread when an avatar has been written in the atlas. Slot.AtlasPage is nullptr on error.
+DECLARE_DELEGATE_OneParam(FOnAvatarAtlasSlotReady, const FAvatarAtlasSlot&)
+
+// Delegate fired when avatars moved inside the atlas, so every slot previously given must be requested again.
+DECLARE_MULTICAST_DELEGATE(FOnAvatarAtlasRepackedNative)
+
+// Delegate fired when an avatar is evicted to make room: its cell now holds another avatar, so its slot must not be used anymore.
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnAvatarAtlasEvictedNative, uint64 /*SteamID*/)
+
+/*
+	Packs avatars into a few big textures (pages) divided in fixed size cells.
+	Pages are filled incrementally as avatar pixels arrive from the pipeline; when an avatar is removed
+	and remaining avatars fit in one page less, the emptiest page is moved into the others and released.
+	A friendlist of hundreds of avatars then costs a few UObjects and GPU allocations instead of one per friend.
+*/
+class PNETWORKING_API FAvatarAtlas : public FGCObject, public TSharedFromThis<FAvatarAtlas>
+{
+public:
+
+	FAvatarAtlas(TSharedPtr<FAvatarPipeline> InAvatarPipeline, const int32 InMaxPages = AVATAR_ATLAS_MAX_PAGES);
+	virtual ~FAvatarAtlas();
+
+	// Request the atlas slot of an already loaded avatar handle. A larger tier already in the atlas is reused.
+	// Returns true if OnReady was executed immediately (avatar already in the atlas).
+	bool RequestSlot(const CSteamID SteamID, const int32 AvatarHandle, const EAvatarSize AvatarSize, FOnAvatarAtlasSlotReady OnReady);
+
+	// Current slot of SteamID, if present in the atlas.
+	bool FindSlot(const uint64 SteamID, FAvatarAtlasSlot& OutSlot) const;
+
+	// Free SteamID cell, repacking pages if possible.
+	void Remove(const uint64 SteamID);
+
+	// Release every page.
+	void Empty();
+
+	int32 GetNumPages() const;
+	int32 GetNumEntries() const;
+
+	FOnAvatarAtlasRepackedNative OnRepacked;
+	FOnAvatarAtlasEvictedNative OnEvicted;
+
+	// FGCObject interface.
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	virtual FString GetReferencerName() const override;
+
+private:
+
+	struct FPage
+	{
+		UTexture2D* Texture; // nullptr if page is released.
+		TArray<uint64> Cells; // SteamID using each cell, 0 if free.
+		int32 NumUsed;
+	};
+
+	struct FEntry
+	{
+		int32 PageIndex;
+		int32 CellIndex;
+		int32 AvatarHandle;
+		EAvatarSize AvatarSize;
+		uint32 Width;
+		uint32 Height;
+		uint64 LastUsedFrame;
+		bool bIsUploaded;
+	};
+
+	// Find a free cell, creating a page or evicting the least recently used avatar if needed.
+	bool AllocateCell(int32& OutPageIndex, int32& OutCellIndex, const int32 ExcludedPageIndex = INDEX_NONE);
+
+	// Create the texture of a new (or released) page, cleared to transparent black.
+	int32 CreatePage();
+
+	// Ask the pipeline for pixels of entry avatar.
+	void RequestEntryPixels(const uint64 SteamID, const FEntry& Entry);
+
+	// Pipeline callback: copy pixels into entry cell.
+	void OnPixelsReady(FAvatarPixels& Pixels);
+
+	// Move avatars of the emptiest page into the others, if they fit.
+	void Repack();
+
+	void FreeCell(const int32 PageIndex, const int32 CellIndex);
+	void FireWaiting(const uint64 SteamID, const FAvatarAtlasSlot& Slot);
+	FAvatarAtlasSlot MakeSlot(const uint64 SteamID, const FEntry& Entry) const;
+
+	static int32 GetCellsPerRow();
+	static int32 GetCellsPerPage();
+
+	TSharedPtr<FAvatarPipeline> AvatarPipeline;
+
+	TArray<FPage> Pages;
+	TMap<uint64, FEntry> Entries;
+
+	// Callbacks waiting for an avatar to be written in the atlas, keyed by SteamID.
+	TMap<uint64, TArray<FOnAvatarAtlasSlotReady>> WaitingSlots;
+
+	int32 MaxPages;
+};
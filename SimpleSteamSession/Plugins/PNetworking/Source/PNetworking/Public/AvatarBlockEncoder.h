@@ -0,0 +1,60 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PixelFormat.h"
+
+/*
+	Minimal BC1 (DXT1) / BC3 (DXT5) encoder for avatars, made to run on worker threads.
+	It uses the bounding box (range fit) of each 4x4 block with a small inset: quality is close to
+	offline encoders on photos and drawings at avatar sizes, at a fraction of their cost.
+	Opaque avatars use BC1 (8 bytes per block), avatars with alpha use BC3 (16 bytes per block).
+	Bounding box and index search run on VectorRegister (SSE/NEON): a register holds a pixel for the box,
+	and one channel of 4 pixels for the projections. BC7 is not produced: its mode/partition search does not fit this budget.
+*/
+class PNETWORKING_API FAvatarBlockEncoder
+{
+public:
+
+	// True if every pixel alpha is 255.
+	static bool IsOpaque(const TArray<uint8>& RGBA);
+
+	// Encode RGBA pixels (Width and Height multiple of 4). Returns PF_Unknown if not encodable.
+	static EPixelFormat Encode(const TArray<uint8>& RGBA, const uint32 Width, const uint32 Height, TArray<uint8>& OutBlocks);
+
+	// Bytes of a 4x4 block for PF_DXT1/PF_DXT5.
+	static uint32 GetBlockBytes(const EPixelFormat PixelFormat);
+
+	// Bytes of a row of blocks, used as upload pitch.
+	static uint32 GetBlockRowPitch(const uint32 Width, const EPixelFormat PixelFormat);
+
+private:
+
+	// A 4x4 block loaded in registers.
+	struct FBlockPixels
+	{
+		// Channels of 4 pixels (a block row) per register.
+		VectorRegister4Float R[4];
+		VectorRegister4Float G[4];
+		VectorRegister4Float B[4];
+		VectorRegister4Float A[4];
+
+		// Per channel RGBA bounds of the 16 pixels.
+		int32 Min[4];
+		int32 Max[4];
+	};
+
+	// Load the 4x4 block at BlockX, BlockY of RGBA pixels.
+	static void LoadBlock(const uint8* RGBA, const uint32 Width, const uint32 BlockX, const uint32 BlockY, FBlockPixels& OutPixels);
+
+	// Encode color of a block into 8 bytes.
+	static void EncodeColorBlock(const FBlockPixels& Pixels, uint8* OutBlock);
+
+	// Encode alpha of a block into 8 bytes.
+	static void EncodeAlphaBlock(const FBlockPixels& Pixels, uint8* OutBlock);
+
+	static uint16 PackRGB565(const uint8 R, const uint8 G, const uint8 B);
+};
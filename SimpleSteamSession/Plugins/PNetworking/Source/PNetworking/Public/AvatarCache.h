@@ -0,0 +1,143 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/GCObject.h"
+#include "Containers/List.h"
+#include "AvatarCache.generated.h"
+
+// Default memory budget of avatar cache (RGBA bytes held by cached textures).
+#define AVATAR_CACHE_DEFAULT_BUDGET_BYTES (48 * 1024 * 1024)
+
+// Default max number of cached avatars, whatever their size.
+#define AVATAR_CACHE_DEFAULT_MAX_ENTRIES 512
+
+// Pixel size of Steam avatar tiers.
+#define AVATAR_SMALL_PIXEL_SIZE 32
+#define AVATAR_MEDIUM_PIXEL_SIZE 64
+#define AVATAR_LARGE_PIXEL_SIZE 184
+
+class UTexture2D;
+class FAvatarTexturePool;
+
+// Steam avatar tier to request. Auto picks the smallest tier covering the on-screen pixel size.
+UENUM(BlueprintType)
+enum class EAvatarSize : uint8
+{
+	AVATAR_SMALL UMETA(DisplayName = "Small (32x32)"),
+	AVATAR_MEDIUM UMETA(DisplayName = "Medium (64x64)"),
+	AVATAR_LARGE UMETA(DisplayName = "Large (184x184)"),
+	AVATAR_AUTO UMETA(DisplayName = "Auto (from pixel size)")
+};
+
+// Counters of avatar cache usage. It is made in order to use it in blueprints.
+USTRUCT(BlueprintType)
+struct FAvatarCacheStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "AvatarCache", meta = (ToolTip = "Requests served by an already cached texture."))
+	int32 Hits;
+
+	UPROPERTY(BlueprintReadOnly, Category = "AvatarCache", meta = (ToolTip = "Requests that needed a new texture from SteamAPI."))
+	int32 Misses;
+
+	UPROPERTY(BlueprintReadOnly, Category = "AvatarCache", meta = (ToolTip = "Textures removed because of budget or entries limit."))
+	int32 Evictions;
+
+	UPROPERTY(BlueprintReadOnly, Category = "AvatarCache", meta = (ToolTip = "Number of textures currently cached."))
+	int32 NumEntries;
+
+	UPROPERTY(BlueprintReadOnly, Category = "AvatarCache", meta = (ToolTip = "Bytes currently used by cached textures."))
+	int64 UsedBytes;
+
+	UPROPERTY(BlueprintReadOnly, Category = "AvatarCache", meta = (ToolTip = "Max bytes cached textures can use."))
+	int64 BudgetBytes;
+
+	FAvatarCacheStats() : Hits(0), Misses(0), Evictions(0), NumEntries(0), UsedBytes(0), BudgetBytes(0) {}
+};
+
+/*
+	Bounded LRU cache of avatar textures, keyed by 64 bit CSteamID.
+	Each entry remembers the Steam avatar handle it was built from: when Steam returns a different handle
+	for the same user (avatar changed), the old texture is dropped and a new one must be built.
+	A single texture per user is kept: a larger tier replaces a smaller one and then serves smaller requests too.
+	Textures are referenced through FGCObject, so they stay alive while cached even if no widget uses them.
+	When a texture pool is set, evicted and replaced textures are released to it: it reuses them once nothing else references them.
+*/
+class PNETWORKING_API FAvatarCache : public FGCObject
+{
+public:
+
+	FAvatarCache(const int64 InBudgetBytes = AVATAR_CACHE_DEFAULT_BUDGET_BYTES, const int32 InMaxEntries = AVATAR_CACHE_DEFAULT_MAX_ENTRIES);
+	virtual ~FAvatarCache();
+
+	// Get cached texture of SteamID if it is at least AvatarSize and matches AvatarHandle. Counts an hit or a miss.
+	UTexture2D* Find(const uint64 SteamID, const int32 AvatarHandle, const EAvatarSize AvatarSize);
+
+	// Add (or replace) the texture of SteamID, evicting least recently used entries if over budget.
+	// A smaller tier never replaces a larger texture that is still the live avatar.
+	void Add(const uint64 SteamID, const int32 AvatarHandle, const EAvatarSize AvatarSize, UTexture2D* Texture, const int64 SizeBytes);
+
+	// Bind the live handle to a texture served from disk, once its pixels are known to be unchanged. Counters are not touched.
+	UTexture2D* BindPersisted(const uint64 SteamID, const int32 AvatarHandle, const EAvatarSize AvatarSize);
+
+	// Remove SteamID texture, if cached.
+	void Remove(const uint64 SteamID);
+
+	// Remove every cached texture. Counters are kept.
+	void Empty();
+
+	// Change limits, evicting entries immediately if needed.
+	void SetBudget(const int64 NewBudgetBytes, const int32 NewMaxEntries);
+
+	// Pool receiving textures removed from the cache.
+	void SetTexturePool(TSharedPtr<FAvatarTexturePool> InTexturePool);
+
+	FAvatarCacheStats GetStats() const;
+
+	// FGCObject interface.
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	virtual FString GetReferencerName() const override;
+
+private:
+
+	typedef TDoubleLinkedList<uint64> FLruList;
+
+	struct FEntry
+	{
+		UTexture2D* Texture;
+		EAvatarSize AvatarSize;
+		int32 TierHandles[3]; // Avatar handle seen for each tier up to AvatarSize, 0 if not seen yet.
+		int64 SizeBytes;
+		FLruList::TDoubleLinkedListNode* LruNode; // Node inside LruOrder, head is the most recently used.
+	};
+
+	// Move entry at the head of LRU list.
+	void Touch(FEntry& Entry);
+
+	// True if the handle of entry tier is still the one SteamAPI returns for SteamID.
+	bool IsLive(const uint64 SteamID, const FEntry& Entry) const;
+
+	// Remove least recently used entries until limits are respected.
+	void EvictToBudget();
+
+	// Remove entry and its LRU node.
+	void RemoveEntry(const uint64 SteamID);
+
+	TMap<uint64, FEntry> Entries;
+	FLruList LruOrder;
+
+	TSharedPtr<FAvatarTexturePool> TexturePool;
+
+	int64 BudgetBytes;
+	int32 MaxEntries;
+	int64 UsedBytes;
+
+	int32 Hits;
+	int32 Misses;
+	int32 Evictions;
+};
@@ -0,0 +1,85 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Pack file, relative to project Saved directory.
+#define AVATAR_DISK_CACHE_FILE_NAME TEXT("PNetworking/Avatars.bin")
+
+// Max number of avatars kept in the pack. Avatars not used during the session are dropped first.
+#define AVATAR_DISK_CACHE_MAX_ENTRIES 1024
+
+// Pack header identifier and format version.
+#define AVATAR_DISK_CACHE_MAGIC 0x43564150
+#define AVATAR_DISK_CACHE_VERSION 1
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+struct FAvatarPixels;
+enum class EAvatarSize : uint8;
+
+/*
+	Avatars of previous sessions, persisted in a single pack file keyed by SteamID and pixels hash.
+	The pack is memory mapped on load: only the index is parsed, pixels are copied out when an avatar is served.
+	New or changed avatars are kept in memory and the whole pack is rewritten (compacted) on Save.
+	GameThread only.
+*/
+class PNETWORKING_API FAvatarDiskCache
+{
+public:
+
+	FAvatarDiskCache();
+	~FAvatarDiskCache();
+
+	// Map the pack file and read its index. Returns false if missing or invalid (cache starts empty).
+	bool Load();
+
+	// Write every used or new avatar to the pack file, replacing it.
+	bool Save();
+
+	// Copy persisted pixels of SteamID, if at least AvatarSize. AvatarHandle of OutPixels is 0.
+	bool FindPixels(const uint64 SteamID, const EAvatarSize AvatarSize, FAvatarPixels& OutPixels);
+
+	// True if persisted avatar of SteamID has the same tier and pixels hash.
+	bool HasSameHash(const uint64 SteamID, const EAvatarSize AvatarSize, const uint32 Hash) const;
+
+	// Pixels hash of persisted avatar of SteamID, if any.
+	bool FindHash(const uint64 SteamID, uint32& OutHash) const;
+
+	// Persist (or replace) SteamID avatar. Pixels are copied only if their hash changed, a smaller tier never replaces a larger one.
+	void Store(const FAvatarPixels& Pixels);
+
+	int32 GetNumEntries() const;
+
+private:
+
+	struct FRecord
+	{
+		uint32 Hash;
+		EAvatarSize AvatarSize;
+		uint32 Width;
+		uint32 Height;
+		int64 Offset; // Inside the mapped pack, valid if RGBA is empty.
+		int32 Size;
+		TArray<uint8> RGBA; // New pixels, not in the mapped pack yet.
+		bool bIsUsed; // Served or stored during this session.
+	};
+
+	// Pixels of a record, from memory or from the mapped pack.
+	const uint8* GetRecordData(const FRecord& Record) const;
+
+	// Release mapped region and file.
+	void Unmap();
+
+	FString GetPackPath() const;
+
+	TMap<uint64, FRecord> Records;
+
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
+	bool bIsDirty;
+};
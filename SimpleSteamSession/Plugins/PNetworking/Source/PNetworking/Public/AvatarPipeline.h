@@ -0,0 +1,135 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "Containers/Ticker.h"
+#include "PixelFormat.h"
+
+// Max number of avatar textures created and uploaded on GameThread in a single frame.
+#define AVATAR_PIPELINE_MAX_UPLOADS_PER_FRAME 4
+
+// Seconds between two checks of avatars served from disk and not revalidated with SteamAPI yet.
+#define AVATAR_PIPELINE_REVALIDATE_INTERVAL 1.f
+
+class CSteamID;
+class UTexture2D;
+class FAvatarCache;
+class FAvatarDiskCache;
+class FAvatarTexturePool;
+enum class EAvatarSize : uint8;
+
+// RGBA pixels of an avatar, fetched from SteamAPI by a worker.
+struct FAvatarPixels
+{
+	uint64 SteamID;
+	int32 AvatarHandle;
+	EAvatarSize AvatarSize;
+	uint32 Width;
+	uint32 Height;
+	TArray<uint8> RGBA; // Empty on error.
+	uint32 Hash; // CRC of RGBA, used to detect avatar changes across sessions.
+	TArray<uint8> EncodedData; // Block compressed pixels, uploaded instead of RGBA if not empty.
+	EPixelFormat EncodedFormat; // PF_DXT1/PF_DXT5, or PF_Unknown if not encoded.
+	uint32 RequestID; // 0 for texture requests, otherwise key of a pixels request.
+};
+
+// Delegate fired on GameThread when an avatar texture is ready. Texture is nullptr on error.
+DECLARE_DELEGATE_OneParam(FOnAvatarPipelineComplete, UTexture2D*)
+
+// Delegate fired on GameThread when avatar pixels are ready. Pixels can be moved by the receiver.
+DECLARE_DELEGATE_OneParam(FOnAvatarPixelsReady, FAvatarPixels&)
+
+// Delegate fired on GameThread when a new texture of a user avatar is added to the cache (first fetch or changed avatar).
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnAvatarTextureUpdated, uint64 /*SteamID*/, EAvatarSize, UTexture2D*)
+
+/*
+	Builds avatar textures without blocking GameThread.
+	1) GameThread: cache lookup, otherwise the request is sent to a worker task.
+	2) Worker: GetImageSize + GetImageRGBA into a buffer owned by the request.
+	3) GameThread (ticker): a limited number of textures per frame is created, pixels are sent
+	   to RenderThread with UpdateTextureRegions, so no BulkData lock/memcpy happens on GameThread.
+	Requests for the same avatar image already in flight are merged.
+	When compression is enabled, workers also encode pixels to BC1/BC3 (4-8x less GPU memory).
+	Avatars of previous sessions can be served from the disk cache before SteamAPI has them: they are
+	revalidated in background, and replaced only if pixels changed.
+*/
+class PNETWORKING_API FAvatarPipeline
+{
+public:
+
+	FAvatarPipeline(TSharedPtr<FAvatarCache> InAvatarCache, TSharedPtr<FAvatarDiskCache> InDiskCache = nullptr, TSharedPtr<FAvatarTexturePool> InTexturePool = nullptr);
+	~FAvatarPipeline();
+
+	// Steam avatar handle of SteamID for a tier (not Auto). 0 means error, -1 means SteamAPI is still downloading it.
+	static int32 GetAvatarHandle(const CSteamID SteamID, const EAvatarSize AvatarSize);
+
+	// Resolve Auto to the smallest tier covering PixelSize. Other tiers are returned unchanged.
+	static EAvatarSize ResolveAvatarSize(const EAvatarSize AvatarSize, const int32 PixelSize);
+
+	// Request the texture of an already loaded avatar handle.
+	// Returns true if OnComplete was executed immediately (texture already cached).
+	bool RequestTexture(const CSteamID SteamID, const int32 AvatarHandle, const EAvatarSize AvatarSize, FOnAvatarPipelineComplete OnComplete);
+
+	// Serve the avatar persisted by a previous session, when SteamAPI handle is not available yet.
+	// Returns true if OnComplete was executed immediately, false if nothing is persisted (OnComplete not executed).
+	bool RequestPersistedTexture(const CSteamID SteamID, const EAvatarSize AvatarSize, FOnAvatarPipelineComplete OnComplete);
+
+	// Request raw pixels of an already loaded avatar handle, for receivers building their own GPU data (e.g. atlas).
+	// Delivered on GameThread within the same per-frame budget of textures.
+	void RequestPixels(const CSteamID SteamID, const int32 AvatarHandle, const EAvatarSize AvatarSize, FOnAvatarPixelsReady OnReady);
+
+	// Number of requests whose texture is not ready yet.
+	int32 GetNumInFlight() const;
+
+	// Encode next textures to BC1 (opaque) or BC3 (with alpha) on workers. Raw pixels requests are never encoded.
+	void SetCompressionEnabled(const bool bEnabled);
+	bool IsCompressionEnabled() const;
+
+	// Fired for every texture built from live pixels, including persisted avatars replaced after revalidation.
+	FOnAvatarTextureUpdated OnTextureUpdated;
+
+private:
+
+	typedef TQueue<FAvatarPixels, EQueueMode::Mpsc> FPixelsQueue;
+
+	// Create textures from fetched pixels, respecting the per-frame budget.
+	bool Tick(float DeltaTime);
+
+	// Fetch live pixels of persisted avatars whose SteamAPI handle became available.
+	void RevalidatePersisted();
+
+	// Fetch pixels on a worker task and push them into FetchedPixels.
+	void FetchPixelsAsync(const uint64 SteamID, const int32 AvatarHandle, const EAvatarSize AvatarSize, const uint32 RequestID);
+
+	// Get a texture (pooled if possible) and enqueue its upload on RenderThread.
+	UTexture2D* CreateTexture(FAvatarPixels& Pixels) const;
+
+	// Fire and remove all callbacks waiting for AvatarHandle.
+	void CompleteRequest(const int32 AvatarHandle, UTexture2D* Texture);
+
+	TSharedPtr<FAvatarCache> AvatarCache;
+	TSharedPtr<FAvatarDiskCache> DiskCache;
+	TSharedPtr<FAvatarTexturePool> TexturePool;
+
+	// Avatars served from disk, waiting for their live SteamAPI handle. GameThread only.
+	TMap<uint64, EAvatarSize> PendingRevalidations;
+	float RevalidateElapsed;
+
+	bool bIsCompressionEnabled;
+
+	// Shared with worker tasks, so it stays valid even if pipeline is destroyed while they run.
+	TSharedRef<FPixelsQueue, ESPMode::ThreadSafe> FetchedPixels;
+
+	// Callbacks of in flight requests, keyed by avatar handle (unique per user and tier). GameThread only.
+	TMap<int32, TArray<FOnAvatarPipelineComplete>> InFlightRequests;
+
+	// Receivers of raw pixels requests, keyed by RequestID. GameThread only.
+	TMap<uint32, FOnAvatarPixelsReady> PixelsRequests;
+	uint32 LastPixelsRequestID;
+
+	FTSTicker::FDelegateHandle TickHandle;
+};
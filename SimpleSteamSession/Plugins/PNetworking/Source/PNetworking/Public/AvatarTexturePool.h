@@ -0,0 +1,105 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PixelFormat.h"
+#include "AvatarTexturePool.generated.h"
+
+// Default max number of free textures kept for each size and pixel format.
+#define AVATAR_TEXTURE_POOL_DEFAULT_MAX_PER_SIZE 64
+
+// Max number of released textures waiting to be proven unreferenced, for each allowed free texture.
+#define AVATAR_TEXTURE_POOL_PARKED_PER_FREE 2
+
+class UTexture2D;
+
+// Counters of avatar texture pool usage. It is made in order to use it in blueprints.
+USTRUCT(BlueprintType)
+struct FAvatarTexturePoolStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "AvatarTexturePool", meta = (ToolTip = "Free textures currently kept by the pool, ready to be reused."))
+	int32 NumPooled;
+
+	UPROPERTY(BlueprintReadOnly, Category = "AvatarTexturePool", meta = (ToolTip = "Released textures waiting for a Garbage Collection to prove nobody references them."))
+	int32 NumParked;
+
+	UPROPERTY(BlueprintReadOnly, Category = "AvatarTexturePool", meta = (ToolTip = "Textures created because no free one was available."))
+	int32 NumCreated;
+
+	UPROPERTY(BlueprintReadOnly, Category = "AvatarTexturePool", meta = (ToolTip = "Textures given back to avatars from the free ones."))
+	int32 NumReused;
+
+	UPROPERTY(BlueprintReadOnly, Category = "AvatarTexturePool", meta = (ToolTip = "Released textures left to the Garbage Collector because the pool was full or they were still referenced."))
+	int32 NumDiscarded;
+
+	UPROPERTY(BlueprintReadOnly, Category = "AvatarTexturePool", meta = (ToolTip = "Max free textures kept for each size and pixel format."))
+	int32 MaxPerSize;
+
+	FAvatarTexturePoolStats() : NumPooled(0), NumParked(0), NumCreated(0), NumReused(0), NumDiscarded(0), MaxPerSize(0) {}
+};
+
+/*
+	Free lists of transient avatar textures, one for each size and pixel format.
+	Textures evicted or replaced in the avatar cache are released here, but they can still be used by widgets,
+	FUserSteamData, progressive avatars or resolver results: a released texture is only parked.
+	After each Garbage Collection, parked textures no object references anymore are moved to free lists
+	and reused for the next avatar of the same tier, so repeated friendlist refreshes do not create new UObjects.
+	Parked and free textures are kept alive with the root set, so the pool itself is never seen as a referencer.
+	GameThread only.
+*/
+class PNETWORKING_API FAvatarTexturePool
+{
+public:
+
+	FAvatarTexturePool(const int32 InMaxPerSize = AVATAR_TEXTURE_POOL_DEFAULT_MAX_PER_SIZE);
+	~FAvatarTexturePool();
+
+	// Get a free texture of this size and format, or create a new one. Content is undefined.
+	UTexture2D* Acquire(const uint32 Width, const uint32 Height, const EPixelFormat PixelFormat);
+
+	// Give back a texture the avatar cache does not own anymore. It is reused only once nobody else references it.
+	void Release(UTexture2D* Texture);
+
+	// Change max free textures per size, discarding the exceeding ones.
+	void SetMaxPerSize(const int32 NewMaxPerSize);
+
+	// Discard every parked and free texture. Counters are kept.
+	void Empty();
+
+	FAvatarTexturePoolStats GetStats() const;
+
+private:
+
+	static uint64 MakeKey(const uint32 Width, const uint32 Height, const EPixelFormat PixelFormat);
+
+	void OnPostGarbageCollect();
+
+	// Move parked textures without referencers to free lists. Runs once after each Garbage Collection.
+	void ReclaimParked();
+
+	// Stop keeping Texture alive: the Garbage Collector frees it once unreferenced.
+	void Discard(UTexture2D* Texture);
+
+	// Released textures, maybe still referenced outside the plugin. Oldest first.
+	TArray<UTexture2D*> ParkedTextures;
+
+	// Free textures, keyed by size and pixel format.
+	TMap<uint64, TArray<UTexture2D*>> FreeTextures;
+
+	// True once a Garbage Collection ran after the last reclaim.
+	bool bReclaimPending;
+
+	int32 MaxPerSize;
+	int32 NumPooled;
+
+	int32 NumCreated;
+	int32 NumReused;
+	int32 NumDiscarded;
+
+	FDelegateHandle PostGarbageCollectHandle;
+};
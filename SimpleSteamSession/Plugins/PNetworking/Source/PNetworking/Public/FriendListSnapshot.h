@@ -0,0 +1,103 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FriendRoster.h"
+#include "FriendListSnapshot.generated.h"
+
+/*
+	Immutable friendlist at a given roster version, stored as structure of arrays.
+	It is built once per roster change and shared by pointer between every consumer (C++ and Blueprint):
+	no consumer copies it. Names are FText, so unchanged names share their string with previous versions.
+	Each row remembers the roster version that last changed it, so two snapshots are diffed in O(rows).
+*/
+struct PNETWORKING_API FFriendListSnapshot
+{
+	uint32 Version;
+
+	// Columns, all with the same number of rows.
+	TArray<uint64> SteamIDs;
+	TArray<FText> UserNames;
+	TArray<EFriendPersonaState> PersonaStates;
+	TBitArray<> PlayingThisGame;
+	TArray<FString> RichPresenceStatuses;
+	TArray<int32> AvatarHandles;
+	TArray<uint32> RowVersions;
+
+	// SteamID to row.
+	TMap<uint64, int32> IndexBySteamID;
+
+	FFriendListSnapshot() : Version(0) {}
+
+	int32 Num() const { return SteamIDs.Num(); }
+
+	// Row of SteamID, or INDEX_NONE.
+	int32 Find(const uint64 SteamID) const;
+
+	// Rows of this snapshot added/changed since Older, and SteamIDs of Older not present anymore.
+	void Diff(const FFriendListSnapshot& Older, TArray<int32>& OutAddedRows, TArray<int32>& OutChangedRows, TArray<uint64>& OutRemovedSteamIDs) const;
+
+	// Build a roster entry of a row, for Blueprint and legacy APIs.
+	FFriendRosterEntry MakeEntry(const int32 Row) const;
+};
+
+typedef TSharedRef<const FFriendListSnapshot, ESPMode::ThreadSafe> FFriendListSnapshotRef;
+typedef TSharedPtr<const FFriendListSnapshot, ESPMode::ThreadSafe> FFriendListSnapshotPtr;
+
+// Blueprint handle of a friendlist snapshot. One object per version, shared by every Blueprint consumer.
+UCLASS(BlueprintType, meta=(NotBlueprintable))
+class PNETWORKING_API UFriendListSnapshot : public UObject
+{
+	GENERATED_BODY()
+
+public:
+
+	void SetSnapshot(FFriendListSnapshotRef InSnapshot);
+	FFriendListSnapshotPtr GetSnapshot() const;
+
+	/// <summary>
+	/// Roster version of this snapshot. Greater versions are newer.
+	/// </summary>
+	UFUNCTION(BlueprintPure, Category = "Friend list snapshot")
+	int32 GetVersion() const;
+
+	/// <summary>
+	/// Number of friends.
+	/// </summary>
+	UFUNCTION(BlueprintPure, Category = "Friend list snapshot")
+	int32 Num() const;
+
+	/// <summary>
+	/// Get row of a friend in constant time.
+	/// </summary>
+	/// <param name="SteamID"> SteamID (AccountID) of the friend. </param>
+	/// <returns> Row index, or -1 if not a friend in this snapshot. </returns>
+	UFUNCTION(BlueprintPure, Category = "Friend list snapshot")
+	int32 FindRow(const int32 SteamID) const;
+
+	/// <summary>
+	/// Get data of a row.
+	/// </summary>
+	/// <param name="Row"> Row index, from 0 to Num - 1. </param>
+	/// <param name="Friend"> Out friend data. </param>
+	/// <returns> Returns true if Row is valid. </returns>
+	UFUNCTION(BlueprintPure, Category = "Friend list snapshot")
+	bool GetRow(const int32 Row, FFriendRosterEntry& Friend) const;
+
+	/// <summary>
+	/// Compare with an older snapshot, to patch list rows instead of rebuilding them.
+	/// </summary>
+	/// <param name="Older"> Snapshot previously shown. If null, every row is added. </param>
+	/// <param name="AddedRows"> Out rows of this snapshot not present in Older. </param>
+	/// <param name="ChangedRows"> Out rows of this snapshot whose data changed since Older. </param>
+	/// <param name="RemovedSteamIDs"> Out SteamIDs present in Older only. </param>
+	UFUNCTION(BlueprintCallable, Category = "Friend list snapshot")
+	void Diff(const UFriendListSnapshot* Older, TArray<int32>& AddedRows, TArray<int32>& ChangedRows, TArray<int32>& RemovedSteamIDs) const;
+
+private:
+
+	FFriendListSnapshotPtr Snapshot;
+};
@@ -0,0 +1,86 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FriendRoster.h"
+#include "FriendListSnapshot.h"
+#include "FriendListView.generated.h"
+
+// Rows before and after a requested range whose avatars are requested too, so scrolling finds them ready.
+#define FRIEND_LIST_VIEW_PREFETCH_ROWS 8
+
+class FFriendNameIndex;
+class UProgressiveAvatar;
+
+// Friends shown by a list view.
+UENUM(BlueprintType)
+enum class EFriendListFilter : uint8
+{
+	FILTER_ALL					UMETA(DisplayName = "All"),
+	FILTER_ONLINE				UMETA(DisplayName = "Online"),
+	FILTER_PLAYING_THIS_GAME	UMETA(DisplayName = "Playing this game")
+};
+
+// Order of friends in a list view.
+UENUM(BlueprintType)
+enum class EFriendListSort : uint8
+{
+	SORT_NONE			UMETA(DisplayName = "SteamAPI order"),
+	SORT_ALPHABETICAL	UMETA(DisplayName = "Alphabetical"),
+	SORT_ONLINE_FIRST	UMETA(DisplayName = "Online first, then alphabetical")
+};
+
+// A row of a friend list view. It is made in order to use it in blueprints.
+USTRUCT(BlueprintType)
+struct FFriendListRow
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "FriendListView", meta = (ToolTip = "Position of the row in the whole filtered and sorted list."))
+	int32 Index;
+
+	UPROPERTY(BlueprintReadOnly, Category = "FriendListView")
+	FFriendRosterEntry Friend;
+
+	UPROPERTY(BlueprintReadOnly, Category = "FriendListView", meta = (ToolTip = "Avatar upgraded in place as it arrives. Null if avatars were not requested."))
+	UProgressiveAvatar* Avatar;
+
+	FFriendListRow() : Index(0), Avatar(nullptr) {}
+};
+
+/*
+	Filtered and sorted order of a roster snapshot, without any friend data copy.
+	It is rebuilt only when the snapshot or the parameters change, so list views asking for
+	visible ranges while scrolling only pay for the rows they show.
+*/
+class PNETWORKING_API FFriendListView
+{
+public:
+
+	FFriendListView(FFriendListSnapshotRef InSnapshot, const FFriendNameIndex& NameIndex, const EFriendListFilter InFilter, const EFriendListSort InSort, const FString& InQuery);
+
+	// True if this view was built with the same snapshot version and parameters.
+	bool Matches(const uint32 Version, const EFriendListFilter OtherFilter, const EFriendListSort OtherSort, const FString& OtherQuery) const;
+
+	int32 Num() const;
+
+	// Snapshot row shown at Index.
+	int32 GetSnapshotRow(const int32 Index) const;
+
+	const FFriendListSnapshot& GetSnapshot() const;
+
+private:
+
+	bool PassesFilter(const int32 SnapshotRow) const;
+
+	FFriendListSnapshotRef Snapshot;
+	EFriendListFilter Filter;
+	EFriendListSort Sort;
+	FString Query;
+
+	// Snapshot rows, in view order.
+	TArray<int32> Rows;
+};
@@ -0,0 +1,52 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Longest n-gram indexed. Queries longer than this use their rarest n-gram, then verify candidates.
+#define FRIEND_NAME_INDEX_MAX_GRAM 3
+
+struct FFriendListSnapshot;
+
+/*
+	Search and sort index of friend names, built once per roster snapshot.
+	- Collation: names are sorted once with FText::CompareTo (ICU, current culture) and each friend keeps its rank,
+	  so any later sort is an integer comparison.
+	- Search: case folded names are indexed by every 1, 2 and 3 characters gram. A query is answered from
+	  the posting list of its rarest gram (already in collation order) and candidates are verified with a substring match.
+*/
+class PNETWORKING_API FFriendNameIndex
+{
+public:
+
+	FFriendNameIndex(const FFriendListSnapshot& Snapshot);
+
+	// Version of the snapshot this index was built from.
+	uint32 GetVersion() const;
+
+	// Rank of a friend in collation order, or INDEX_NONE if not indexed.
+	int32 GetCollationRank(const uint32 AccountID) const;
+
+	// Snapshot rows whose name contains Query (case insensitive). Prefix matches first, then in collation order.
+	void Search(const FString& Query, const int32 MaxResults, TArray<int32>& OutSnapshotRows) const;
+
+	// Every snapshot row in collation order.
+	const TArray<int32>& GetSortedRows() const;
+
+private:
+
+	static uint64 MakeGramKey(const TCHAR* Chars, const int32 Length);
+
+	uint32 Version;
+
+	// Index rows are in collation order: row = rank.
+	TArray<int32> SortedRows; // Rank to snapshot row.
+	TArray<FString> FoldedNames; // Rank to case folded name.
+	TMap<uint32, int32> RankByAccountID;
+
+	// N-gram to ranks containing it, ascending.
+	TMap<uint64, TArray<int32>> Postings;
+};
@@ -0,0 +1,195 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "Containers/Ticker.h"
+#include "FriendRoster.generated.h"
+
+// Roster file written on exit, one per local Steam account (%llu is its SteamID), relative to project Saved directory.
+#define FRIEND_ROSTER_FILE_NAME TEXT("PNetworking/FriendRoster_%llu.bin")
+
+// Roster file header identifier and format version.
+#define FRIEND_ROSTER_FILE_MAGIC 0x52545346
+#define FRIEND_ROSTER_FILE_VERSION 3
+
+// Max entries accepted from the roster file. Steam friendlist limit is lower.
+#define FRIEND_ROSTER_FILE_MAX_ENTRIES 4096
+
+// Friends read again from SteamAPI per frame while reconciling a persisted roster.
+#define FRIEND_ROSTER_RECONCILE_PER_TICK 32
+
+class CSteamID;
+class SteamAPICallbackManager;
+struct FFriendListSnapshot;
+
+// Steam persona state of a friend. Same order of EPersonaState in steam_api.
+UENUM(BlueprintType)
+enum class EFriendPersonaState : uint8
+{
+	PERSONA_OFFLINE				UMETA(DisplayName = "Offline"),
+	PERSONA_ONLINE				UMETA(DisplayName = "Online"),
+	PERSONA_BUSY				UMETA(DisplayName = "Busy"),
+	PERSONA_AWAY				UMETA(DisplayName = "Away"),
+	PERSONA_SNOOZE				UMETA(DisplayName = "Snooze"),
+	PERSONA_LOOKING_TO_TRADE	UMETA(DisplayName = "Looking to trade"),
+	PERSONA_LOOKING_TO_PLAY		UMETA(DisplayName = "Looking to play"),
+	PERSONA_INVISIBLE			UMETA(DisplayName = "Invisible")
+};
+
+// A friend of local user as known by the roster. It is made in order to use it in blueprints.
+USTRUCT(BlueprintType)
+struct FFriendRosterEntry
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "FriendRoster")
+	int32 SteamID; // Blueprint not supported "uint32", so we need to do some casts.
+
+	UPROPERTY(BlueprintReadOnly, Category = "FriendRoster")
+	FText UserName;
+
+	UPROPERTY(BlueprintReadOnly, Category = "FriendRoster")
+	EFriendPersonaState PersonaState;
+
+	UPROPERTY(BlueprintReadOnly, Category = "FriendRoster", meta = (ToolTip = "True if the friend is running this game."))
+	bool bIsPlayingThisGame;
+
+	UPROPERTY(BlueprintReadOnly, Category = "FriendRoster", meta = (ToolTip = "Rich presence 'status' key set by the game the friend is playing. Empty if not set."))
+	FString RichPresenceStatus;
+
+	UPROPERTY(BlueprintReadOnly, Category = "FriendRoster", meta = (ToolTip = "SteamAPI image handle of the small avatar. It changes when the friend changes avatar."))
+	int32 AvatarHandle;
+
+	FFriendRosterEntry() : SteamID(0), UserName(FText::GetEmpty()), PersonaState(EFriendPersonaState::PERSONA_OFFLINE), bIsPlayingThisGame(false), AvatarHandle(0) {}
+
+	// Just online friends (better: not offline).
+	bool IsOnline() const { return PersonaState != EFriendPersonaState::PERSONA_OFFLINE; }
+
+	bool HasSameData(const FFriendRosterEntry& Other) const;
+};
+
+// Delegates fired on GameThread for every roster change.
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnFriendRosterEntryChanged, const FFriendRosterEntry&)
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnFriendRosterEntryRemoved, int32 /*SteamID*/)
+DECLARE_MULTICAST_DELEGATE(FOnFriendRosterVersionChanged)
+
+/*
+	Resident list of local user friends, read from SteamAPI once and then kept updated by
+	PersonaStateChange_t / FriendRichPresenceUpdate_t callbacks.
+	Callbacks only queue the SteamID: changed friends are read again on GameThread, once per frame,
+	and only real differences are notified as add/remove/update deltas.
+	The roster of last run is saved on exit and memory mapped on start, so friends are served before SteamAPI is read:
+	live data is then reconciled a few friends per frame, notifying only differences.
+*/
+class PNETWORKING_API FFriendRoster
+{
+public:
+
+	FFriendRoster();
+	~FFriendRoster();
+
+	// Load roster of last run (or read the whole friendlist if missing) and start listening to SteamAPI. Returns false if SteamAPI is not available.
+	bool Initialize();
+
+	// Write the roster file of local user, with pixels hash of each friend avatar (0 if unknown).
+	bool Save(TFunctionRef<uint32(uint64 /*SteamID*/)> GetAvatarHash) const;
+
+	// Keep persisted avatar hashes matching the avatar on disk (GetAvatarHash), drop the others.
+	// A friend whose avatar on disk is the persisted one is not updated when its live avatar handle arrives.
+	void ValidateAvatarHashes(TFunctionRef<uint32(uint64 /*SteamID*/)> GetAvatarHash);
+
+	// Live pixels of SteamID avatar were read, with this hash on disk: the friend is updated if it differs from the persisted one.
+	void UpdateAvatarHash(const uint64 SteamID, const uint32 Hash);
+
+	// True while entries loaded from the roster file are being compared with SteamAPI.
+	bool IsReconciling() const;
+
+	// Every friend, in SteamAPI order. Removals swap the last entry in place.
+	const TArray<FFriendRosterEntry>& GetEntries() const;
+
+	// 64 bits SteamID of the entry at Index.
+	uint64 GetSteamID64(const int32 Index) const;
+
+	const FFriendRosterEntry* Find(const uint64 SteamID) const;
+
+	int32 Num() const;
+	int32 NumOnline() const;
+
+	// Incremented on every add/remove/update, and when persisted entries get their avatar handle.
+	uint32 GetVersion() const;
+
+	// Immutable copy of current roster. Built once per version, then shared by every caller.
+	TSharedRef<const FFriendListSnapshot, ESPMode::ThreadSafe> GetSnapshot();
+
+	FOnFriendRosterEntryChanged OnAdded;
+	FOnFriendRosterEntryChanged OnUpdated;
+	FOnFriendRosterEntryRemoved OnRemoved;
+
+	// Fired at most once per frame, after every delta of that frame (or of Initialize, on the first frame).
+	FOnFriendRosterVersionChanged OnVersionChanged;
+
+	// Fired once when every persisted entry has been compared with SteamAPI.
+	FOnFriendRosterVersionChanged OnReconciled;
+
+private:
+
+	typedef TQueue<uint64, EQueueMode::Mpsc> FDirtyQueue;
+
+	// Read current data of a user from SteamAPI. Returns false if the user is not a friend.
+	static bool ReadEntry(const CSteamID SteamID, FFriendRosterEntry& OutEntry);
+
+	// Apply changes queued by SteamAPI callbacks.
+	bool Tick(float DeltaTime);
+
+	// Map the roster file and fill entries with it. Returns false if missing or invalid.
+	bool LoadPersisted();
+
+	// Start reconciling persisted entries: friends removed meanwhile are removed now, the others are queued.
+	void BeginReconcile();
+
+	// Read again the next queued friends.
+	void ReconcileStep();
+
+	// Roster file of local user, empty if local SteamID is unknown.
+	FString GetFilePath() const;
+
+	void Refresh(const uint64 SteamID);
+	void AddEntry(const uint64 SteamID, FFriendRosterEntry&& Entry);
+	void RemoveEntry(const uint64 SteamID);
+
+	TArray<FFriendRosterEntry> Entries;
+	TArray<uint64> SteamIDs;
+	TMap<uint64, int32> IndexBySteamID;
+	int32 NumOnlineEntries;
+
+	// Roster version that last changed each entry, used to diff snapshots.
+	TArray<uint32> EntryVersions;
+	uint32 Version;
+
+	// Last version notified by OnVersionChanged: deltas applied outside Tick are notified by the next one.
+	uint32 BroadcastVersion;
+
+	TSharedPtr<const FFriendListSnapshot, ESPMode::ThreadSafe> CachedSnapshot;
+
+	// Avatar pixels hash of persisted entries, until their live avatar is read. 0 is never stored.
+	TMap<uint64, uint32> PersistedAvatarHashes;
+
+	// Owner of the roster, read once so the file can be saved even after SteamAPI shutdown.
+	uint64 LocalSteamID;
+
+	// Friends still to compare with SteamAPI, and the next one.
+	TArray<uint64> ReconcileQueue;
+	int32 ReconcileIndex;
+
+	// Shared with SteamAPI callbacks, so it stays valid even if roster is destroyed while they run.
+	TSharedRef<FDirtyQueue, ESPMode::ThreadSafe> DirtySteamIDs;
+
+	TWeakPtr<SteamAPICallbackManager> SteamAPIManager;
+	FDelegateHandle PersonaStateChangedHandle;
+	FDelegateHandle RichPresenceUpdatedHandle;
+	FTSTicker::FDelegateHandle TickHandle;
+};
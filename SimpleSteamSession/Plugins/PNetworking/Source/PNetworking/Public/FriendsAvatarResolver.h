@@ -0,0 +1,99 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "UObject/StrongObjectPtr.h"
+#include "AvatarAtlas.h"
+
+class CSteamID;
+class UTexture2D;
+class FAvatarPipeline;
+enum class EAvatarSize : uint8;
+
+// Delegate fired once on GameThread with textures in the same order as requested SteamIDs (nullptr if missing).
+DECLARE_DELEGATE_OneParam(FOnFriendsAvatarResolved, const TArray<UTexture2D*>&)
+
+// Delegate fired once on GameThread with atlas slots in the same order as requested SteamIDs (AtlasPage nullptr if missing).
+DECLARE_DELEGATE_OneParam(FOnFriendsAvatarAtlasResolved, const TArray<FAvatarAtlasSlot>&)
+
+/*
+	Resolves the avatars of a list of users without restarting from scratch.
+	Every avatar already loaded by SteamAPI is sent to the pipeline immediately; the others are kept
+	in a pending set and requested one by one when their AvatarImageLoaded_t arrives.
+	Completion fires once, when nothing is outstanding or when the optional timeout expires.
+	If built with an atlas, avatars are written in atlas cells instead of one texture per avatar.
+*/
+class PNETWORKING_API FFriendsAvatarResolver : public TSharedFromThis<FFriendsAvatarResolver>
+{
+public:
+
+	FFriendsAvatarResolver(TSharedPtr<FAvatarPipeline> InAvatarPipeline, const TArray<CSteamID>& InSteamIDs, const EAvatarSize InAvatarSize, FOnFriendsAvatarResolved InOnComplete);
+	FFriendsAvatarResolver(TSharedPtr<FAvatarPipeline> InAvatarPipeline, TSharedPtr<FAvatarAtlas> InAvatarAtlas, const TArray<CSteamID>& InSteamIDs, const EAvatarSize InAvatarSize, FOnFriendsAvatarAtlasResolved InOnAtlasComplete);
+	~FFriendsAvatarResolver();
+
+	// Request every avatar. TimeoutSeconds <= 0 means no timeout.
+	// Returns true if completion already fired (every texture was cached).
+	bool Start(const float TimeoutSeconds = 0.f);
+
+	// Must be called on GameThread when SteamAPI notifies an AvatarImageLoaded_t for SteamID.
+	void OnAvatarImageLoaded(const uint64 SteamID);
+
+	bool IsComplete() const;
+
+	// Number of avatars still waited from SteamAPI or from the pipeline.
+	int32 GetNumOutstanding() const;
+
+private:
+
+	// Send a loaded avatar handle to the pipeline (or to the atlas).
+	void RequestTexture(const int32 Index, const int32 AvatarHandle);
+
+	// Wait for SteamID AvatarImageLoaded_t, through SteamAPICallbackManager waiters.
+	void AddAvatarWaiter(const uint64 SteamID);
+
+	// Serve the avatar persisted on disk, if any. Returns true if it was served.
+	bool RequestPersistedTexture(const int32 Index);
+
+	// Pipeline callback, Index is the position inside SteamIDs.
+	void OnTextureReady(UTexture2D* Texture, const int32 Index);
+
+	// Atlas callback, Index is the position inside SteamIDs.
+	void OnSlotReady(const FAvatarAtlasSlot& Slot, const int32 Index);
+
+	// Shared by OnTextureReady and OnSlotReady.
+	void OnItemReady();
+
+	bool OnTimeout(float DeltaTime);
+
+	// Fire completion if nothing is outstanding (or if forced by timeout).
+	void TryComplete(const bool bForce = false);
+
+	TSharedPtr<FAvatarPipeline> AvatarPipeline;
+
+	// Valid only for atlas resolvers.
+	TSharedPtr<FAvatarAtlas> AvatarAtlas;
+
+	TArray<uint64> SteamIDs;
+	EAvatarSize AvatarSize; // Never Auto.
+	TArray<TStrongObjectPtr<UTexture2D>> Textures;
+	TArray<FAvatarAtlasSlot> Slots; // Pages are kept alive by the atlas.
+
+	// Avatars still downloading on SteamAPI side: SteamID -> index inside SteamIDs.
+	TMap<uint64, int32> PendingHandles;
+
+	// Avatars sent to the pipeline and not ready yet.
+	int32 PendingTextures;
+
+	// True while Start is sending requests: cached textures complete synchronously.
+	bool bIsStarting;
+
+	bool bIsComplete;
+
+	FTSTicker::FDelegateHandle TimeoutHandle;
+	FOnFriendsAvatarResolved OnComplete;
+	FOnFriendsAvatarAtlasResolved OnAtlasComplete;
+};
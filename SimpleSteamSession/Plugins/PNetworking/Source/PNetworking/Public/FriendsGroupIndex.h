@@ -0,0 +1,75 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FriendsGroupIndex.generated.h"
+
+// Seconds after which the index is read again from SteamAPI. Steam does not notify friends groups changes.
+#define FRIENDS_GROUP_INDEX_TTL 60.0
+
+// A Steam friends group (tag) of local user. It is made in order to use it in blueprints.
+USTRUCT(BlueprintType)
+struct FFriendsGroup
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "FriendsGroup")
+	int32 GroupID; // SteamAPI FriendsGroupID_t is int16.
+
+	UPROPERTY(BlueprintReadOnly, Category = "FriendsGroup")
+	FString Name;
+
+	UPROPERTY(BlueprintReadOnly, Category = "FriendsGroup")
+	int32 NumMembers;
+
+	FFriendsGroup() : GroupID(-1), NumMembers(0) {}
+};
+
+/*
+	Friends groups of local user and their members, read from SteamAPI in one pass:
+	GetFriendsGroupCount / GetFriendsGroupIDByIndex / GetFriendsGroupMembersList.
+	Membership queries (members of a group, groups of a friend) are answered from the index.
+	It is read again when older than FRIENDS_GROUP_INDEX_TTL, when marked dirty (friends added/removed) or on demand.
+	GameThread only.
+*/
+class PNETWORKING_API FFriendsGroupIndex
+{
+public:
+
+	FFriendsGroupIndex();
+
+	// Read every group from SteamAPI. Returns false if SteamAPI is not available.
+	bool Rebuild();
+
+	// True if Rebuild should be called before using the index.
+	bool IsStale() const;
+
+	// Next IsStale returns true.
+	void MarkDirty();
+
+	const TArray<FFriendsGroup>& GetGroups() const;
+
+	// 64 bits SteamIDs of a group members, or nullptr if GroupID is not a group.
+	const TArray<uint64>* GetMembers(const int32 GroupID) const;
+
+	// Groups of a friend, empty if none.
+	TConstArrayView<int32> GetGroupsOf(const uint64 SteamID) const;
+
+	bool IsMember(const uint64 SteamID, const int32 GroupID) const;
+
+private:
+
+	TArray<FFriendsGroup> Groups;
+
+	// Same order of Groups.
+	TArray<TArray<uint64>> Members;
+	TMap<int32, int32> IndexByGroupID;
+
+	TMap<uint64, TArray<int32, TInlineAllocator<2>>> GroupsBySteamID;
+
+	// Platform time of last Rebuild, 0 if never built or dirty.
+	double BuildTime;
+};
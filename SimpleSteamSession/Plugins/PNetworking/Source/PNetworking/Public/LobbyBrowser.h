@@ -0,0 +1,218 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "Containers/Ticker.h"
+#include "SteamAPICallbackManager.h"
+#include "PingLocation.h"
+#include "LobbyBrowser.generated.h"
+
+// Max lobbies of a search when not specified.
+#define LOBBY_BROWSER_DEFAULT_MAX_RESULTS 50
+
+// Seconds after which a stage without LobbyMatchList_t answer is skipped.
+#define LOBBY_BROWSER_STAGE_TIMEOUT 10.0
+
+// Seconds after which a RequestLobbyData without LobbyDataUpdate_t answer is completed as failed.
+#define LOBBY_DETAILS_REQUEST_TIMEOUT 10.0
+
+// Lobby data key written by Steam Online Subsystem with the host name.
+#define LOBBY_OWNER_NAME_KEY "OWNINGNAME"
+
+// Parameters of a lobby search.
+USTRUCT(BlueprintType)
+struct FLobbySearchParameters
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LobbyBrowser", meta = (ToolTip = "Max number of lobbies found, over every stage."))
+	int32 MaxResults;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LobbyBrowser", meta = (ToolTip = "Skip full lobbies."))
+	bool bOnlyWithFreeSlots;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LobbyBrowser", meta = (ToolTip = "Search near lobbies first and widen the distance stage by stage. Results of each stage are streamed as they arrive."))
+	bool bWidenDistance;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LobbyBrowser", meta = (ToolTip = "Lobby data keys and values every lobby must have."))
+	TMap<FString, FString> StringFilters;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LobbyBrowser", meta = (ToolTip = "Skip lobbies whose estimated ping (ms) is higher. 0 means no filter. Lobbies with unknown ping are kept."))
+	int32 MaxPingMs;
+
+	FLobbySearchParameters() : MaxResults(LOBBY_BROWSER_DEFAULT_MAX_RESULTS), bOnlyWithFreeSlots(true), bWidenDistance(true), MaxPingMs(0) {}
+};
+
+// A lobby found by a search: only what a list needs. Metadata is requested per card with RequestLobbyDetails.
+USTRUCT(BlueprintType)
+struct FLobbySearchRow
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "LobbyBrowser", meta = (ToolTip = "64 bits SteamID of the lobby."))
+	int64 LobbyID;
+
+	UPROPERTY(BlueprintReadOnly, Category = "LobbyBrowser")
+	int32 NumMembers;
+
+	UPROPERTY(BlueprintReadOnly, Category = "LobbyBrowser")
+	int32 MaxMembers;
+
+	UPROPERTY(BlueprintReadOnly, Category = "LobbyBrowser", meta = (ToolTip = "Ping (ms) to the host estimated from its ping location. -1 if unknown."))
+	int32 PingMs;
+
+	FLobbySearchRow() : LobbyID(0), NumMembers(0), MaxMembers(0), PingMs(PING_LOCATION_UNKNOWN) {}
+};
+
+// Metadata of a lobby.
+USTRUCT(BlueprintType)
+struct FLobbyDetails
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "LobbyBrowser", meta = (ToolTip = "64 bits SteamID of the lobby."))
+	int64 LobbyID;
+
+	UPROPERTY(BlueprintReadOnly, Category = "LobbyBrowser", meta = (ToolTip = "False if the lobby does not exist anymore or SteamAPI did not answer."))
+	bool bIsValid;
+
+	UPROPERTY(BlueprintReadOnly, Category = "LobbyBrowser")
+	FString OwnerName;
+
+	UPROPERTY(BlueprintReadOnly, Category = "LobbyBrowser")
+	int32 NumMembers;
+
+	UPROPERTY(BlueprintReadOnly, Category = "LobbyBrowser")
+	int32 MaxMembers;
+
+	UPROPERTY(BlueprintReadOnly, Category = "LobbyBrowser", meta = (ToolTip = "Ping (ms) to the host estimated from its ping location. -1 if unknown."))
+	int32 PingMs;
+
+	UPROPERTY(BlueprintReadOnly, Category = "LobbyBrowser", meta = (ToolTip = "Every lobby data key and value."))
+	TMap<FString, FString> Data;
+
+	FLobbyDetails() : LobbyID(0), bIsValid(false), NumMembers(0), MaxMembers(0), PingMs(PING_LOCATION_UNKNOWN) {}
+};
+
+// Delegate fired on GameThread for every batch of new lobbies of a search, closest first. Last batch has bIsComplete set (and may be empty).
+DECLARE_DELEGATE_ThreeParams(FOnLobbySearchBatch, int32 /*SearchID*/, const TArray<FLobbySearchRow>& /*Lobbies*/, bool /*bIsComplete*/)
+
+// Delegate fired once on GameThread when requested lobby details arrived or timed out.
+DECLARE_DELEGATE_OneParam(FOnLobbyDetailsRequested, const FLobbyDetails& /*Details*/)
+
+/*
+	Lobby search streamed to UI, built on ISteamMatchmaking::RequestLobbyList.
+	A single RequestLobbyList answers only once every lobby is found, so a search is split in stages of widening
+	distance (close, default, far, worldwide): near lobbies, the fastest to answer and the best to join,
+	are shown first and each next stage only streams lobbies not found yet.
+	- Rows carry only what a list needs, ping estimated from host ping location included; lobby metadata is read per visible card and requested from SteamAPI
+	  only when not known yet (LobbyDataUpdate_t).
+	- A new search supersedes the running one: the answer of its pending SteamAPI call is dropped and its callback never fired again.
+	- Each RequestLobbyList call has its own handler and tag: a late answer can only be dropped, never taken for a newer stage.
+	GameThread only, except LobbyMatchList_t handlers which only queue results.
+*/
+class PNETWORKING_API FLobbyBrowser
+{
+public:
+
+	FLobbyBrowser();
+	~FLobbyBrowser();
+
+	// Start listening to SteamAPI. Returns false if SteamAPI is not available.
+	bool Initialize();
+
+	// Start a search, cancelling the running one. Returns its SearchID, or 0 if SteamAPI is not available.
+	int32 Search(const FLobbySearchParameters& Parameters, FOnLobbySearchBatch Callback);
+
+	// Cancel the running search, if any. Its callback is not fired anymore.
+	void Cancel();
+
+	bool IsSearching() const;
+
+	// Details of a lobby. Returns true if already known (OutDetails filled, Callback not fired),
+	// else requests them and fires Callback once they arrive or time out.
+	bool RequestDetails(const uint64 LobbyID, FLobbyDetails& OutDetails, FOnLobbyDetailsRequested Callback);
+
+private:
+
+	// Lobbies found by a RequestLobbyList call, queued by the SteamAPI thread.
+	struct FMatchList
+	{
+		SteamAPICall_t CallHandle;
+		uint32 CallTag;
+		bool bFailed;
+		TArray<uint64> LobbyIDs;
+	};
+
+	struct FSearch
+	{
+		int32 SearchID;
+		FLobbySearchParameters Parameters;
+		TArray<ELobbyDistanceFilter, TInlineAllocator<4>> Stages;
+		int32 NextStage;
+		uint32 CallTag; // Tag of the stage waited, 0 if none.
+		double StageStartTime;
+		double StartTime;
+		bool bHasFoundFirst;
+		TSet<uint64> FoundLobbyIDs; // Streamed or filtered out.
+		int32 NumStreamed;
+		FOnLobbySearchBatch Callback;
+	};
+
+	typedef TQueue<FMatchList, EQueueMode::Mpsc> FMatchListQueue;
+	typedef TQueue<TPair<uint64, bool>, EQueueMode::Mpsc> FLobbyDataQueue;
+
+	// A RequestLobbyList call waiting its answer. Its handler only uses its own tag and the shared queue, never the browser.
+	class FMatchListCall
+	{
+	public:
+
+		FMatchListCall(const SteamAPICall_t InCallHandle, const uint32 InCallTag, TSharedRef<FMatchListQueue, ESPMode::ThreadSafe> InMatchLists);
+
+	private:
+
+		// Runs on the thread running SteamAPI callbacks.
+		void OnLobbyMatchList(LobbyMatchList_t* Result, bool bIOFailure);
+
+		SteamAPICall_t CallHandle;
+		uint32 CallTag;
+		TSharedRef<FMatchListQueue, ESPMode::ThreadSafe> MatchLists;
+		CCallResult<FMatchListCall, LobbyMatchList_t> CallResult;
+	};
+
+	// Send RequestLobbyList of next stage. Returns false if there are no more stages.
+	bool StartNextStage();
+
+	// Stream new lobbies of a stage and start the next one, or complete the search.
+	void OnStageAnswered(const FMatchList& MatchList);
+
+	// Read lobby metadata known by SteamAPI. Returns false if nothing is known yet.
+	bool ReadDetails(const uint64 LobbyID, FLobbyDetails& OutDetails) const;
+
+	void CompleteDetails(const uint64 LobbyID, const bool bSuccess);
+
+	bool Tick(float DeltaTime);
+
+	TUniquePtr<FSearch> CurrentSearch;
+	int32 NextSearchID;
+	uint32 NextCallTag;
+
+	// RequestLobbyList calls not answered yet, cancelled and timed out ones included. Removed once their answer is dequeued.
+	TMap<SteamAPICall_t, TUniquePtr<FMatchListCall>> PendingCalls;
+
+	// Detail callbacks waiting LobbyDataUpdate_t, and when each lobby was requested.
+	TMap<uint64, TArray<FOnLobbyDetailsRequested, TInlineAllocator<1>>> DetailsWaiters;
+	TMap<uint64, double> DetailsRequestTimes;
+
+	// Shared with SteamAPI callbacks, so they stay valid even if browser is destroyed while they run.
+	TSharedRef<FMatchListQueue, ESPMode::ThreadSafe> MatchLists;
+	TSharedRef<FLobbyDataQueue, ESPMode::ThreadSafe> LobbyDataUpdates;
+
+	TWeakPtr<SteamAPICallbackManager> SteamAPIManager;
+	FDelegateHandle LobbyDataUpdatedHandle;
+	FTSTicker::FDelegateHandle TickHandle;
+};
@@ -15,6 +15,7 @@
 // Forward declarations.
 class IOnlineSubsystem;
 class IOnlineSession;
+class FRelayNetwork;
 
 // Custom Log category.
 DECLARE_LOG_CATEGORY_EXTERN(LogSteamNetworkingPlugin, Warning, All)
@@ -48,10 +49,11 @@ public:
 	static IOnlineSubsystem* GetOnlineSubsystemPointer();
 	static TSharedPtr<IOnlineSession, ESPMode::ThreadSafe> GetOnlineSessionPointer();
 	static TSharedPtr<SteamAPICallbackManager> GetSteamAPIManager();
+	static TSharedPtr<FRelayNetwork> GetRelayNetwork();
 	static FName GetSessionName();
 	static ELocalSessionState GetLocalSessionCurrentState();
 
-	// Setters.
+	// Setters. Session operations change state only through FSessionOrchestrator transition graph.
 	static void SetLocalSessionCurrentState(const ELocalSessionState NewSessionState);
 
 #pragma endregion
@@ -73,6 +75,9 @@ private:
 	// SteamAPI callbacks manager class.
 	static TSharedPtr<SteamAPICallbackManager> SteamApiManagerPtr;
 
+	// Steam Datagram Relay warm up, started with the module.
+	static TSharedPtr<FRelayNetwork> RelayNetworkPtr;
+
 #pragma endregion
 
 };
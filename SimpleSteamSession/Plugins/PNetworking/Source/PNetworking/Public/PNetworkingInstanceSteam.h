@@ -12,6 +12,18 @@
 #include "Interfaces/OnlineFriendsInterface.h"
 #include "OnlineSessionSettings.h"
 #include "SessionCreationParameters.h"
+#include "AvatarCache.h"
+#include "AvatarAtlas.h"
+#include "AvatarTexturePool.h"
+#include "FriendRoster.h"
+#include "FriendListView.h"
+#include "FriendsGroupIndex.h"
+#include "RecentPlayers.h"
+#include "UserDirectory.h"
+#include "SessionOrchestrator.h"
+#include "LobbyBrowser.h"
+#include "RelayNetwork.h"
+#include "SteamAPICallbackManager.h"
 #include "Interfaces/OnlineSessionInterface.h"
 #include "PNetworkingInstanceSteam.generated.h"
 
@@ -19,6 +31,21 @@
 
 class FOnlineFriend;
 class CSteamID;
+class FAvatarPipeline;
+class FAvatarAtlas;
+class FAvatarDiskCache;
+class FFriendsAvatarResolver;
+class FProgressiveAvatarProvider;
+class FFriendRoster;
+class FFriendNameIndex;
+class FRichPresenceCache;
+class FFriendsGroupIndex;
+class FRecentPlayers;
+class FUserDirectory;
+class FSessionOrchestrator;
+class FLobbyBrowser;
+class UProgressiveAvatar;
+class UFriendListSnapshot;
 struct FUserSteamData;
 struct FSessionCreationParameters;
 enum ELocalSessionState : uint8;
@@ -32,12 +59,32 @@ DECLARE_DYNAMIC_DELEGATE_OneParam(FOnFriendsListReady, const TArray<FString>&, F
 DECLARE_DYNAMIC_DELEGATE_OneParam(FOnFriendsAvatarReady, const TArray<UTexture2D*>&, FriendsListAvatars);
 DECLARE_DYNAMIC_DELEGATE_OneParam(FOnRequestedFriendAvatarReady, const UTexture2D*, RequestedFriendAvatar);
 DECLARE_DYNAMIC_DELEGATE_OneParam(FOnFriendsDataReady, const TArray<FUserSteamData>&, FriendsListDatas);
+DECLARE_DYNAMIC_DELEGATE_OneParam(FOnFriendsAvatarAtlasReady, const TArray<FAvatarAtlasSlot>&, FriendsAvatarSlots);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnAvatarAtlasRepacked);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnAvatarAtlasEvicted, int32, SteamID);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnFriendRosterChanged, const FFriendRosterEntry&, Friend);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnFriendRosterRemoved, int32, SteamID);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnFriendListSnapshotChanged, UFriendListSnapshot*, Snapshot);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnFriendRichPresenceChanged, int32, SteamID);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnRecentPlayersChanged);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnUserDataChanged, int32, SteamID);
 DECLARE_DYNAMIC_DELEGATE_TwoParams(FOnSessionParametersUpdateReady, FName, SessionName, bool, bWasSuccessfull);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnSessionOperationComplete, const FSessionOperationResult&, Result);
+DECLARE_DYNAMIC_DELEGATE_ThreeParams(FOnLobbiesFound, int32, SearchID, const TArray<FLobbySearchRow>&, Lobbies, bool, bIsComplete);
+DECLARE_DYNAMIC_DELEGATE_OneParam(FOnLobbyDetailsReady, const FLobbyDetails&, Details);
+DECLARE_DYNAMIC_DELEGATE_TwoParams(FOnQuickJoinComplete, bool, bWasSuccessful, int32, PingMs);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnRelayNetworkStateChange, ERelayNetworkState, State);
 
 #pragma endregion
 
 #define EMPTY_FSTRING ""
 
+// Default seconds an OSS friends list read is reused by GetOnlineFriendListNames/GetAllFriendListNames.
+#define FRIEND_LIST_NAMES_CACHE_TTL 30.0
+
+// Max sessions found by a quick join search, ranked by ping before joining the closest.
+#define QUICK_JOIN_MAX_SEARCH_RESULTS 50
+
 UCLASS(BlueprintType, meta=(NotBlueprintable))
 class PNETWORKING_API UPNetworkingInstanceSteam : public UObject
 {
@@ -95,17 +142,20 @@ public:
 	/// <summary>
 	/// Get the local user avatar as a callback. It returns UTexture2D* to Avatar texture.
 	/// </summary>
-	/// <param name="Callback"> Callback to be bound in BP/C++. </param>
+	/// <param name="Callback"> Callback to be bound in BP/C++. If the result is -1 it is always fired, with nullptr if the avatar can't be loaded. </param>
+	/// <param name="AvatarSize"> Steam avatar tier. Auto picks it from PixelSize. </param>
+	/// <param name="PixelSize"> On-screen size of the avatar, used only by Auto. </param>
 	/// <returns> int32 flag. 0 means error, 1 means result correct, -1 means in loading waiting for STEAMAPI. </returns>
 	UFUNCTION(BlueprintCallable, Category = "Online Subsystem local user functions")
-	int32 GetLocalUserAvatar(const FOnLocalAvatarReady& Callback);
+	int32 GetLocalUserAvatar(const FOnLocalAvatarReady& Callback, const EAvatarSize AvatarSize = EAvatarSize::AVATAR_LARGE, const int32 PixelSize = 0);
 
 #pragma endregion LocalUser
 
 #pragma region FriendlistUtilityLocalUser
 
 	/// <summary>
-	/// Get Steam username from a SteamID.
+	/// Get Steam username from a SteamID. Works for non-friends too: if SteamAPI does not know the user yet,
+	/// it is requested in background and OnUserDataChanged is fired when its name arrives.
 	/// </summary>
 	/// <param name="SteamID"> SteamID to get the username from. It is int32 type in order to be used in blueprints. </param>
 	/// <returns> Steam username of specified SteamID, or "" if not found/invalid. </returns>
@@ -113,39 +163,55 @@ public:
 	FString GetUsernameFromSteamID(const int32 SteamID);
 
 	/// <summary>
-	/// Get Friend Avatar from SteamID.
+	/// Get Friend Avatar from SteamID. Non-friends are resolved first (RequestUserInformation), then their avatar is downloaded.
 	/// </summary>
 	/// <param name="SteamID"> CSteamID to get Avatar from. It is int32 type in order to be used in blueprints. </param>
-	/// <param name="Callback"> Fired when the search and data retreive is completed. </param>
+	/// <param name="Callback"> Fired when the search and data retreive is completed. If the result is -1 it is always fired, with nullptr if the avatar can't be loaded. </param>
+	/// <param name="AvatarSize"> Steam avatar tier. Auto picks it from PixelSize. </param>
+	/// <param name="PixelSize"> On-screen size of the avatar, used only by Auto. </param>
 	/// <returns> int32 flag. 0 means error, 1 means result correct, -1 means in loading waiting for STEAMAPI. </returns>
 	UFUNCTION(BlueprintCallable, Category = "Online Subsystem friendlist utility functions")
-	int32 GetAvatarFromSteamID(const int32 SteamID, const FOnRequestedFriendAvatarReady& Callback);
+	int32 GetAvatarFromSteamID(const int32 SteamID, const FOnRequestedFriendAvatarReady& Callback, const EAvatarSize AvatarSize = EAvatarSize::AVATAR_LARGE, const int32 PixelSize = 0);
 
 	/// <summary>
 	/// Get all online friends names of specified user.
+	/// Names are cached for SetFriendListNamesCacheTTL seconds: calls within it are answered immediately,
+	/// and calls while a read is running wait for it instead of starting another one.
 	/// </summary>
 	/// <param name="Callback"> Fired when the search and data retreive is completed. </param>
 	/// <param name="LocalUserNum"> UserNum to search its friendlist. In default case of 0, it takes local user. </param>
+	/// <param name="bForceRefresh"> If the list should be read again from Online Subsystem, ignoring the cache. </param>
 	/// <returns> Returns true if the inital request was successfull. </returns>
 	UFUNCTION(BlueprintCallable, Category = "Online Subsystem friendlist utility functions")
-	bool GetOnlineFriendListNames(const FOnFriendsListReady& Callback, const int32 LocalUserNum = 0);
+	bool GetOnlineFriendListNames(const FOnFriendsListReady& Callback, const int32 LocalUserNum = 0, const bool bForceRefresh = false);
 
 	/// <summary>
-	/// Get all friends names of specified user.
+	/// Get all friends names of specified user. Cached as GetOnlineFriendListNames.
 	/// </summary>
 	/// <param name="Callback"> Fired when the search and data retreive is completed. </param>
 	/// <param name="LocalUserNum"> UserNum to search its friendlist. In default case of 0, it takes local user. </param>
+	/// <param name="bForceRefresh"> If the list should be read again from Online Subsystem, ignoring the cache. </param>
 	/// <returns> Returns true if the inital request was successfull. </returns>
 	UFUNCTION(BlueprintCallable, Category = "Online Subsystem friendlist utility functions")
-	bool GetAllFriendListNames(const FOnFriendsListReady& Callback, const int32 LocalUserNum = 0);
+	bool GetAllFriendListNames(const FOnFriendsListReady& Callback, const int32 LocalUserNum = 0, const bool bForceRefresh = false);
+
+	/// <summary>
+	/// Set for how long friends names read by GetOnlineFriendListNames/GetAllFriendListNames are reused.
+	/// </summary>
+	/// <param name="Seconds"> Time to live of cached lists. 0 disables the cache (concurrent calls still share one read). </param>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem friendlist utility functions")
+	void SetFriendListNamesCacheTTL(const float Seconds);
 
 	/// <summary>
 	/// Get all local user friendlist avatars as a Callback. It returns TArray<UTexture2D>& containing all textures.
 	/// </summary>
-	/// <param name="Callback"> Callback to be bound in BP/C++. </param>
+	/// <param name="Callback"> Callback to be bound in BP/C++. Always fired unless the result is 0, with an empty array if no avatar was resolved. </param>
+	/// <param name="TimeoutSeconds"> If greater than 0, Callback is fired after this time with the avatars resolved so far. </param>
+	/// <param name="AvatarSize"> Steam avatar tier. Auto picks it from PixelSize. </param>
+	/// <param name="PixelSize"> On-screen size of the avatar, used only by Auto. </param>
 	/// <returns> int32 flag. 0 means error, 1 means result correct, -1 means in loading waiting for STEAMAPI. </returns>
 	UFUNCTION(BlueprintCallable, Category = "Online Subsystem friendlist utility functions")
-	int32 GetFriendsAvatar(const FOnFriendsAvatarReady& Callback);
+	int32 GetFriendsAvatar(const FOnFriendsAvatarReady& Callback, const float TimeoutSeconds = 0.f, const EAvatarSize AvatarSize = EAvatarSize::AVATAR_LARGE, const int32 PixelSize = 0);
 
 	/// <summary>
 	/// Get complete and usable informations of all online Friends of local user as a Callback.
@@ -153,37 +219,404 @@ public:
 	/// </summary>
 	/// <param name="bAlphabeticalSort"> If TArray elements should be alphabetically sorted using their nicknames. </param>
 	/// <param name="Callback"> Callback to be bound in BP/C++. </param>
+	/// <param name="TimeoutSeconds"> If greater than 0, Callback is fired after this time even if some avatars are still missing (nullptr). </param>
+	/// <param name="AvatarSize"> Steam avatar tier. Auto picks it from PixelSize. </param>
+	/// <param name="PixelSize"> On-screen size of the avatar, used only by Auto. </param>
 	/// <returns> int32 flag. 0 means error, 1 means result correct, -1 means in loading waiting for STEAMAPI. </returns>
 	UFUNCTION(BlueprintCallable, Category = "Online Subsystem friendlist utility functions")
-	int32 GetPlayersData(const bool bAlphabeticalSort, const FOnFriendsDataReady& Callback);
+	int32 GetPlayersData(const bool bAlphabeticalSort, const FOnFriendsDataReady& Callback, const float TimeoutSeconds = 0.f, const EAvatarSize AvatarSize = EAvatarSize::AVATAR_LARGE, const int32 PixelSize = 0);
 
 #pragma endregion FriendlistUtilityLocalUser
 
+#pragma region AvatarCache
+
+	/// <summary>
+	/// Get usage counters of the avatar textures cache.
+	/// </summary>
+	/// <param name="Stats"> Out hits, misses, evictions and memory used by the cache. </param>
+	/// <returns> Returns true if the cache is initialized. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem avatar cache functions")
+	bool GetAvatarCacheStats(FAvatarCacheStats& Stats) const;
+
+	/// <summary>
+	/// Change avatar cache limits. Least recently used avatars are evicted immediately if needed.
+	/// </summary>
+	/// <param name="BudgetMegabytes"> Max memory (RGBA data) used by cached avatars. </param>
+	/// <param name="MaxEntries"> Max number of cached avatars. </param>
+	/// <returns> Returns true if the cache is initialized. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem avatar cache functions")
+	bool SetAvatarCacheBudget(const int32 BudgetMegabytes = 48, const int32 MaxEntries = 512);
+
+	/// <summary>
+	/// Remove every cached avatar. Next requests will rebuild textures from SteamAPI.
+	/// </summary>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem avatar cache functions")
+	void ClearAvatarCache();
+
+	/// <summary>
+	/// Get usage counters of the pool recycling avatar textures removed from the cache.
+	/// </summary>
+	/// <param name="Stats"> Out created, reused, discarded, parked (maybe still referenced) and free textures. </param>
+	/// <returns> Returns true if the pool is initialized. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem avatar cache functions")
+	bool GetAvatarTexturePoolStats(FAvatarTexturePoolStats& Stats) const;
+
+	/// <summary>
+	/// Change how many free avatar textures are kept for each avatar size.
+	/// </summary>
+	/// <param name="MaxTexturesPerSize"> Max free textures per size. 0 disables reuse. </param>
+	/// <returns> Returns true if the pool is initialized. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem avatar cache functions")
+	bool SetAvatarTexturePoolSize(const int32 MaxTexturesPerSize = 64);
+
+	/// <summary>
+	/// Store next avatar textures block compressed (BC1, or BC3 if they have alpha), encoded on worker threads.
+	/// Compressed avatars use 4-8 times less GPU memory. Textures already cached are not changed.
+	/// </summary>
+	/// <param name="bEnabled"> True to compress, false to keep uncompressed RGBA. </param>
+	/// <returns> Returns true if the avatar pipeline is initialized. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem avatar cache functions")
+	bool SetAvatarCompression(const bool bEnabled = true);
+
+#pragma endregion AvatarCache
+
+#pragma region AvatarAtlas
+
+	/// <summary>
+	/// Get all local user friendlist avatars packed in a few atlas textures, as a Callback.
+	/// Each slot contains the atlas page and the UV rect of a friend avatar: use them in a brush instead of one texture per friend.
+	/// </summary>
+	/// <param name="Callback"> Callback to be bound in BP/C++. Always fired unless the result is 0, with no slots if no avatar was resolved. </param>
+	/// <param name="TimeoutSeconds"> If greater than 0, Callback is fired after this time with the avatars resolved so far. </param>
+	/// <param name="AvatarSize"> Steam avatar tier. Auto picks it from PixelSize. </param>
+	/// <param name="PixelSize"> On-screen size of the avatar, used only by Auto. </param>
+	/// <returns> int32 flag. 0 means error, 1 means result correct, -1 means in loading waiting for STEAMAPI. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem avatar atlas functions")
+	int32 GetFriendsAvatarAtlas(const FOnFriendsAvatarAtlasReady& Callback, const float TimeoutSeconds = 0.f, const EAvatarSize AvatarSize = EAvatarSize::AVATAR_LARGE, const int32 PixelSize = 0);
+
+	/// <summary>
+	/// Get current atlas slot of a user avatar. Slots change after OnAvatarAtlasRepacked and OnAvatarAtlasEvicted.
+	/// </summary>
+	/// <param name="SteamID"> SteamID (AccountID) of the user. </param>
+	/// <param name="Slot"> Out atlas page and UV rect. </param>
+	/// <returns> Returns true if the avatar is present in the atlas. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem avatar atlas functions")
+	bool GetAvatarAtlasSlot(const int32 SteamID, FAvatarAtlasSlot& Slot);
+
+	/// <summary>
+	/// Remove a user avatar from the atlas. Pages are repacked (and released) when possible.
+	/// </summary>
+	/// <param name="SteamID"> SteamID (AccountID) of the user. </param>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem avatar atlas functions")
+	void RemoveAvatarFromAtlas(const int32 SteamID);
+
+	// Fired when avatars moved inside the atlas: every slot previously received must be requested again.
+	UPROPERTY(BlueprintAssignable, Category = "Online Subsystem avatar atlas functions")
+	FOnAvatarAtlasRepacked OnAvatarAtlasRepacked;
+
+	// Fired when a user avatar is evicted from a full atlas: its slot shows another avatar and must be requested again.
+	UPROPERTY(BlueprintAssignable, Category = "Online Subsystem avatar atlas functions")
+	FOnAvatarAtlasEvicted OnAvatarAtlasEvicted;
+
+#pragma endregion AvatarAtlas
+
+#pragma region ProgressiveAvatar
+
+	/// <summary>
+	/// Get an avatar handle usable immediately: its texture is a shared placeholder, or the small tier if already available,
+	/// and it is upgraded in place (OnChanged fired) until the requested tier arrives. Handles are shared per user.
+	/// </summary>
+	/// <param name="SteamID"> SteamID (AccountID) of the user. In default case of 0, it takes local user. </param>
+	/// <param name="AvatarSize"> Steam avatar tier to reach. Auto picks it from PixelSize. </param>
+	/// <param name="PixelSize"> On-screen size of the avatar, used only by Auto. </param>
+	/// <returns> Avatar handle, or nullptr on error. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem progressive avatar functions")
+	UProgressiveAvatar* GetProgressiveAvatar(const int32 SteamID = 0, const EAvatarSize AvatarSize = EAvatarSize::AVATAR_LARGE, const int32 PixelSize = 0);
+
+	/// <summary>
+	/// Same as GetPlayersData, but Callback is fired immediately: every entry has a ProgressiveAvatar handle
+	/// whose texture is upgraded in place, so lists can be shown on the first frame without waiting for SteamAPI.
+	/// </summary>
+	/// <param name="bAlphabeticalSort"> If TArray elements should be alphabetically sorted using their nicknames. </param>
+	/// <param name="Callback"> Callback to be bound in BP/C++. </param>
+	/// <param name="AvatarSize"> Steam avatar tier to reach. Auto picks it from PixelSize. </param>
+	/// <param name="PixelSize"> On-screen size of the avatar, used only by Auto. </param>
+	/// <returns> int32 flag. 0 means error, 1 means result correct. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem progressive avatar functions")
+	int32 GetPlayersDataProgressive(const bool bAlphabeticalSort, const FOnFriendsDataReady& Callback, const EAvatarSize AvatarSize = EAvatarSize::AVATAR_LARGE, const int32 PixelSize = 0);
+
+#pragma endregion ProgressiveAvatar
+
+#pragma region FriendRoster
+
+	/// <summary>
+	/// Get local user friends from the resident roster, without querying SteamAPI.
+	/// Roster is kept updated by SteamAPI notifications: use OnFriendAdded/OnFriendUpdated/OnFriendRemoved to patch lists.
+	/// </summary>
+	/// <param name="Friends"> Out friends data. </param>
+	/// <param name="bOnlineOnly"> If only online friends (better: not offline) should be returned. </param>
+	/// <param name="bAlphabeticalSort"> If TArray elements should be alphabetically sorted using their nicknames. </param>
+	/// <returns> Returns true if the roster is initialized. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem friend roster functions")
+	bool GetFriendRoster(TArray<FFriendRosterEntry>& Friends, const bool bOnlineOnly = true, const bool bAlphabeticalSort = false);
+
+	// Fired when a new friend is added to the roster.
+	UPROPERTY(BlueprintAssignable, Category = "Online Subsystem friend roster functions")
+	FOnFriendRosterChanged OnFriendAdded;
+
+	// Fired when name, persona state, game or rich presence status of a friend changed.
+	UPROPERTY(BlueprintAssignable, Category = "Online Subsystem friend roster functions")
+	FOnFriendRosterChanged OnFriendUpdated;
+
+	// Fired when a user is not a friend anymore.
+	UPROPERTY(BlueprintAssignable, Category = "Online Subsystem friend roster functions")
+	FOnFriendRosterRemoved OnFriendRemoved;
+
+	/// <summary>
+	/// Get an immutable snapshot of the roster. The same object is returned until the roster changes,
+	/// so it can be passed around and stored without copying friend data.
+	/// </summary>
+	/// <returns> Current snapshot, or nullptr if the roster is not initialized. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem friend roster functions")
+	UFriendListSnapshot* GetFriendListSnapshot();
+
+	/// <summary>
+	/// Search friends whose name contains Query, case insensitive. Made for typeahead: names starting with Query come first,
+	/// then the others, each group in alphabetical order of current culture.
+	/// </summary>
+	/// <param name="Query"> Text typed by the user. </param>
+	/// <param name="Results"> Out matching friends. </param>
+	/// <param name="MaxResults"> Max number of Results. </param>
+	/// <param name="bOnlineOnly"> If only online friends (better: not offline) should be returned. </param>
+	/// <returns> Returns true if the roster is initialized. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem friend roster functions")
+	bool SearchFriends(const FString& Query, TArray<FFriendRosterEntry>& Results, const int32 MaxResults = 20, const bool bOnlineOnly = false);
+
+	// Fired at most once per frame when the roster changed, with the new snapshot. Use Diff with the previous one to patch lists.
+	UPROPERTY(BlueprintAssignable, Category = "Online Subsystem friend roster functions")
+	FOnFriendListSnapshotChanged OnFriendListSnapshotChanged;
+
+	/// <summary>
+	/// Get rows [Start, Start + Count) of the filtered and sorted friendlist, made for virtualized list views.
+	/// Filtered order is cached until roster or parameters change, so scrolling costs only the requested rows.
+	/// Avatars are requested only for the range, plus a few rows before and after it (prefetch).
+	/// </summary>
+	/// <param name="Start"> Index of first row. </param>
+	/// <param name="Count"> Max number of rows. </param>
+	/// <param name="Rows"> Out rows, with progressive avatar handles. </param>
+	/// <param name="TotalRows"> Out number of rows of the whole filtered list, to size the scrollbar. </param>
+	/// <param name="Filter"> Friends to show. </param>
+	/// <param name="Sort"> Order of friends. </param>
+	/// <param name="Query"> If not empty, only friends whose name contains it. Without sort, names starting with it come first. </param>
+	/// <param name="AvatarSize"> Steam avatar tier to reach. Auto picks it from PixelSize. </param>
+	/// <param name="PixelSize"> On-screen size of the avatar, used only by Auto. </param>
+	/// <returns> Returns true if the roster is initialized. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem friend roster functions")
+	bool GetFriendsRange(const int32 Start, const int32 Count, TArray<FFriendListRow>& Rows, int32& TotalRows, const EFriendListFilter Filter = EFriendListFilter::FILTER_ALL, const EFriendListSort Sort = EFriendListSort::SORT_ONLINE_FIRST, const FString& Query = TEXT(""), const EAvatarSize AvatarSize = EAvatarSize::AVATAR_MEDIUM, const int32 PixelSize = 0);
+
+#pragma endregion FriendRoster
+
+#pragma region RichPresence
+
+	/// <summary>
+	/// Ask SteamAPI the rich presence of some friends. Requests are batched over next frames and skipped for friends
+	/// requested recently, so it can be called with whole lists. Friends playing this game do not need it.
+	/// </summary>
+	/// <param name="SteamIDs"> SteamIDs (AccountID) of the friends. If empty, every friend of the roster. </param>
+	/// <returns> Returns true if the rich presence cache is initialized. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem rich presence functions")
+	bool RequestFriendsRichPresence(const TArray<int32>& SteamIDs);
+
+	/// <summary>
+	/// Get a rich presence value of a friend from the cache, without calling SteamAPI. Made to be called every frame.
+	/// </summary>
+	/// <param name="SteamID"> SteamID (AccountID) of the friend. </param>
+	/// <param name="Key"> Rich presence key (e.g. "status", "connect"). </param>
+	/// <param name="Value"> Out value, empty if not set. </param>
+	/// <returns> Returns true if Key is set. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem rich presence functions")
+	bool GetFriendRichPresence(const int32 SteamID, const FString& Key, FString& Value);
+
+	/// <summary>
+	/// Get every cached rich presence key/value of a friend, without calling SteamAPI.
+	/// </summary>
+	/// <param name="SteamID"> SteamID (AccountID) of the friend. </param>
+	/// <param name="Pairs"> Out key/value pairs. </param>
+	/// <returns> Returns true if the friend has cached rich presence. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem rich presence functions")
+	bool GetFriendRichPresencePairs(const int32 SteamID, TMap<FString, FString>& Pairs);
+
+	/// <summary>
+	/// Get friends currently in a joinable session (rich presence "connect" key set), answered from the cache.
+	/// </summary>
+	/// <param name="Friends"> Out joinable friends. </param>
+	/// <returns> Returns true if roster and rich presence cache are initialized. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem rich presence functions")
+	bool GetJoinableFriends(TArray<FFriendRosterEntry>& Friends);
+
+	// Fired when cached rich presence of a friend changed.
+	UPROPERTY(BlueprintAssignable, Category = "Online Subsystem rich presence functions")
+	FOnFriendRichPresenceChanged OnFriendRichPresenceChanged;
+
+#pragma endregion RichPresence
+
+#pragma region FriendsGroups
+
+	/// <summary>
+	/// Get Steam friends groups (tags) of local user, from an index read from SteamAPI at most once per minute.
+	/// </summary>
+	/// <param name="Groups"> Out groups. </param>
+	/// <param name="bForceRefresh"> If the index should be read again from SteamAPI now (e.g. groups edited in Steam client). </param>
+	/// <returns> Returns true if the index is available. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem friends group functions")
+	bool GetFriendsGroups(TArray<FFriendsGroup>& Groups, const bool bForceRefresh = false);
+
+	/// <summary>
+	/// Get members of a friends group, answered from the index and the roster.
+	/// </summary>
+	/// <param name="GroupID"> GroupID of the group. </param>
+	/// <param name="Members"> Out friends data. </param>
+	/// <param name="bOnlineOnly"> If only online friends (better: not offline) should be returned. </param>
+	/// <returns> Returns true if GroupID is a group. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem friends group functions")
+	bool GetFriendsGroupMembers(const int32 GroupID, TArray<FFriendRosterEntry>& Members, const bool bOnlineOnly = false);
+
+	/// <summary>
+	/// Get groups a friend belongs to, answered from the index.
+	/// </summary>
+	/// <param name="SteamID"> SteamID (AccountID) of the friend. </param>
+	/// <param name="GroupIDs"> Out GroupIDs. </param>
+	/// <returns> Returns true if the index is available. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem friends group functions")
+	bool GetFriendGroups(const int32 SteamID, TArray<int32>& GroupIDs);
+
+	/// <summary>
+	/// Same as GetPlayersDataProgressive, but only for members of a friends group: avatars of other friends are not loaded.
+	/// </summary>
+	/// <param name="GroupID"> GroupID of the group. </param>
+	/// <param name="bAlphabeticalSort"> If TArray elements should be alphabetically sorted using their nicknames. </param>
+	/// <param name="Callback"> Callback to be bound in BP/C++. </param>
+	/// <param name="AvatarSize"> Steam avatar tier to reach. Auto picks it from PixelSize. </param>
+	/// <param name="PixelSize"> On-screen size of the avatar, used only by Auto. </param>
+	/// <returns> int32 flag. 0 means error, 1 means result correct. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem friends group functions")
+	int32 GetFriendsGroupPlayersData(const int32 GroupID, const bool bAlphabeticalSort, const FOnFriendsDataReady& Callback, const EAvatarSize AvatarSize = EAvatarSize::AVATAR_MEDIUM, const int32 PixelSize = 0);
+
+#pragma endregion FriendsGroups
+
+#pragma region RecentPlayers
+
+	/// <summary>
+	/// Get players met in sessions, recorded automatically and persisted between runs. Names are the last known ones
+	/// and avatars are already requested, so a re-invite screen can be shown immediately.
+	/// </summary>
+	/// <param name="Players"> Out players, most recent first. </param>
+	/// <param name="MaxPlayers"> Max number of Players. Negative means all of them. </param>
+	/// <param name="AvatarSize"> Steam avatar tier to reach. Auto picks it from PixelSize. </param>
+	/// <param name="PixelSize"> On-screen size of the avatar, used only by Auto. </param>
+	/// <returns> Returns true if recent players are available. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem recent players functions")
+	bool GetRecentPlayers(TArray<FRecentPlayer>& Players, const int32 MaxPlayers = 20, const EAvatarSize AvatarSize = EAvatarSize::AVATAR_MEDIUM, const int32 PixelSize = 0);
+
+	/// <summary>
+	/// Forget every recent player, also on disk. Steam own coplay list is not affected.
+	/// </summary>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem recent players functions")
+	void ClearRecentPlayers();
+
+	// Fired when a player is recorded, or when the name of a recorded player is updated.
+	UPROPERTY(BlueprintAssignable, Category = "Online Subsystem recent players functions")
+	FOnRecentPlayersChanged OnRecentPlayersChanged;
+
+#pragma endregion RecentPlayers
+
+#pragma region UserDirectory
+
+	/// <summary>
+	/// Get name and avatar of any users (e.g. lobby members who are not friends). Users unknown to SteamAPI are requested in batches,
+	/// each user once even if requested by many callers. Callback is fired once every user is resolved or timed out.
+	/// </summary>
+	/// <param name="SteamIDs"> SteamIDs (AccountID) of the users. </param>
+	/// <param name="Callback"> Fired with users data, same order of SteamIDs. </param>
+	/// <param name="AvatarSize"> Steam avatar tier to reach. Auto picks it from PixelSize. </param>
+	/// <param name="PixelSize"> On-screen size of the avatar, used only by Auto. </param>
+	/// <returns> int32 flag. 0 means error, 1 means result correct (Callback already fired), -1 means in loading waiting for STEAMAPI. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem user directory functions")
+	int32 ResolveUsers(const TArray<int32>& SteamIDs, const FOnFriendsDataReady& Callback, const EAvatarSize AvatarSize = EAvatarSize::AVATAR_MEDIUM, const int32 PixelSize = 0);
+
+	// Fired when name or avatar of a resolved user arrived or changed.
+	UPROPERTY(BlueprintAssignable, Category = "Online Subsystem user directory functions")
+	FOnUserDataChanged OnUserDataChanged;
+
+#pragma endregion UserDirectory
+
+#pragma region LobbyBrowser
+
+	/// <summary>
+	/// Search lobbies. Results are streamed as they arrive: Callback is fired for every batch of new lobbies,
+	/// near ones first, and a last time with bIsComplete. A new search cancels the running one.
+	/// </summary>
+	/// <param name="Parameters"> Filters and max number of lobbies. </param>
+	/// <param name="Callback"> Fired with each batch of lobbies. Not fired anymore once the search is cancelled. </param>
+	/// <returns> SearchID passed to Callback. 0 means error. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem lobby browser functions")
+	int32 FindLobbies(const FLobbySearchParameters& Parameters, const FOnLobbiesFound& Callback);
+
+	/// <summary>
+	/// Cancel the running lobby search, if any.
+	/// </summary>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem lobby browser functions")
+	void CancelLobbySearch();
+
+	/// <summary>
+	/// Get metadata of a lobby, e.g. when its card becomes visible. Requested from STEAMAPI only if not known yet.
+	/// </summary>
+	/// <param name="LobbyID"> LobbyID of a search row. </param>
+	/// <param name="Details"> Out details, valid if result is 1. </param>
+	/// <param name="Callback"> Fired with details when result is -1. </param>
+	/// <returns> int32 flag. 0 means error, 1 means result correct, -1 means in loading waiting for STEAMAPI. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem lobby browser functions")
+	int32 RequestLobbyDetails(const int64 LobbyID, FLobbyDetails& Details, const FOnLobbyDetailsReady& Callback);
+
+#pragma endregion LobbyBrowser
+
 #pragma region SessionManagement
 
 	/// <summary>
 	/// Request the creation of a new session, using localPlayer as new Host.
 	/// Checks for an existing old session, and if found, delete it before creating the new one.
+	/// Session requests are queued and run one after the other: OnSessionOperationComplete reports the result.
 	/// </summary>
 	/// <param name="SessionCreationParameters"> Struct exposed in blueprint containing all datas necessary to create a session. </param>
-	/// <returns></returns>
+	/// <param name="OperationID"> Out handle of the request, reported by OnSessionOperationComplete. </param>
+	/// <returns> Returns True if the request was queued. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem Session functions")
+	bool RequestSessionCreation(struct FSessionCreationParameters SessionCreationParameters, int32& OperationID);
+
+	/// <summary>
+	/// Request the destruction of current session, without travelling.
+	/// </summary>
+	/// <param name="OperationID"> Out handle of the request, reported by OnSessionOperationComplete. </param>
+	/// <returns> Returns True if the request was queued. </returns>
 	UFUNCTION(BlueprintCallable, Category = "Online Subsystem Session functions")
-	bool RequestSessionCreation(struct FSessionCreationParameters SessionCreationParameters);
+	bool RequestSessionDestruction(int32& OperationID);
 
 	/// <summary>
-	/// Invite a friend to an existing session.
+	/// Invite a friend to current session. Sent once queued session requests (e.g. creation) are completed.
 	/// </summary>
 	/// <param name="SteamID"> SteamID to send invite to. The type is int32 in order to be used in blueprints. </param>
-	/// <returns> Returns True if invite request was successfull. </returns>
+	/// <param name="OperationID"> Out handle of the request, reported by OnSessionOperationComplete. </param>
+	/// <returns> Returns True if invite request was queued. </returns>
 	UFUNCTION(BlueprintCallable, Category = "Online Subsystem Session functions")
-	bool InviteFriend(const int32 SteamID);
+	bool InviteFriend(const int32 SteamID, int32& OperationID);
 
 	/// <summary>
 	/// Travel back to a default map and quit current session.
 	/// </summary>
 	/// <param name="TravelBackMapPath"> Absolute path (/game/..) of map to travel to. </param>
+	/// <param name="OperationID"> Out handle of the request, reported by OnSessionOperationComplete. 0 if not queued. </param>
 	UFUNCTION(BlueprintCallable, Category = "Online Subsystem Session functions")
-	void QuitSession(const FString& TravelBackMapPath);
+	void QuitSession(const FString& TravelBackMapPath, int32& OperationID);
 
 	/// <summary>
 	/// Get current session parameters.
@@ -195,13 +628,23 @@ public:
 
 	/// <summary>
 	/// Update current session parameters. Ensure to be Authority.
+	/// Only parameters different from the session are sent. Updates requested within the update window are merged
+	/// and sent once: every Callback is invoked when the merged update completes.
 	/// </summary>
 	/// <param name="Requester"> Requester (Actor) whose autority is checked. </param>
 	/// <param name="SessionParameters"> Session parameters. </param>
-	/// <param name="Callback"> Callback invoked when update is finished. </param>
-	/// <returns> Returns True if parameters request was successfull. </returns>
+	/// <param name="Callback"> Callback invoked when update is finished, successfully or not. </param>
+	/// <param name="OperationID"> Out handle of the request, reported by OnSessionOperationComplete. </param>
+	/// <returns> Returns True if parameters request was queued. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem Session functions")
+	bool UpdateSessionParameters_AuthorityOnly(const AActor* Requester, const FUpdateSessionParameters& SessionParameters, const FOnSessionParametersUpdateReady& Callback, int32& OperationID);
+
+	/// <summary>
+	/// Set how long a session parameters update waits for other updates to merge with. Default is 0.25 seconds.
+	/// </summary>
+	/// <param name="Seconds"> Window in seconds. 0 sends every update as soon as possible. </param>
 	UFUNCTION(BlueprintCallable, Category = "Online Subsystem Session functions")
-	bool UpdateSessionParameters_AuthorityOnly(const AActor* Requester, const FUpdateSessionParameters& SessionParameters, const FOnSessionParametersUpdateReady& Callback);
+	void SetSessionUpdateWindow(const float Seconds);
 	
 	/// <summary>
 	/// Check is session is valid and joinable. 
@@ -211,6 +654,38 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Online Subsystem Session functions")
 	bool IsSessionJoinable() const;
 
+	/// <summary>
+	/// Search sessions and join the closest one with free slots, ranked by ping estimated from host ping location.
+	/// Sessions with unknown ping are joined only if none with known ping passes MaxPingMs.
+	/// </summary>
+	/// <param name="MaxPingMs"> Skip sessions whose estimated ping (ms) is higher. 0 means no filter. </param>
+	/// <param name="Callback"> Callback invoked when join is finished, successfully or not, with ping of joined session (-1 if unknown). </param>
+	/// <returns> Returns True if the search was started. False if a quick join is already running. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem Session functions")
+	bool QuickJoinSession(const int32 MaxPingMs, const FOnQuickJoinComplete& Callback);
+
+	/// <summary>
+	/// Check if a session request is running or waiting.
+	/// </summary>
+	/// <returns> Returns True while session requests are computed. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem Session functions")
+	bool IsSessionBusy() const;
+
+	// Fired for every completed session request, also for joins started by accepted invites.
+	UPROPERTY(BlueprintAssignable, Category = "Online Subsystem Session functions")
+	FOnSessionOperationComplete OnSessionOperationComplete;
+
+	/// <summary>
+	/// Get Steam relay network readiness. Relays are warmed up at startup; session creation and joins wait them.
+	/// </summary>
+	/// <returns> Current relay network state. </returns>
+	UFUNCTION(BlueprintCallable, Category = "Online Subsystem Session functions")
+	ERelayNetworkState GetRelayNetworkState() const;
+
+	// Fired when relay network readiness changes, e.g. to enable host/join buttons once ready.
+	UPROPERTY(BlueprintAssignable, Category = "Online Subsystem Session functions")
+	FOnRelayNetworkStateChange OnRelayNetworkStateChanged;
+
 #pragma endregion SessionManagement
 
 private:
@@ -224,18 +699,81 @@ private:
 	// Unique instance of this class.
 	static UPNetworkingInstanceSteam* NetInstanceSteamPtr;
 
-	// Settings established of current session, accessible by the host, set during creation.
-	// They're not updated. Use "GetSessionParameters()" to get them.
-	FOnlineSessionSettings TempCreationSessionSettings;
+	// Queue and state machine of session requests.
+	TSharedPtr<FSessionOrchestrator> SessionOrchestrator;
+
+	// Streamed lobby searches and lazy lobby metadata.
+	TSharedPtr<FLobbyBrowser> LobbyBrowser;
+
+	// Running quick join search, null if none.
+	TSharedPtr<FOnlineSessionSearch> QuickJoinSearch;
+	int32 QuickJoinMaxPingMs;
+	FOnQuickJoinComplete QuickJoinCallback;
 
-	// Datas communicated by last invite acception.
-	FOnlineSessionSearchResult LastInviteResult;
+	// LRU cache of avatar textures, shared by every avatar request.
+	TSharedPtr<FAvatarCache> AvatarCache;
 
-	// Last map path to travel after SessionCreation.
-	FString MapPathToTravel;
+	// Textures removed from AvatarCache, reused by next avatars once unreferenced.
+	TSharedPtr<FAvatarTexturePool> AvatarTexturePool;
 
-	// Temp var used to checks during invites (to distinguish between inSession/outSession). DO NOT USE IT.
-	ELocalSessionState TempPrevSessionState;
+	// Avatars of previous sessions, persisted in Saved folder.
+	TSharedPtr<FAvatarDiskCache> AvatarDiskCache;
+
+	// Builds avatar textures off the GameThread.
+	TSharedPtr<FAvatarPipeline> AvatarPipeline;
+
+	// Pages of friends avatars used by UI lists.
+	TSharedPtr<FAvatarAtlas> AvatarAtlas;
+
+	// Friends of local user, kept updated by SteamAPI callbacks.
+	TSharedPtr<FFriendRoster> FriendRoster;
+
+	// Collation ranks and n-grams of friend names, rebuilt lazily when the roster changes.
+	TSharedPtr<FFriendNameIndex> FriendNameIndex;
+
+	// Rich presence of friends, updated by SteamAPI callbacks.
+	TSharedPtr<FRichPresenceCache> RichPresenceCache;
+
+	// Friends groups and their members, read lazily.
+	TSharedPtr<FFriendsGroupIndex> FriendsGroupIndex;
+
+	// Persona data of every user met, friend or not.
+	TSharedPtr<FUserDirectory> UserDirectory;
+
+	// Players met in sessions, persisted in Saved folder.
+	TSharedPtr<FRecentPlayers> RecentPlayers;
+
+	// Names of an Online Subsystem friends list, shared by every caller until TTL expires.
+	struct FFriendListNamesCacheEntry
+	{
+		TArray<FString> Names;
+		double ReadTime; // Platform time of last successful read, 0 if never read or invalidated.
+		bool bIsReading;
+		TArray<FOnFriendsListReady> Waiters; // Callers waiting the running read.
+
+		FFriendListNamesCacheEntry() : ReadTime(0.0), bIsReading(false) {}
+	};
+
+	// Friends list names by LocalUserNum and list type.
+	TMap<uint64, FFriendListNamesCacheEntry> FriendListNamesCache;
+	double FriendListNamesCacheTTL;
+
+	// Order of last range requested by a list view, reused while scrolling.
+	TSharedPtr<FFriendListView> FriendListView;
+
+	// Avatar handles of rows around last range, kept alive so they are fetched before being scrolled to.
+	UPROPERTY(Transient)
+	TArray<UProgressiveAvatar*> PrefetchedAvatars;
+
+	// Blueprint handle of last roster snapshot, shared by every caller of the same version.
+	UPROPERTY(Transient)
+	UFriendListSnapshot* FriendListSnapshot;
+
+	// Avatar handles upgraded in place, from placeholder to requested tier.
+	TSharedPtr<FProgressiveAvatarProvider> ProgressiveAvatarProvider;
+
+	// Friendlist resolutions waiting for SteamAPI avatars.
+	TArray<TSharedRef<FFriendsAvatarResolver>> ActiveFriendsAvatarResolvers;
 
 #pragma endregion PrivateVariables
 
@@ -249,33 +787,27 @@ private:
 #pragma region DelegatesHandle
 	
 	// Delegate handles used to save callbacks registration, or unregister them.
-	FDelegateHandle CreateSessionCompleteDelegateHandle; 
-	FDelegateHandle JoinSessionCompleteDelegateHandle; 
 	FDelegateHandle SessionUserInviteAcceptedDelegateHandle; 
 	FDelegateHandle OnNetworkFailureDelegateHandle; 
-	FDelegateHandle OnDestroySessionCompleteFromNewHostingUserHandle; 
-	FDelegateHandle OnClientDestroySessionCompleteHandle;
-	FDelegateHandle OnClientNewInviteAcceptionDestroySessionCompleteHandle;
-	FDelegateHandle OnSessionParametersUpdateReadyDelegateHandle;
+	FDelegateHandle QuickJoinFindSessionsDelegateHandle;
+	FDelegateHandle RelayNetworkStateChangedHandle;
+	FTSTicker::FDelegateHandle RecentPlayersScanHandle;
 
 #pragma endregion DelegatesHandle
 
 #pragma region PrivateUtilityFunctions
 
 	// Friendlist.
-	int32 GetOnlineFriendsFromFriendCount(const int32 FriendsCount);
-	bool GetFriendList(const FOnFriendsListReady& Callback, const EFriendsLists::Type Query, const int32 LocalUserNum = 0);
+	bool GetFriendList(const FOnFriendsListReady& Callback, const EFriendsLists::Type Query, const int32 LocalUserNum = 0, const bool bForceRefresh = false);
+	void InvalidateFriendListNamesCache();
 	void AlphabeticalSortFriends(TArray<FUserSteamData>& FriendsToSort);
+	const FFriendNameIndex* GetFriendNameIndex();
+	const FFriendsGroupIndex* GetFriendsGroupIndex(const bool bForceRefresh = false);
 
 	// Utility and identification.
 	bool ConvertCSteamIDToFUniqueNetID(const CSteamID SteamID, FUniqueNetIdPtr& CorrespondanceNetID);
 	CSteamID ConvertInt32toCSteamID(const int32 SteamID);
 
-	// Session.
-	bool HandleOldSessionIfExisting();
-	void DestroySession();
-	void CreateSession();
-
 	// Plugin instance management.
 	bool InitializeNetworkingInstance();
 	void DeInitializeNetworkingInstance();
@@ -284,40 +816,32 @@ private:
 
 #pragma region CallbackFunctions
 
-	// Fired when a new session has been created.
-	void OnCreateSessionComplete(FName NewName, bool bWasSuccessfull);
-
 	// Fired when User accepts an invite.
 	void OnInviteAccepted(bool bWasSuccessful, int32 LocalUserNum, FUniqueNetIdPtr FriendID, const FOnlineSessionSearchResult& InviteResult);
 
-	// Fired when successfully joined an existing session.
-	void OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result);
-
 	/* Fired when a network failure is called from GameInstance (session socket is invalid).
 	Usually called on clients when host crashes for any reason. */
 	void OnNetworkFailure(UWorld* World, UNetDriver* NetDriver, ENetworkFailure::Type FailureType, const FString& ErrorString);
-	
-	/* Fired when User wants to create a new Session (becoming host).
-	Old session, if existing, has been deleted in order to prevent errors. */
-	void OnDestroySessionCompleteFromNewHostingUser(FName SessionName, bool bWasSuccessfull);
 
-	// Fired when client needs to destroy and unregister local session datas, due to crash or quit.
-	void OnClientDestroySessionComplete(FName SessionName, bool bWasSuccessfull);
+	// Fired when quick join search is complete: joins the closest session found.
+	void OnQuickJoinSearchComplete(bool bWasSuccessful);
 
-	// Fired when client needs to destroy and unregister local session datas, due to invite acception to another session.
-	void OnClientNewInviteAcceptionDestroySessionComplete(FName SessionName, bool bWasSuccessfull);
+	// Fired every RECENT_PLAYERS_SCAN_INTERVAL seconds: records players of current session as recent players.
+	bool OnRecentPlayersScan(float DeltaTime);
 
 #pragma endregion CallbackFunctions
 
 #pragma region SteamworksFunctions
 
-	UTexture2D* GetAvatar(const CSteamID SteamID, int32& QueryResult);
-
 	// Recursive async callbacks on GameThread. Used to get avatars from async STEAMWORKS_API sdk.
-	int32 GetLocalUserAvatarRecursive(TSharedPtr<FOnLocalAvatarReady> Callback);
-	int32 GetRequestedFriendAvatarRecursive(const CSteamID SteamID, TSharedPtr<FOnRequestedFriendAvatarReady> Callback);
-	int32 GetFriendsAvatarRecursive(TSharedPtr<FOnFriendsAvatarReady> Callback);
-	int32 GetPlayerDataRecursive(const bool bAlphabeticalSort, TSharedPtr<FOnFriendsDataReady> Callback);
+	int32 GetLocalUserAvatarRecursive(const EAvatarSize AvatarSize, TSharedPtr<FOnLocalAvatarReady> Callback);
+	int32 GetRequestedFriendAvatarRecursive(const CSteamID SteamID, const EAvatarSize AvatarSize, TSharedPtr<FOnRequestedFriendAvatarReady> Callback);
+
+	// Incremental friendlist avatars resolution. Only avatars named by AvatarImageLoaded callbacks are fetched again.
+	int32 ResolveFriendsAvatar(const float TimeoutSeconds, const EAvatarSize AvatarSize, TSharedPtr<FOnFriendsAvatarReady> Callback);
+	int32 ResolvePlayersData(const bool bAlphabeticalSort, const float TimeoutSeconds, const EAvatarSize AvatarSize, TSharedPtr<FOnFriendsDataReady> Callback);
+	int32 ResolveFriendsAvatarAtlas(const float TimeoutSeconds, const EAvatarSize AvatarSize, TSharedPtr<FOnFriendsAvatarAtlasReady> Callback);
+	int32 StartFriendsAvatarResolver(TSharedRef<FFriendsAvatarResolver> Resolver, const float TimeoutSeconds);
 
 #pragma endregion SteamworksFunctions
 	
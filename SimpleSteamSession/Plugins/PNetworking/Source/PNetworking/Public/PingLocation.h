@@ -0,0 +1,48 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Session setting and lobby data key with host ping location, as written by ConvertPingLocationToString.
+#define SESSION_PING_LOCATION_KEY "PINGLOCATION"
+
+// Ping of a host without (or with an unreadable) ping location, or when local relay data is not ready yet.
+#define PING_LOCATION_UNKNOWN -1
+
+class FOnlineSessionSearchResult;
+
+/*
+	Host distance estimated with Steam Datagram Relay ping locations, without pinging anything.
+	Hosts publish their location string in session/lobby data; clients parse it and estimate the round trip
+	through the relay network (ISteamNetworkingUtils::EstimatePingTimeFromLocalHost).
+	Hosts without location are kept by filters and ranked last: they may be near, we just can't tell.
+	GameThread only.
+*/
+class PNETWORKING_API FPingLocation
+{
+public:
+
+	// Local ping location as a string. Returns false if relay network data is not available yet.
+	static bool GetLocalLocationString(FString& OutLocation);
+
+	// Estimated ping (ms) to a host location string, or PING_LOCATION_UNKNOWN.
+	static int32 EstimatePingMs(const FString& Location);
+
+	// Estimated ping (ms) to the host of a lobby, read from its lobby data, or PING_LOCATION_UNKNOWN.
+	static int32 EstimateLobbyPingMs(const uint64 LobbyID);
+
+	// Estimated ping (ms) to the host of an OSS search result, or PING_LOCATION_UNKNOWN.
+	static int32 EstimateSessionPingMs(const FOnlineSessionSearchResult& SearchResult);
+
+	// True if a ping passes a max ping filter. MaxPingMs <= 0 means no filter; unknown pings always pass.
+	static bool IsWithinMaxPing(const int32 PingMs, const int32 MaxPingMs);
+
+	// Ranking order: lower pings first, unknown pings last.
+	static bool IsCloser(const int32 PingMs, const int32 OtherPingMs);
+
+	// Joinable search results passing MaxPingMs, closest first, as pairs of index in SearchResults and ping.
+	static void RankSessions(const TArray<FOnlineSessionSearchResult>& SearchResults, const int32 MaxPingMs, TArray<TPair<int32, int32>>& OutRanking);
+};
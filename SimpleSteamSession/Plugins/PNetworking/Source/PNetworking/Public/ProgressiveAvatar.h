@@ -0,0 +1,112 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/GCObject.h"
+#include "AvatarCache.h"
+#include "ProgressiveAvatar.generated.h"
+
+// Side of the shared placeholder texture. Widgets use their own brush size, so no relayout happens on upgrade.
+#define PROGRESSIVE_AVATAR_PLACEHOLDER_SIZE 4
+
+// Grey level of the shared placeholder texture.
+#define PROGRESSIVE_AVATAR_PLACEHOLDER_GREY 96
+
+class CSteamID;
+class UTexture2D;
+class FAvatarPipeline;
+class UProgressiveAvatar;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnProgressiveAvatarChanged, UProgressiveAvatar*, Avatar);
+
+/*
+	Handle of a user avatar that is usable from the first frame.
+	It starts with the shared placeholder (or the best tier already available), then its texture is
+	upgraded in place, small tier first, until the requested tier arrives. OnChanged fires on each upgrade.
+*/
+UCLASS(BlueprintType, meta=(NotBlueprintable))
+class PNETWORKING_API UProgressiveAvatar : public UObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UProgressiveAvatar();
+
+	UPROPERTY(BlueprintReadOnly, Category = "ProgressiveAvatar", meta = (ToolTip = "SteamID (AccountID) of the user."))
+	int32 SteamID;
+
+	UPROPERTY(BlueprintReadOnly, Category = "ProgressiveAvatar", meta = (ToolTip = "Best texture available now. Never null: placeholder until the first tier arrives."))
+	UTexture2D* Texture;
+
+	UPROPERTY(BlueprintReadOnly, Category = "ProgressiveAvatar", meta = (ToolTip = "Tier of current texture. Meaningless while placeholder."))
+	EAvatarSize AvatarSize;
+
+	UPROPERTY(BlueprintReadOnly, Category = "ProgressiveAvatar", meta = (ToolTip = "Requested tier."))
+	EAvatarSize TargetSize;
+
+	UPROPERTY(BlueprintReadOnly, Category = "ProgressiveAvatar", meta = (ToolTip = "True until a real avatar texture is available."))
+	bool bIsPlaceholder;
+
+	UPROPERTY(BlueprintReadOnly, Category = "ProgressiveAvatar", meta = (ToolTip = "True when the requested tier from SteamAPI is shown. It can still change if the user changes avatar."))
+	bool bIsFinal;
+
+	// Fired on GameThread every time Texture changes.
+	UPROPERTY(BlueprintAssignable, Category = "ProgressiveAvatar")
+	FOnProgressiveAvatarChanged OnChanged;
+};
+
+/*
+	Creates progressive avatar handles and keeps upgrading them.
+	Handles are owned by their users (widgets, FUserSteamData): the provider only keeps weak references,
+	so handles nobody uses anymore are collected and never upgraded.
+	One handle per user is shared by every caller.
+*/
+class PNETWORKING_API FProgressiveAvatarProvider : public FGCObject, public TSharedFromThis<FProgressiveAvatarProvider>
+{
+public:
+
+	FProgressiveAvatarProvider(TSharedPtr<FAvatarPipeline> InAvatarPipeline);
+	virtual ~FProgressiveAvatarProvider();
+
+	// Get the handle of a user avatar, with the best texture available now. GameThread only.
+	UProgressiveAvatar* Acquire(const CSteamID SteamID, const EAvatarSize TargetSize);
+
+	// Texture shown by handles without any avatar tier yet.
+	UTexture2D* GetPlaceholder() const;
+
+	// FGCObject interface.
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	virtual FString GetReferencerName() const override;
+
+private:
+
+	// Request every tier still missing, from the smallest. Tiers not downloaded yet wake it up again.
+	void Refine(const uint64 SteamID);
+
+	// Show Texture if it is better than the current one.
+	void ApplyTexture(const uint64 SteamID, UTexture2D* NewTexture, const EAvatarSize NewSize, const bool bIsLive);
+
+	// Fired by the pipeline for new or changed avatars.
+	void OnTextureUpdated(const uint64 SteamID, const EAvatarSize NewSize, UTexture2D* NewTexture);
+
+	void AddAvatarWaiter(const uint64 SteamID);
+	void PruneStaleAvatars();
+	void CreatePlaceholder();
+
+	TSharedPtr<FAvatarPipeline> AvatarPipeline;
+
+	UTexture2D* Placeholder;
+
+	// Handles alive, by 64 bits SteamID.
+	TMap<uint64, TWeakObjectPtr<UProgressiveAvatar>> Avatars;
+	int32 NextPruneNum;
+
+	// Users with an AvatarImageLoaded waiter already registered.
+	TSet<uint64> WaitingSteamIDs;
+
+	FDelegateHandle TextureUpdatedHandle;
+};
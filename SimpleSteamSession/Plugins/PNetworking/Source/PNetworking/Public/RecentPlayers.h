@@ -0,0 +1,133 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "Containers/Ticker.h"
+#include "RecentPlayers.generated.h"
+
+// Ring buffer file, relative to project Saved directory. Keyed by local SteamID.
+#define RECENT_PLAYERS_FILE_NAME TEXT("PNetworking/RecentPlayers_%llu.bin")
+
+// Max number of players remembered.
+#define RECENT_PLAYERS_CAPACITY 64
+
+// File header identifier and format version.
+#define RECENT_PLAYERS_MAGIC 0x59504352
+#define RECENT_PLAYERS_VERSION 1
+
+// Seconds between two scans of current session players.
+#define RECENT_PLAYERS_SCAN_INTERVAL 5.0f
+
+class SteamAPICallbackManager;
+class UProgressiveAvatar;
+
+// A player met in a session. It is made in order to use it in blueprints.
+USTRUCT(BlueprintType)
+struct FRecentPlayer
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "RecentPlayers")
+	int32 SteamID; // Blueprint not supported "uint32", so we need to do some casts.
+
+	UPROPERTY(BlueprintReadOnly, Category = "RecentPlayers", meta = (ToolTip = "Last known name. Persisted, so it is available before SteamAPI answers."))
+	FText UserName;
+
+	UPROPERTY(BlueprintReadOnly, Category = "RecentPlayers", meta = (ToolTip = "Last time (UTC) the player was seen in a session with local user."))
+	FDateTime LastPlayed;
+
+	UPROPERTY(BlueprintReadOnly, Category = "RecentPlayers")
+	bool bIsFriend;
+
+	UPROPERTY(BlueprintReadOnly, Category = "RecentPlayers", meta = (ToolTip = "Avatar upgraded in place as it arrives."))
+	UProgressiveAvatar* Avatar;
+
+	FRecentPlayer() : SteamID(0), UserName(FText::GetEmpty()), bIsFriend(false), Avatar(nullptr) {}
+};
+
+// Delegate fired on GameThread when a player is recorded or a recorded name changed.
+DECLARE_MULTICAST_DELEGATE(FOnRecentPlayersListChanged)
+
+/*
+	Players met in sessions, kept in a fixed size buffer persisted in Saved folder: when full, the least recently played is overwritten.
+	Each new co-player is reported to Steam with SetPlayedWith (so it also appears in Steam "Recent games" list)
+	and its persona is requested with RequestUserInformation: names are updated in the background by
+	PersonaStateChange_t, so the list is ready when a re-invite screen opens.
+	Steam coplay list is merged at startup, to know players of sessions played before this plugin version.
+	GameThread only.
+*/
+class PNETWORKING_API FRecentPlayers
+{
+public:
+
+	struct FRecord
+	{
+		uint64 SteamID;
+		FDateTime LastPlayed; // UTC.
+		FString UserName;
+	};
+
+	FRecentPlayers();
+	~FRecentPlayers();
+
+	// Read the ring buffer file, merge Steam coplay list and start listening to SteamAPI. Returns false if SteamAPI is not available.
+	bool Initialize();
+
+	// Write the ring buffer file, if changed.
+	bool Save();
+
+	// Record a co-player of current session. Returns false if already recorded in this session.
+	bool Record(const uint64 SteamID);
+
+	// Next Record calls start a new session: players are recorded again with a new time.
+	void EndSession();
+
+	// Remove every player, also from the file.
+	void Clear();
+
+	// Recorded players, most recent first.
+	void GetPlayers(TArray<const FRecord*>& OutRecords, const int32 MaxPlayers) const;
+
+	int32 Num() const;
+
+	FOnRecentPlayersListChanged OnChanged;
+
+private:
+
+	typedef TQueue<uint64, EQueueMode::Mpsc> FDirtyQueue;
+
+	bool Load();
+
+	bool Tick(float DeltaTime);
+
+	// Write a record: in place if already there, else on a free slot or over the least recently played one.
+	void Put(const uint64 SteamID, const FDateTime LastPlayed);
+
+	// Read current name from SteamAPI. Returns true if it changed.
+	bool ReadName(FRecord& Record);
+
+	FString GetFilePath() const;
+
+	// Fixed size buffer of RECENT_PLAYERS_CAPACITY slots, never reallocated.
+	TArray<FRecord> Slots;
+	TMap<uint64, int32> SlotBySteamID;
+
+	// Players recorded since last EndSession.
+	TSet<uint64> SessionSteamIDs;
+
+	// Owner of the list, read once so the file can be saved even after SteamAPI shutdown.
+	uint64 LocalSteamID;
+
+	bool bIsDirty;
+
+	// Shared with SteamAPI callbacks, so it stays valid even if this is destroyed while they run.
+	TSharedRef<FDirtyQueue, ESPMode::ThreadSafe> DirtySteamIDs;
+
+	TWeakPtr<SteamAPICallbackManager> SteamAPIManager;
+	FDelegateHandle PersonaStateChangedHandle;
+	FTSTicker::FDelegateHandle TickHandle;
+};
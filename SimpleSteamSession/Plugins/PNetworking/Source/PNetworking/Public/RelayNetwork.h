@@ -0,0 +1,74 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "RelayNetwork.generated.h"
+
+// Seconds between two reads of relay network status while it is not ready.
+#define RELAY_NETWORK_POLL_INTERVAL 0.25f
+
+// Seconds between two reads of relay network status once ready: only a lost network is watched for.
+#define RELAY_NETWORK_READY_POLL_INTERVAL 5.0f
+
+// Seconds after which a warm up not completed is reported as unavailable, so waiters are never stalled.
+#define RELAY_NETWORK_WARMUP_TIMEOUT 15.0
+
+// Readiness of Steam Datagram Relay network for this process.
+UENUM(BlueprintType)
+enum class ERelayNetworkState : uint8
+{
+	RELAY_NOT_STARTED	UMETA(DisplayName = "Not started"),
+	RELAY_WARMING		UMETA(DisplayName = "Warming"),
+	RELAY_READY			UMETA(DisplayName = "Ready"),
+	RELAY_UNAVAILABLE	UMETA(DisplayName = "Unavailable")
+};
+
+// Delegate fired on GameThread when relay network state changed.
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnRelayNetworkStateChanged, ERelayNetworkState /*State*/)
+
+/*
+	Steam Datagram Relay warm up, started with the module instead of by the first P2P connection.
+	InitRelayNetworkAccess downloads network config and measures ping to relays in background:
+	it takes seconds, and the net driver would otherwise wait it inside the first connection.
+	- Ready once relays are reachable and the local ping location is known (needed to publish host location).
+	- Unavailable if SteamAPI gives up or warm up takes more than RELAY_NETWORK_WARMUP_TIMEOUT;
+	  state still goes to ready if relays answer later.
+	Status is polled: it is a local read, cheaper than routing SteamRelayNetworkStatus_t through the OSS thread.
+	Once ready, polling slows down to RELAY_NETWORK_READY_POLL_INTERVAL.
+	GameThread only.
+*/
+class PNETWORKING_API FRelayNetwork
+{
+public:
+
+	FRelayNetwork();
+	~FRelayNetwork();
+
+	// Start warm up. Returns false if SteamAPI is not available yet: it can be called again later.
+	bool Start();
+
+	ERelayNetworkState GetState() const;
+
+	// True if there is nothing to wait: ready, unavailable, or never started (SteamAPI not available).
+	bool IsSettled() const;
+
+	FOnRelayNetworkStateChanged OnStateChanged;
+
+private:
+
+	bool Tick(float DeltaTime);
+
+	void SetState(const ERelayNetworkState NewState);
+
+	// Interval TickHandle was added with.
+	float GetPollInterval() const;
+
+	ERelayNetworkState State;
+	double StartTime;
+	FTSTicker::FDelegateHandle TickHandle;
+	float PollInterval;
+};
@@ -0,0 +1,93 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "Containers/Ticker.h"
+
+// Max RequestFriendRichPresence calls sent per frame. Others wait the next frames.
+#define RICH_PRESENCE_REQUESTS_PER_TICK 16
+
+// Seconds before a friend already requested can be requested again. SteamAPI pushes updates meanwhile.
+#define RICH_PRESENCE_REQUEST_COOLDOWN 60.0
+
+// Rich presence key set by games when the user can be joined (launch parameters to connect).
+#define RICH_PRESENCE_CONNECT_KEY "connect"
+
+class CSteamID;
+class SteamAPICallbackManager;
+
+// Delegate fired on GameThread when cached rich presence of a user changed.
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnRichPresenceChanged, uint64 /*SteamID*/)
+
+/*
+	Rich presence of friends, read from SteamAPI only when FriendRichPresenceUpdate_t notifies a change.
+	- Requests: RequestFriendRichPresence calls are deduplicated, rate limited per frame and skipped while
+	  a previous request of the same user is recent, so callers can ask for whole lists every frame.
+	- Storage: keys are FNames (shared by every friend), values are kept in a single array per friend.
+	- Joinable friends (non empty "connect" key) are kept in a set updated with the cache,
+	  so that query is answered without calling SteamAPI.
+	GameThread only.
+*/
+class PNETWORKING_API FRichPresenceCache
+{
+public:
+
+	FRichPresenceCache();
+	~FRichPresenceCache();
+
+	// Start listening to SteamAPI, reading rich presence already known for SeedSteamIDs. Returns false if SteamAPI is not available.
+	bool Initialize(const TArray<uint64>& SeedSteamIDs);
+
+	// Queue RequestFriendRichPresence for users not requested recently. Sent in batches by Tick.
+	void Request(TConstArrayView<uint64> SteamIDs);
+
+	// Cached value of Key, or nullptr if not set.
+	const FString* Find(const uint64 SteamID, const FName Key) const;
+
+	// Every cached key/value of a user. Returns false if the user has no cached rich presence.
+	bool GetPairs(const uint64 SteamID, TArray<TPair<FName, FString>>& OutPairs) const;
+
+	// Users whose rich presence has a connect key.
+	const TSet<uint64>& GetJoinableSteamIDs() const;
+
+	int32 GetNumPendingRequests() const;
+
+	FOnRichPresenceChanged OnChanged;
+
+private:
+
+	struct FRichPresence
+	{
+		TArray<TPair<FName, FString>> Pairs;
+
+		// Platform time of last RequestFriendRichPresence, 0 if never requested.
+		double RequestTime;
+
+		FRichPresence() : RequestTime(0.0) {}
+	};
+
+	typedef TQueue<uint64, EQueueMode::Mpsc> FDirtyQueue;
+
+	bool Tick(float DeltaTime);
+
+	// Read every key of a user from SteamAPI. Returns true if something changed.
+	bool Read(const uint64 SteamID);
+
+	TMap<uint64, FRichPresence> Presences;
+	TSet<uint64> JoinableSteamIDs;
+
+	// Requests not sent yet, in request order, and the same SteamIDs for deduplication.
+	TArray<uint64> PendingRequests;
+	TSet<uint64> PendingRequestSet;
+
+	// Shared with SteamAPI callbacks, so it stays valid even if cache is destroyed while they run.
+	TSharedRef<FDirtyQueue, ESPMode::ThreadSafe> DirtySteamIDs;
+
+	TWeakPtr<SteamAPICallbackManager> SteamAPIManager;
+	FDelegateHandle RichPresenceUpdatedHandle;
+	FTSTicker::FDelegateHandle TickHandle;
+};
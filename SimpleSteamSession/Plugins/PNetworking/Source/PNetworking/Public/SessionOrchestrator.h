@@ -0,0 +1,262 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "OnlineSessionSettings.h"
+#include "Interfaces/OnlineSessionInterface.h"
+#include "SessionCreationParameters.h"
+#include "SessionOrchestrator.generated.h"
+
+// Seconds after which a running operation without OSS answer is completed as failed.
+// The queue then waits the late answer (or a session tear down) for the same time again, so it never stalls.
+#define SESSION_OPERATION_TIMEOUT 30.0
+
+// Default seconds an update waits before being sent, so updates requested meanwhile are sent with it.
+#define SESSION_UPDATE_WINDOW 0.25
+
+// Number of state transitions remembered with their timing.
+#define SESSION_TRANSITION_HISTORY 32
+
+enum ELocalSessionState : uint8;
+enum class ERelayNetworkState : uint8;
+class FRelayNetwork;
+
+// Kind of a session operation.
+UENUM(BlueprintType)
+enum class ESessionOperationType : uint8
+{
+	OPERATION_CREATE	UMETA(DisplayName = "Create"),
+	OPERATION_DESTROY	UMETA(DisplayName = "Destroy"),
+	OPERATION_JOIN		UMETA(DisplayName = "Join"),
+	OPERATION_UPDATE	UMETA(DisplayName = "Update"),
+	OPERATION_QUIT		UMETA(DisplayName = "Quit"),
+	OPERATION_INVITE	UMETA(DisplayName = "Invite")
+};
+
+// Result of a session operation. It is made in order to use it in blueprints.
+USTRUCT(BlueprintType)
+struct FSessionOperationResult
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "SessionOperation", meta = (ToolTip = "Handle given when the operation was requested."))
+	int32 OperationID;
+
+	UPROPERTY(BlueprintReadOnly, Category = "SessionOperation", meta = (ToolTip = "Kind of the operation requested. A merged request reports its own kind."))
+	ESessionOperationType Type;
+
+	UPROPERTY(BlueprintReadOnly, Category = "SessionOperation")
+	bool bWasSuccessful;
+
+	UPROPERTY(BlueprintReadOnly, Category = "SessionOperation", meta = (ToolTip = "Seconds waited in queue, behind other operations."))
+	float QueuedSeconds;
+
+	UPROPERTY(BlueprintReadOnly, Category = "SessionOperation", meta = (ToolTip = "Seconds from start to completion, OSS calls and travel request included."))
+	float RunSeconds;
+
+	FSessionOperationResult() : OperationID(0), Type(ESessionOperationType::OPERATION_CREATE), bWasSuccessful(false), QueuedSeconds(0.0f), RunSeconds(0.0f) {}
+};
+
+// A change of local session state, with time spent in previous state.
+struct FSessionTransition
+{
+	ELocalSessionState From;
+	ELocalSessionState To;
+	int32 OperationID; // Operation running when state changed, 0 if none.
+	double Seconds;
+};
+
+// Delegate fired once on GameThread when a requested operation completes.
+DECLARE_DELEGATE_OneParam(FOnSessionOperationDone, const FSessionOperationResult& /*Result*/)
+
+// Delegate fired on GameThread for every completed operation, whoever requested it.
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnSessionOperationCompleted, const FSessionOperationResult& /*Result*/)
+
+/*
+	Single owner of the local named session. OSS session calls are async and share the same session name,
+	so operations (create, destroy, join, update, quit, invite) are serialized:
+	- Requests are queued FIFO and run back to back: a request is never rejected because another one is running.
+	- A request is merged into the last queued one when redundant: destroy followed by create (create destroys the old
+	  session anyway), repeated create/join/update (last parameters win), repeated destroy/quit.
+	  Merged requests keep their handle and callback, and complete with the surviving operation.
+	- Updates only carry fields their caller changed: merged updates keep each other's changes, and an update
+	  waits a short window before being sent, so a burst of changes (e.g. a menu) reaches the backend once.
+	- Create and join wait relay network warm up (FRelayNetwork), so the net driver does not stall on it
+	  and hosts publish their ping location.
+	- Local session state (FPNetworkingModule) only changes through an explicit transition graph. Every transition
+	  and every operation is timed.
+	- An operation timed out is failed to its requests, but its OSS call is still in flight: next operations wait
+	  its late answer, so it can not complete them. A late create/join success is torn down, nobody travelled.
+	GameThread only.
+*/
+class PNETWORKING_API FSessionOrchestrator
+{
+public:
+
+	FSessionOrchestrator();
+	~FSessionOrchestrator();
+
+	// Bind OSS session callbacks. Returns false if OSS session interface is not available.
+	bool Initialize();
+
+	// Requests. Each returns the handle of the operation (reported by its callback), or 0 if OSS is not available.
+	int32 Create(const FOnlineSessionSettings& Settings, const FString& TravelToMapPath, FOnSessionOperationDone Callback = FOnSessionOperationDone());
+	int32 Destroy(FOnSessionOperationDone Callback = FOnSessionOperationDone());
+	int32 Join(const FOnlineSessionSearchResult& SearchResult, FOnSessionOperationDone Callback = FOnSessionOperationDone());
+	int32 Update(const FUpdateSessionParameters& Parameters, FOnSessionOperationDone Callback = FOnSessionOperationDone());
+	int32 Quit(const FString& TravelBackMapPath, FOnSessionOperationDone Callback = FOnSessionOperationDone());
+	int32 Invite(const FUniqueNetIdPtr& FriendNetID, FOnSessionOperationDone Callback = FOnSessionOperationDone());
+
+	// Seconds an update waits for other updates to merge with. 0 sends updates as soon as possible.
+	void SetUpdateWindow(const double Seconds);
+
+	// True while an operation runs or waits.
+	bool IsBusy() const;
+	int32 GetNumQueued() const;
+
+	// Last SESSION_TRANSITION_HISTORY transitions, oldest first.
+	void GetTransitions(TArray<FSessionTransition>& OutTransitions) const;
+
+	FOnSessionOperationCompleted OnOperationCompleted;
+
+private:
+
+	// Step of the running operation waiting an OSS callback.
+	enum class EPhase : uint8
+	{
+		IDLE,
+		WAITING_RELAY,	// Create/Join: waiting relay network warm up.
+		DESTROYING_OLD,	// Create/Join: destroying old session first.
+		CREATING,
+		JOINING,
+		UPDATING,
+		DESTROYING		// Destroy/Quit.
+	};
+
+	// Fields of FUpdateSessionParameters, as bits of an update mask.
+	enum EUpdateField : uint8
+	{
+		UPDATE_NUM_PUBLIC_CONNECTIONS	= 1 << 0,
+		UPDATE_NUM_PRIVATE_CONNECTIONS	= 1 << 1,
+		UPDATE_SHOULD_ADVERTISE			= 1 << 2,
+		UPDATE_ALLOW_JOIN_IN_PROGRESS	= 1 << 3,
+		UPDATE_IS_LAN_MATCH				= 1 << 4,
+		UPDATE_IS_DEDICATED				= 1 << 5,
+		UPDATE_ALLOW_INVITES			= 1 << 6,
+		UPDATE_FIELDS_ALL				= 0x7F
+	};
+
+	struct FRequest
+	{
+		int32 OperationID;
+		ESessionOperationType Type;
+		double EnqueueTime;
+		FOnSessionOperationDone Callback;
+	};
+
+	struct FOperation
+	{
+		ESessionOperationType Type;
+		FOnlineSessionSettings Settings; // Create.
+		FOnlineSessionSearchResult SearchResult; // Join.
+		FUpdateSessionParameters UpdateParameters; // Update.
+		uint8 UpdateMask; // Update: EUpdateField bits changed by requests.
+		FString MapPath; // Create: map to listen on. Quit: map to travel back to.
+		FUniqueNetIdPtr FriendNetID; // Invite.
+		double StartTime;
+
+		// This request and every request merged into it.
+		TArray<FRequest, TInlineAllocator<1>> Requests;
+	};
+
+	int32 Enqueue(TSharedRef<FOperation> Operation, FOnSessionOperationDone Callback);
+
+	// Fold Operation into last queued one if redundant. Returns true if merged.
+	bool TryMerge(FOperation& Operation);
+
+	// Fields of Parameters different from what the session will have once pending operations are run.
+	uint8 GetChangedUpdateFields(const FUpdateSessionParameters& Parameters) const;
+
+	// Copy masked fields from session settings or update parameters to the other. Returns mask of fields whose value changed.
+	template<typename FromType, typename ToType>
+	static uint8 CopyUpdateFields(const FromType& From, const uint8 Mask, ToType& To);
+
+	// Resumes an update held by its window.
+	bool OnUpdateWindowElapsed(float DeltaTime);
+
+	void StartNext();
+	void Run();
+	void RunCreateOrJoin();
+	void RunDestroy();
+	void RunUpdate();
+	void RunQuit();
+	void RunInvite();
+
+	// True if relay network warm up is not running: nothing to wait before create/join.
+	bool IsRelayNetworkSettled() const;
+
+	// Create or Join, once no old session exists.
+	void StartCreate();
+	void StartJoin();
+
+	// Destroy or Quit, once a session exists.
+	void StartDestroy();
+
+	// Complete running operation, notify its requests and start the next one.
+	void Complete(const bool bWasSuccessful);
+
+	// Destroy a session nobody waits anymore (late create/join success, or no answer at all).
+	void TearDownAbandoned();
+
+	// Stop waiting the OSS call of a timed out operation and start the next one.
+	void ResumeAfterAbandoned();
+
+	// Move local session state along the graph. Returns false (state unchanged) if the transition is not allowed.
+	bool Transition(const ELocalSessionState NewState);
+	static bool IsTransitionAllowed(const ELocalSessionState From, const ELocalSessionState To);
+	static const TCHAR* GetStateName(const ELocalSessionState State);
+
+	bool Tick(float DeltaTime);
+
+	// OSS callbacks, bound once for the orchestrator lifetime. Ignored when no operation waits them.
+	// The late answer of a timed out operation is handled apart: it never reaches a newer operation.
+	void OnCreateSessionComplete(FName SessionName, bool bWasSuccessful);
+	void OnDestroySessionComplete(FName SessionName, bool bWasSuccessful);
+	void OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result);
+	void OnUpdateSessionComplete(FName SessionName, bool bWasSuccessful);
+
+	// Resumes create/join waiting relay network.
+	void OnRelayNetworkStateChanged(ERelayNetworkState State);
+
+	// Operations waiting, in request order. Running one is not here.
+	TArray<TSharedRef<FOperation>> Queue;
+	TSharedPtr<FOperation> Running;
+	EPhase Phase;
+
+	// OSS call of a timed out operation still waited (IDLE if none), and when waiting started.
+	EPhase AbandonedPhase;
+	double AbandonTime;
+
+	int32 NextOperationID;
+	double UpdateWindow;
+
+	// Ring buffer of SESSION_TRANSITION_HISTORY transitions.
+	TArray<FSessionTransition> Transitions;
+	int32 NextTransition;
+	double StateEnterTime;
+
+	TWeakPtr<IOnlineSession, ESPMode::ThreadSafe> SessionInterface;
+	FDelegateHandle CreateSessionCompleteHandle;
+	FDelegateHandle DestroySessionCompleteHandle;
+	FDelegateHandle JoinSessionCompleteHandle;
+	FDelegateHandle UpdateSessionCompleteHandle;
+
+	TWeakPtr<FRelayNetwork> RelayNetwork;
+	FDelegateHandle RelayNetworkStateChangedHandle;
+	FTSTicker::FDelegateHandle TickHandle;
+	FTSTicker::FDelegateHandle UpdateWindowHandle;
+};
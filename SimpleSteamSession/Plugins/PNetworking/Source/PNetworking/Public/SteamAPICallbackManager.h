@@ -13,6 +13,7 @@
 #pragma warning(pop)
 
 #include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
 
 /* 
 	This class is used to bind and communicate with STEAMWORKS_API.
@@ -21,25 +22,50 @@
 	UE also uses and has the correct version of steam sdk in its files, but they're not exposed.
 */
 
-// Delegate used to communicate with PNetworkingInstance file.
+// Delegate used to communicate with PNetworkingInstance file. Fired on the thread running SteamAPI callbacks.
 DECLARE_DELEGATE_OneParam(FOnAvatarReadyFromSteamAPI, AvatarImageLoaded_t*)
 
+// Delegates fired on the thread running SteamAPI callbacks when a user persona (name, status, game...) or rich presence changed.
+// Listeners must be thread safe and should only record the SteamID, reading SteamAPI later on GameThread.
+DECLARE_TS_MULTICAST_DELEGATE_TwoParams(FOnPersonaStateChangeFromSteamAPI, uint64 /*SteamID*/, int32 /*EPersonaChange flags*/)
+DECLARE_TS_MULTICAST_DELEGATE_OneParam(FOnRichPresenceUpdateFromSteamAPI, uint64 /*SteamID*/)
+
+// Delegate fired on the thread running SteamAPI callbacks when metadata of a lobby arrived (or the lobby does not exist anymore).
+DECLARE_TS_MULTICAST_DELEGATE_TwoParams(FOnLobbyDataUpdateFromSteamAPI, uint64 /*LobbyID*/, bool /*bSuccess*/)
+
 class PNETWORKING_API SteamAPICallbackManager
 {
 private:
 
 	// Bind to Steamworks callbacks.
 	STEAM_CALLBACK(SteamAPICallbackManager, OnImageAvatarLoadedCallback, AvatarImageLoaded_t);
+	STEAM_CALLBACK(SteamAPICallbackManager, OnPersonaStateChangeCallback, PersonaStateChange_t);
+	STEAM_CALLBACK(SteamAPICallbackManager, OnFriendRichPresenceUpdateCallback, FriendRichPresenceUpdate_t);
+	STEAM_CALLBACK(SteamAPICallbackManager, OnLobbyDataUpdateCallback, LobbyDataUpdate_t);
 
 public:
 
-	// Delegates called when Steam_API notifies relative callbacks.
-	FOnAvatarReadyFromSteamAPI OnAvatarReadyDelegateLocalUser;
-	FOnAvatarReadyFromSteamAPI OnAvatarReadyDelegateFriendList;
-	FOnAvatarReadyFromSteamAPI OnAvatarReadyFriendListData;
-	FOnAvatarReadyFromSteamAPI OnAvatarReadyFriendRequested;
-
 	SteamAPICallbackManager();
 	~SteamAPICallbackManager();
 
+	/* Register a waiter for SteamID avatar, fired once when Steam_API notifies its AvatarImageLoaded callback.
+	Any number of waiters can be registered for the same SteamID: they share the same Steam download.
+	Returns true if it is the first waiter of SteamID. Thread safe. */
+	bool AddAvatarWaiter(const CSteamID SteamID, FOnAvatarReadyFromSteamAPI Waiter);
+
+	// Remove waiters whose owner has been destroyed (SP/UObject bound delegates not bound anymore).
+	void PruneAvatarWaiters();
+
+	int32 GetNumAvatarWaiters() const;
+
+	FOnPersonaStateChangeFromSteamAPI OnPersonaStateChanged;
+	FOnRichPresenceUpdateFromSteamAPI OnRichPresenceUpdated;
+	FOnLobbyDataUpdateFromSteamAPI OnLobbyDataUpdated;
+
+private:
+
+	// Waiters of avatars still downloading, keyed by 64 bit SteamID.
+	TMap<uint64, TArray<FOnAvatarReadyFromSteamAPI>> AvatarWaiters;
+	mutable FCriticalSection AvatarWaitersLock;
+
 };
@@ -0,0 +1,125 @@
+// • Manuel Solano
+// • Alessandro Caccamo
+// • Claudio Dallai
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "Containers/Ticker.h"
+
+// Initial number of slots of the table. Always a power of two.
+#define USER_DIRECTORY_INITIAL_CAPACITY 256
+
+// Max RequestUserInformation calls sent per frame. Others wait the next frames.
+#define USER_DIRECTORY_REQUESTS_PER_TICK 32
+
+// Seconds after which a request without PersonaStateChange_t answer is completed as failed.
+#define USER_DIRECTORY_REQUEST_TIMEOUT 10.0
+
+class SteamAPICallbackManager;
+
+// Fetch state of a user persona.
+enum class EUserFetchState : uint8
+{
+	UNKNOWN,	// Never requested.
+	PENDING,	// Waiting RequestUserInformation answer.
+	READY,		// Name and avatar handle are valid.
+	FAILED		// SteamAPI did not answer in time. Name is the best SteamAPI knew.
+};
+
+// Persona data of a user, friend or not.
+struct FUserDirectoryEntry
+{
+	FString UserName;
+	int32 AvatarHandle;
+	EUserFetchState State;
+	double RequestTime;
+
+	FUserDirectoryEntry() : AvatarHandle(0), State(EUserFetchState::UNKNOWN), RequestTime(0.0) {}
+};
+
+// Delegate fired once on GameThread when every user of a batch is ready or failed.
+DECLARE_DELEGATE_OneParam(FOnUserDirectoryBatchResolved, const TArray<uint64>& /*SteamIDs, same order as requested*/)
+
+// Delegate fired on GameThread when a user is completed or its persona changed.
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnUserDirectoryEntryChanged, uint64 /*SteamID*/)
+
+/*
+	Persona data (name, avatar handle) of any user met by local user: friends, lobby and session members.
+	SteamAPI knows non-friends only after RequestUserInformation and PersonaStateChange_t, so users are resolved in batches:
+	- Entries live in an open addressing table (linear probing) keyed by 64 bits SteamID, with keys in their own
+	  array so probes touch only keys. Entries are never removed: the directory lives as long as the plugin.
+	- Each user is requested once while pending, whatever the number of batches waiting for it.
+	- Requests are rate limited per frame; each entry is completed when its PersonaStateChange_t arrives (or times out).
+	GameThread only.
+*/
+class PNETWORKING_API FUserDirectory
+{
+public:
+
+	FUserDirectory();
+	~FUserDirectory();
+
+	// Start listening to SteamAPI. Returns false if SteamAPI is not available.
+	bool Initialize();
+
+	// Request every user not ready yet. Callback is fired once every user is ready or failed (immediately if all ready).
+	void Resolve(TConstArrayView<uint64> SteamIDs, FOnUserDirectoryBatchResolved Callback);
+
+	// Entry of SteamID, or nullptr if never resolved.
+	const FUserDirectoryEntry* Find(const uint64 SteamID) const;
+
+	int32 Num() const;
+	int32 GetNumPendingRequests() const;
+
+	FOnUserDirectoryEntryChanged OnEntryChanged;
+
+private:
+
+	struct FBatch
+	{
+		TArray<uint64> SteamIDs;
+		int32 NumPending;
+		FOnUserDirectoryBatchResolved Callback;
+	};
+
+	typedef TQueue<uint64, EQueueMode::Mpsc> FDirtyQueue;
+
+	bool Tick(float DeltaTime);
+
+	// Slot of SteamID, or the empty slot where it should be inserted.
+	int32 FindSlot(const uint64 SteamID) const;
+
+	// Entry of SteamID, added if missing.
+	FUserDirectoryEntry& FindOrAdd(const uint64 SteamID);
+
+	// Double the table and insert every entry again.
+	void Grow();
+
+	// Read name and avatar handle from SteamAPI and notify waiting batches.
+	void Complete(const uint64 SteamID, const EUserFetchState NewState);
+
+	static uint32 HashSteamID(const uint64 SteamID);
+
+	// Open addressing table. Key 0 (invalid SteamID) marks an empty slot.
+	TArray<uint64> Keys;
+	TArray<FUserDirectoryEntry> Values;
+	int32 NumEntries;
+
+	// Users to request, in request order.
+	TArray<uint64> PendingRequests;
+
+	// Users sent to SteamAPI and not answered yet.
+	TSet<uint64> InFlightSteamIDs;
+
+	// Batches waiting each pending user.
+	TMap<uint64, TArray<TSharedRef<FBatch>, TInlineAllocator<1>>> Waiters;
+
+	// Shared with SteamAPI callbacks, so it stays valid even if directory is destroyed while they run.
+	TSharedRef<FDirtyQueue, ESPMode::ThreadSafe> DirtySteamIDs;
+
+	TWeakPtr<SteamAPICallbackManager> SteamAPIManager;
+	FDelegateHandle PersonaStateChangedHandle;
+	FTSTicker::FDelegateHandle TickHandle;
+};
@@ -7,6 +7,8 @@
 #include "CoreMinimal.h"
 #include "UserSteamData.generated.h"
 
+class UProgressiveAvatar;
+
 // Contains informations to retreive steam users data.
 // It is made in order to use it in blueprints.
 
@@ -24,7 +26,10 @@ struct FUserSteamData
     UPROPERTY(BlueprintReadOnly)
     UTexture2D* UserAvatar;
 
-    FUserSteamData() : SteamID(0), UserName(FText::FromString(TEXT("Unknown"))), UserAvatar(nullptr) { } // Pre-compiler "= default" does not work.
-    FUserSteamData(const int32 NewSteamID, const FText NewUserName, UTexture2D* NewUserAvatar) : SteamID(NewSteamID), UserName(NewUserName), UserAvatar(NewUserAvatar) { }
+    UPROPERTY(BlueprintReadOnly)
+    UProgressiveAvatar* ProgressiveAvatar; // Set only by progressive requests. UserAvatar is its texture at the time of the callback.
+
+    FUserSteamData() : SteamID(0), UserName(FText::FromString(TEXT("Unknown"))), UserAvatar(nullptr), ProgressiveAvatar(nullptr) { } // Pre-compiler "= default" does not work.
+    FUserSteamData(const int32 NewSteamID, const FText NewUserName, UTexture2D* NewUserAvatar) : SteamID(NewSteamID), UserName(NewUserName), UserAvatar(NewUserAvatar), ProgressiveAvatar(nullptr) { }
     
 };
\ No newline at end of file